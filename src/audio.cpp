@@ -20,6 +20,7 @@ GNU General Public License for more details.
 
 #include "audio.h"
 #include "spx.h"
+#include "pack.h"
 #include <SDL2/SDL.h>
 
 // the global instances of the 3 audio classes
@@ -70,20 +71,36 @@ bool CAudio::CheckOpen() {
 //				class CSound
 // --------------------------------------------------------------------
 
-bool CSound::LoadChunk (const std::string& name, const char *filename) {
-	if (Audio.IsOpen == false) return false;
-	sounds.push_back(TSound());
-	sounds.back().chunk = Mix_LoadWAV (filename);
-	if (sounds.back().chunk == NULL) return false;
-	sounds.back().channel = -1;					// default: no channel
-	sounds.back().loop_count = 0;				// default: playing once
+bool TSound::Load () {
+	if (chunk != NULL) return true;
+	if (failed) return false;
+	SDL_RWops *rw = VFileRW (path);
+	chunk = rw ? Mix_LoadWAV_RW (rw, 1) : NULL;
+	if (chunk == NULL) {
+		Message ("could not load sound", path);
+		failed = true;
+		return false;
+	}
+	Mix_VolumeChunk (chunk, volume);
+	return true;
+}
 
-	Mix_VolumeChunk (sounds.back().chunk, param.sound_volume);
+void CSound::RegisterChunk (const string& name, const string& path, const string& preload) {
+	sounds.push_back (TSound());
+	sounds.back().path = path;
+	sounds.back().preload = preload;
+	sounds.back().volume = param.sound_volume;
 	SoundIndex[name] = sounds.size()-1;
-	return true;
 }
 
-// Load all soundfiles listed in "/sounds/sounds.lst"
+bool CSound::LoadChunk (const std::string& name, const char *filename) {
+	if (Audio.IsOpen == false) return false;
+	RegisterChunk (name, filename, "");
+	return sounds.back().Load ();
+}
+
+// Registers all soundfiles listed in "/sounds/sounds.lst", nothing is
+// decoded before the sound is played or its preload group is requested
 void CSound::LoadSoundList () {
 	if (!Audio.IsOpen) {
 		Message ("cannot load music, first open Audio");
@@ -96,11 +113,18 @@ void CSound::LoadSoundList () {
 			string name = SPStrN (line, "name");
 			string soundfile = SPStrN (line, "file");
 			string path = MakePathStr (param.sounds_dir, soundfile);
-			LoadChunk (name, path.c_str());
+			RegisterChunk (name, path, SPStrN (line, "preload"));
 		}
 	}
 }
 
+void CSound::Preload (const string& group) {
+	if (!Audio.IsOpen) return;
+	for (size_t i=0; i<sounds.size(); i++)
+		if (sounds[i].preload == group)
+			sounds[i].Load ();
+}
+
 void CSound::FreeSounds () {
 	HaltAll ();
 	for (size_t i=0; i<sounds.size(); i++)
@@ -124,6 +148,7 @@ void CSound::SetVolume (size_t soundid, int volume) {
 	if (soundid >= sounds.size()) return;
 
 	volume = clamp(0, volume, MIX_MAX_VOLUME);
+	sounds[soundid].volume = volume;
 	if (sounds[soundid].chunk == NULL) return;
 	Mix_VolumeChunk (sounds[soundid].chunk, volume);
 }
@@ -136,7 +161,7 @@ void CSound::SetVolume (const string& name, int volume) {
 
 void TSound::Play(int loop) {
 	if (active == true) return;
-	if (chunk == NULL) return;
+	if (!Load ()) return;
 
 	channel = Mix_PlayChannel (-1, chunk, loop);
 	loop_count = loop;
@@ -158,8 +183,7 @@ void CSound::Play (size_t soundid, int loop, int volume) {
 	if (!Audio.IsOpen) return;
 	if (soundid >= sounds.size()) return;
 
-	volume = clamp(0, volume, MIX_MAX_VOLUME);
-	Mix_VolumeChunk (sounds[soundid].chunk, volume);
+	SetVolume (soundid, volume);
 	sounds[soundid].Play(loop);
 }
 
@@ -186,6 +210,7 @@ void CSound::Halt (const string& name) {
 }
 
 void CSound::HaltAll () {
+	num_commands = 0;
 	if (!Audio.IsOpen) return;
 	Mix_HaltChannel (-1);
 	for (size_t i=0; i<sounds.size(); i++) {
@@ -195,6 +220,65 @@ void CSound::HaltAll () {
 	}
 }
 
+// ------------------- queue ------------------------------------------
+
+// A command is dropped if it repeats the last pending command of the
+// same sound. An earlier one does not count: play, halt, play must end
+// with the sound playing, as with direct calls.
+void CSound::PushCommand (ECommand cmd, size_t soundid, int loop) {
+	if (!Audio.IsOpen) return;
+	for (size_t i=num_commands; i>0; i--) {
+		const TCommand& c = commands[i-1];
+		if (c.cmd == CMD_HALTALL || c.soundid != soundid) continue;
+		if (c.cmd == cmd && c.loop == loop) return;
+		break;
+	}
+	if (num_commands == SOUND_QUEUE_SIZE) return;
+	commands[num_commands].cmd = cmd;
+	commands[num_commands].soundid = soundid;
+	commands[num_commands].loop = loop;
+	num_commands++;
+}
+
+void CSound::Queue (size_t soundid, int loop) {
+	if (soundid >= sounds.size()) return;
+	PushCommand (CMD_PLAY, soundid, loop);
+}
+
+void CSound::Queue (const string& name, int loop) {
+	Queue (GetSoundIdx (name), loop);
+}
+
+void CSound::QueueHalt (size_t soundid) {
+	if (soundid >= sounds.size()) return;
+	PushCommand (CMD_HALT, soundid, 0);
+}
+
+void CSound::QueueHaltAll () {
+	num_commands = 0;
+	PushCommand (CMD_HALTALL, 0, 0);
+}
+
+void CSound::Update () {
+	// HaltAll clears the queue, so run from a copy of the count
+	size_t count = num_commands;
+	num_commands = 0;
+	for (size_t i=0; i<count; i++) {
+		const TCommand& c = commands[i];
+		switch (c.cmd) {
+			case CMD_PLAY:
+				Play (c.soundid, c.loop);
+				break;
+			case CMD_HALT:
+				Halt (c.soundid);
+				break;
+			case CMD_HALTALL:
+				HaltAll ();
+				break;
+		}
+	}
+}
+
 // --------------------------------------------------------------------
 //				class CMusic
 // --------------------------------------------------------------------
@@ -206,23 +290,53 @@ void Hook () {
 
 CMusic::CMusic () {
 	curr_music = 0;
+	curr_theme = -1;
 	curr_volume = 10;
 	loop_count = 0;
 //	Mix_HookMusicFinished (Hook);
 }
 
+// registers the piece, the file is opened when it is played
 bool CMusic::LoadPiece (const string& name, const char *filename) {
-	if (!Audio.IsOpen) return -1;
-	Mix_Music* m = Mix_LoadMUS (filename);
-	if (m == NULL) {
-		Message ("could not load music", filename);
-		return false;
-	}
+	if (!Audio.IsOpen) return false;
+	TPiece piece;
+	piece.path = filename;
+	piece.music = NULL;
+	piece.failed = false;
 	MusicIndex[name] = musics.size();
-	musics.push_back(m);
+	musics.push_back(piece);
 	return true;
 }
 
+Mix_Music* CMusic::Open (size_t musid) {
+	if (musid >= musics.size()) return NULL;
+	TPiece& piece = musics[musid];
+	if (piece.music == NULL && !piece.failed) {
+		SDL_RWops *rw = VFileRW (piece.path);
+		piece.music = rw ? Mix_LoadMUS_RW (rw, 1) : NULL;
+		if (piece.music == NULL) {
+			Message ("could not load music", piece.path);
+			piece.failed = true;
+		}
+	}
+	return piece.music;
+}
+
+// closes the files of all pieces except keep and the current theme
+void CMusic::CloseUnused (size_t keep) {
+	for (size_t i=0; i<musics.size(); i++) {
+		if (musics[i].music == NULL || i == keep) continue;
+		if (curr_theme < themes.size()) {
+			bool used = false;
+			for (int s=0; s<SITUATION_COUNT; s++)
+				if (themes[curr_theme].situation[s] == i) used = true;
+			if (used) continue;
+		}
+		Mix_FreeMusic (musics[i].music);
+		musics[i].music = NULL;
+	}
+}
+
 void CMusic::LoadMusicList () {
 	if (!Audio.IsOpen) {
 		Message ("cannot load music, first open audio");
@@ -253,11 +367,11 @@ void CMusic::LoadMusicList () {
 			string name = SPStrN (line, "name");
 			ThemesIndex[name] = i;
 			string item = SPStrN (line, "race", "race_1");
-			themes[i].situation[0] = musics[MusicIndex[item]];
+			themes[i].situation[0] = GetMusicIdx (item);
 			item = SPStrN (line, "wonrace", "wonrace_1");
-			themes[i].situation[1] = musics[MusicIndex[item]];
+			themes[i].situation[1] = GetMusicIdx (item);
 			item = SPStrN (line, "lostrace", "lostrace_1");
-			themes[i].situation[2] = musics[MusicIndex[item]];
+			themes[i].situation[2] = GetMusicIdx (item);
 		}
 	} else Message ("could not load racing_themes.lst");
 }
@@ -265,8 +379,8 @@ void CMusic::LoadMusicList () {
 void CMusic::FreeMusics () {
 	Halt ();
 	for (size_t i=0; i<musics.size(); i++)
-		if (musics[i] != NULL)
-			Mix_FreeMusic (musics[i]);
+		if (musics[i].music != NULL)
+			Mix_FreeMusic (musics[i].music);
 	musics.clear();
 	MusicIndex.clear();
 
@@ -274,6 +388,7 @@ void CMusic::FreeMusics () {
 	ThemesIndex.clear();
 
 	curr_music = 0;
+	curr_theme = -1;
 	curr_volume = 10;
 }
 
@@ -309,13 +424,15 @@ void CMusic::Update () {
 	Mix_VolumeMusic (curr_volume);
 }
 
-bool CMusic::Play (Mix_Music* music, int loop, int volume) {
+bool CMusic::PlayPiece (size_t musid, int loop, int volume) {
+	Mix_Music *music = Open (musid);
 	if (!music)
 		return false;
 
 	int vol = clamp(0, volume, MIX_MAX_VOLUME);
 	if (music != curr_music) {
 		Halt ();
+		CloseUnused (musid);
 		Mix_PlayMusic (music, loop);
 		curr_music = music;
 		loop_count = loop;
@@ -325,10 +442,7 @@ bool CMusic::Play (Mix_Music* music, int loop, int volume) {
 }
 
 bool CMusic::Play (size_t musid, int loop) {
-	if (!Audio.IsOpen) return false;
-	if (musid >= musics.size()) return false;
-	Mix_Music *music = musics[musid];
-	return Play(music, loop, curr_volume);
+	return Play (musid, loop, curr_volume);
 }
 
 bool CMusic::Play (const string& name, int loop) {
@@ -338,19 +452,24 @@ bool CMusic::Play (const string& name, int loop) {
 bool CMusic::Play (size_t musid, int loop, int volume) {
 	if (!Audio.IsOpen) return false;
 	if (musid >= musics.size()) return false;
-	Mix_Music *music = musics[musid];
-	return Play(music, loop, volume);
+	curr_theme = -1;
+	return PlayPiece (musid, loop, volume);
 }
 
 bool CMusic::Play (const string& name, int loop, int volume) {
 	return Play (GetMusicIdx (name), loop, volume);
 }
 
+// the other pieces of the theme are opened too, so the change to the
+// won or lost piece at the end of the race doesn't wait for the disk
 bool CMusic::PlayTheme (size_t theme, ESituation situation) {
+	if (!Audio.IsOpen) return false;
 	if (theme >= themes.size()) return false;
 	if (situation >= SITUATION_COUNT) return false;
-	Mix_Music *music = themes [theme].situation[situation];
-	return Play (music, -1, curr_volume);
+	curr_theme = theme;
+	for (int s=0; s<SITUATION_COUNT; s++)
+		Open (themes[theme].situation[s]);
+	return PlayPiece (themes[theme].situation[situation], -1, curr_volume);
 }
 
 void CMusic::Halt () {
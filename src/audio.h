@@ -41,22 +41,48 @@ public:
 //				class CSound
 // --------------------------------------------------------------------
 
+// The wav file is decoded when the sound is played the first time or
+// when its preload group is requested
 struct TSound {
 	Mix_Chunk *chunk;
+	string path;
+	string preload;		// group name, see CSound::Preload
+	int volume;
+	bool failed;
 	int channel;
 	int loop_count;
 	bool active;
 
+	TSound () : chunk(NULL), volume(MIX_MAX_VOLUME), failed(false),
+		channel(-1), loop_count(0), active(false) {}
+	bool Load ();
 	void Play (int loop);
 };
 
+#define SOUND_QUEUE_SIZE 32
+
 class CSound {
 private:
 	vector<TSound> sounds;
 	map<string, size_t> SoundIndex;
+
+	// commands of the game code, Update() runs them once per frame
+	enum ECommand { CMD_PLAY, CMD_HALT, CMD_HALTALL };
+	struct TCommand {
+		ECommand cmd;
+		size_t soundid;
+		int loop;
+	};
+	TCommand commands[SOUND_QUEUE_SIZE];
+	size_t num_commands;
+
+	void PushCommand (ECommand cmd, size_t soundid, int loop);
 public:
+	CSound () : num_commands(0) {}
 	bool LoadChunk (const std::string& name, const char *filename);
+	void RegisterChunk (const string& name, const string& path, const string& preload);
 	void LoadSoundList ();
+	void Preload (const string& group);	// decodes the sounds tagged [preload] group
 	size_t GetSoundIdx (const string& name) const;
 
 	void SetVolume (size_t soundid, int volume);
@@ -71,6 +97,15 @@ public:
 	void Halt (const string& name);
 	void HaltAll ();
 
+	// queued versions for code that runs several times per frame (physics).
+	// A command that repeats the last pending command of its sound is
+	// dropped, QueueHaltAll drops all pending commands.
+	void Queue (size_t soundid, int loop);
+	void Queue (const string& name, int loop);
+	void QueueHalt (size_t soundid);
+	void QueueHaltAll ();
+	void Update ();		// once per frame
+
 	void FreeSounds ();
 };
 
@@ -85,20 +120,31 @@ enum ESituation {
 	SITUATION_COUNT
 };
 
+// The pieces are streamed from their files. A piece is opened when it is
+// played, and only the current piece and the pieces of the current theme
+// stay open.
 class CMusic {
 private:
-	vector<Mix_Music*> musics;
+	struct TPiece {
+		string path;
+		Mix_Music* music;	// NULL while the file is closed
+		bool failed;
+	};
+	vector<TPiece> musics;
 	map<string, size_t> MusicIndex;
 
-	struct Situation {Mix_Music* situation[SITUATION_COUNT];};
+	struct Situation {size_t situation[SITUATION_COUNT];};
 	vector<Situation> themes;
 	map<string, size_t> ThemesIndex;
 
 	int loop_count;			// we need only 1 variable for all pieces
 	Mix_Music* curr_music;	// current music piece
+	size_t curr_theme;		// theme of the last PlayTheme, -1 after Play
 	int curr_volume;
 
-	bool Play (Mix_Music* music, int loop, int volume);
+	Mix_Music* Open (size_t musid);
+	void CloseUnused (size_t keep);
+	bool PlayPiece (size_t musid, int loop, int volume);
 public:
 	CMusic ();
 
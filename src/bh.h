@@ -60,7 +60,12 @@ GNU General Public License for more details.
 #define glRecti glRectf
 #define glVertex2i glVertex2f
 #define glNormal3i glNormal3f
+#ifdef USE_GLES2
+#include "gles2.h"
+#else
 #include <GLES/gl.h>
+#endif
+#include "glstats.h"
 //#include <GL/glu.h>
 void glPopAttrib();
 void glPushAttrib(int t);
@@ -73,9 +78,11 @@ void glColor4fv(const GLfloat *v);
 void glRectf(GLfloat x, GLfloat y, GLfloat w, GLfloat h);
 inline void glColor4dv(const GLfloat* c) { glColor4f(c[0], c[1], c[2], c[3]); }
 
-int glesGetGlobalVertexBufferCurPos();
-void glesSetGlobalVertexBufferCurPos(int pos);
-GLfloat* glesGetGlobalVertexBuffer(int minsize);
+// consecutive glBegin/glEnd blocks between these are drawn together,
+// the GL state may only be changed through the shadow in ogl.h there
+void glesBeginBatch();
+void glesEndBatch();
+void glesFlush();		// draws the pending blocks
 void glesCleanUp();
 #ifndef APIENTRY
 #define APIENTRY
@@ -21,6 +21,8 @@ GNU General Public License for more details.
 
 #include "common.h"
 #include "spx.h"
+#include "pack.h"
+#include <SDL2/SDL.h>
 #include <sys/stat.h>
 #include <iostream>
 #include <cerrno>
@@ -126,11 +128,22 @@ void PrintQuaternion (const TQuaternion& q) {
 
 static CSPList msg_list (100);
 
+// the startup tasks report errors from the worker threads
+static SDL_mutex *msg_mutex = SDL_CreateMutex ();
+
+class CMessageLock {
+public:
+	CMessageLock () { SDL_LockMutex (msg_mutex); }
+	~CMessageLock () { SDL_UnlockMutex (msg_mutex); }
+};
+
 void SaveMessages () {
+	CMessageLock lock;
 	msg_list.Save (param.config_dir, "messages");
 }
 
 void Message (const char *msg, const char *desc) {
+	CMessageLock lock;
 	if (*msg == 0 && *desc == 0) {
 		cout << '\n';
 		return;
@@ -143,17 +156,20 @@ void Message (const char *msg, const char *desc) {
 }
 
 void Message (const char *msg) {
+	CMessageLock lock;
 	cout << msg << '\n';
 	if (*msg != 0)
 		msg_list.Add (msg);
 }
 
 void Message (const string& a, const string& b) {
+	CMessageLock lock;
 	cout << a << ' ' << b << endl;
 	msg_list.Add (a + b);
 }
 
 void Message (const string& msg) {
+	CMessageLock lock;
 	cout << msg << endl;
 	msg_list.Add (msg);
 }
@@ -163,6 +179,9 @@ void Message (const string& msg) {
 // --------------------------------------------------------------------
 
 bool FileExists (const char *filename) {
+	const unsigned char *data;
+	size_t size;
+	if (Pack.Find (filename, data, size)) return true;
 	struct stat stat_info;
 	if (stat (filename, &stat_info) != 0) {
 		if (errno != ENOENT) Message ("couldn't stat ", filename);
@@ -180,6 +199,7 @@ bool FileExists (const string& dir, const string& filename) {
 
 #ifndef OS_WIN32_MSC
 bool DirExists (const char *dirname) {
+	if (Pack.HasDir (dirname)) return true;
 	DIR *xdir;
 	if ((xdir = opendir (dirname)) == 0)
 		return ((errno != ENOENT) && (errno != ENOTDIR));
@@ -188,6 +208,7 @@ bool DirExists (const char *dirname) {
 }
 #else
 bool DirExists (const char *dirname) {
+	if (Pack.HasDir (dirname)) return true;
 	DWORD typ = GetFileAttributesA(dirname);
 	if (typ == INVALID_FILE_ATTRIBUTES)
 		return false; // Doesn't exist
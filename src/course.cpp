@@ -43,6 +43,7 @@ CCourse::CCourse () {
 	nmls = NULL;
 	vnc_array = NULL;
 	mirrored = false;
+	selected = string::npos;
 
 	curr_course = NULL;
 }
@@ -419,21 +420,23 @@ void CCourse::LoadItemList () {
 
 	CollArr.clear();
 	NocollArr.clear();
+	CTextureBatch batch;
+	CSPLine line;
 	for (size_t i=0; i<list.Count(); i++) {
-		const string& line = list.Line(i);
-		int x = SPIntN (line, "x", 0);
-		int z = SPIntN (line, "z", 0);
-		ETR_DOUBLE height = SPFloatN (line, "height", 1);
-		ETR_DOUBLE diam = SPFloatN (line, "diam", 1);
+		line.Parse (list.Line(i));
+		int x = line.Int ("x", 0);
+		int z = line.Int ("z", 0);
+		ETR_DOUBLE height = line.Float ("height", 1);
+		ETR_DOUBLE diam = line.Float ("diam", 1);
 		ETR_DOUBLE xx = (nx - x) / (ETR_DOUBLE)(nx - 1.0) * curr_course->size.x;
 		ETR_DOUBLE zz = -(ny - z) / (ETR_DOUBLE)(ny - 1.0) * curr_course->size.y;
 
-		string name = SPStrN (line, "name");
+		string name = line.Str ("name");
 		size_t type = ObjectIndex[name];
 		if (ObjTypes[type].texture == NULL && ObjTypes[type].drawable) {
 			string terrpath = param.obj_dir + SEP + ObjTypes[type].textureFile;
 			ObjTypes[type].texture = new TTexture();
-			ObjTypes[type].texture->LoadMipmap(terrpath, false);
+			batch.Add(ObjTypes[type].texture, terrpath, true, false);
 		}
 
 		if (ObjTypes[type].collidable)
@@ -443,6 +446,7 @@ void CCourse::LoadItemList () {
 	}
 	std::sort(CollArr.begin(),CollArr.end(),sortCollidable);
 	std::sort(NocollArr.begin(),NocollArr.end(),sortItem);
+	batch.Finish();
 }
 
 // --------------------	LoadObjectMap ---------------------------------
@@ -665,6 +669,7 @@ bool CCourse::LoadTerrainMap () {
 	} catch (...) {
 		Message ("Allocation failed in LoadTerrainMap");
 	}
+	CTextureBatch batch;
 	int pad = 0;
 	for (int y=0; y<ny; y++) {
 		for (int x=0; x<nx; x++) {
@@ -674,11 +679,12 @@ bool CCourse::LoadTerrainMap () {
 			terrain[arridx] = terr;
 			if (TerrList[terr].texture == NULL) {
 				TerrList[terr].texture = new TTexture();
-				TerrList[terr].texture->LoadMipmap(param.terr_dir, TerrList[terr].textureFile, true);
+				batch.Add(TerrList[terr].texture, param.terr_dir, TerrList[terr].textureFile, true, true);
 			}
 		}
 		pad += (nx * terrImage.depth) % 4;
 	}
+	batch.Finish();
 	return true;
 }
 
@@ -702,24 +708,17 @@ bool CCourse::LoadCourseList () {
 		CourseList[i].name = SPStrN (line1, "name", "noname");
 		CourseList[i].dir = SPStrN (line1, "dir", "nodir");
 
-		string desc = SPStrN (line1, "desc");
-		FT.AutoSizeN (2);
-		vector<string> desclist = FT.MakeLineList (desc.c_str(), 300 * Winsys.scale - 16.0);
-		size_t cnt = min<size_t>(desclist.size(), MAX_DESCRIPTION_LINES);
-		CourseList[i].num_lines = cnt;
-		for (size_t ll=0; ll<cnt; ll++) {
-			CourseList[i].desc[ll] = desclist[ll];
-		}
+		CourseList[i].description = SPStrN (line1, "desc");
+		CourseList[i].num_lines = 0;
+		CourseList[i].desc_ready = false;
+		CourseList[i].preview = NULL;
 
 		string coursepath = param.common_course_dir + SEP + CourseList[i].dir;
 		if (DirExists (coursepath.c_str())) {
-			// preview
+			// preview, loaded by SelectCourse
 			string previewfile = coursepath + SEP "preview.png";
 			CourseList[i].preview = new TTexture();
-			if (!CourseList[i].preview->LoadMipmap(previewfile, false)) {
-				Message ("couldn't load previewfile");
-//				texid = Tex.TexID (NO_PREVIEW);
-			}
+			CourseList[i].preview->SetSource(previewfile, true, false);
 
 			// params
 			string paramfile = coursepath + SEP "course.dim";
@@ -753,6 +752,44 @@ void CCourse::FreeCourseList () {
 		delete CourseList[i].preview;
 	}
 	CourseList.clear();
+	selected = string::npos;
+}
+
+// number of courses on either side of the selection whose previews are
+// kept loaded
+#define PREVIEW_CACHE_RANGE 2
+
+void CCourse::LayoutDescription (TCourse& course) {
+	FT.AutoSizeN (2);
+	vector<string> desclist = FT.MakeLineList (course.description.c_str(), 300 * Winsys.scale - 16.0);
+	size_t cnt = min<size_t>(desclist.size(), MAX_DESCRIPTION_LINES);
+	course.num_lines = cnt;
+	for (size_t ll=0; ll<cnt; ll++) {
+		course.desc[ll] = desclist[ll];
+	}
+	course.desc_ready = true;
+}
+
+void CCourse::SelectCourse (size_t idx) {
+	if (idx >= CourseList.size() || idx == selected) return;
+
+	size_t first = idx > PREVIEW_CACHE_RANGE ? idx - PREVIEW_CACHE_RANGE : 0;
+	size_t last = min(idx + PREVIEW_CACHE_RANGE, CourseList.size() - 1);
+
+	// release the previews that left the range
+	if (selected != string::npos) {
+		size_t oldfirst = selected > PREVIEW_CACHE_RANGE ? selected - PREVIEW_CACHE_RANGE : 0;
+		size_t oldlast = min(selected + PREVIEW_CACHE_RANGE, CourseList.size() - 1);
+		for (size_t i=oldfirst; i<=oldlast; i++)
+			if ((i < first || i > last) && CourseList[i].preview)
+				CourseList[i].preview->Unload();
+	}
+	selected = idx;
+
+	for (size_t i=first; i<=last; i++) {
+		if (!CourseList[i].desc_ready) LayoutDescription (CourseList[i]);
+		if (CourseList[i].preview) CourseList[i].preview->Preload();
+	}
 }
 
 //  ===================================================================
@@ -103,8 +103,10 @@ struct TCourse {
 	string name;
 	string dir;
 	string author;
-	string desc[MAX_DESCRIPTION_LINES];
+	string description;
+	string desc[MAX_DESCRIPTION_LINES];	// laid out by CCourse::SelectCourse
 	size_t num_lines;
+	bool desc_ready;
 	TTexture* preview;
 	TVector2d size;
 	TVector2d play_size;
@@ -124,6 +126,7 @@ private:
 	map<string, size_t> CourseIndex;
 	map<string, size_t> ObjectIndex;
 	string		CourseDir;
+	size_t		selected;	// course around which the previews are loaded
 
 	int			nx;
 	int			ny;
@@ -142,6 +145,7 @@ private:
 	int			GetTerrain (unsigned char pixel[]) const;
 
 	void		MirrorCourseData ();
+	void		LayoutDescription (TCourse& course);
 public:
 	CCourse ();
 	~CCourse();
@@ -163,6 +167,9 @@ public:
 	size_t GetCourseIdx(const TCourse* course) const;
 	bool LoadCourseList ();
 	void FreeCourseList ();
+	// prepares the preview and description of the selected course and
+	// its neighbours in the course menu, the other previews are released
+	void SelectCourse (size_t idx);
 	bool LoadCourse(TCourse* course);
 	bool LoadTerrainTypes ();
 	bool LoadObjectTypes ();
@@ -28,6 +28,7 @@ GNU General Public License for more details.
 #include "env.h"
 #include "game_ctrl.h"
 #include "physics.h"
+#include "render_queue.h"
 
 #define TEX_SCALE 6
 static const bool clip_course = true;
@@ -57,14 +58,58 @@ void RenderCourse () {
 // --------------------------------------------------------------------
 //				DrawTrees
 // --------------------------------------------------------------------
+
+static bool ClipObject (const CControl *ctrl, const TVector3d& pt) {
+	if (!clip_course) return false;
+	if (ctrl->viewpos.z - pt.z > param.forward_clip_distance) return true;
+	if (pt.z - ctrl->viewpos.z > param.backward_clip_distance) return true;
+	return false;
+}
+
+// the texture must be bound and the global VBO set up
+static void DrawTree (const TCollidable& tree) {
+	glPushMatrix();
+	glTranslate(tree.pt);
+	if (param.perf_level > 1) glRotatef (1, 0, 1, 0);
+
+	float treeRadius = tree.diam / 2.0f;
+	glNormal3f(0, 0, treeRadius);
+	glScalef(treeRadius,tree.height,treeRadius);
+
+	RenderGlobalVBO(GL_TRIANGLES,12,TREE);
+
+	glPopMatrix();
+}
+
+static void DrawItem (const TItem& item, const CControl *ctrl) {
+	glPushMatrix();
+	glTranslate(item.pt);
+	ETR_DOUBLE itemRadius = item.diam / 2;
+	ETR_DOUBLE itemHeight = item.height;
+
+	TVector3d normal;
+	if (item.type->use_normal) {
+		normal = item.type->normal;
+	} else {
+		normal = ctrl->viewpos - item.pt;
+		normal.Norm();
+	}
+	glNormal3(normal);
+	normal.y = 0.0;
+	normal.Norm();
+	glScalef(normal.z*itemRadius,itemHeight,normal.x*itemRadius);
+
+	RenderGlobalVBO(GL_QUADS,4,ITEM);
+
+	glPopMatrix();
+}
+
 void DrawTrees() {
 	size_t			tree_type = -1;
 	TObjectType*	object_types = &Course.ObjTypes[0];
 	const CControl*	ctrl = g_game.player->ctrl;
 
 	ScopedRenderMode rm(TREES);
-	ETR_DOUBLE fwd_clip_limit = param.forward_clip_distance;
-	ETR_DOUBLE bwd_clip_limit = param.backward_clip_distance;
 
 	glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
 	set_material (colWhite, colBlack, 1.0);
@@ -78,27 +123,13 @@ void DrawTrees() {
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	BindGlobalVBO();
 	for (size_t i = 0; i< numTrees; i++) {
-		if (clip_course) {
-			if (ctrl->viewpos.z - treeLocs[i].pt.z > fwd_clip_limit) continue;
-			if (treeLocs[i].pt.z - ctrl->viewpos.z > bwd_clip_limit) continue;
-		}
+		if (ClipObject (ctrl, treeLocs[i].pt)) continue;
 
 		if (treeLocs[i].tree_type != tree_type) {
 			tree_type = treeLocs[i].tree_type;
 			object_types[tree_type].texture->Bind();
 		}
-
-		glPushMatrix();
-		glTranslate(treeLocs[i].pt);
-		if (param.perf_level > 1) glRotatef (1, 0, 1, 0);
-
-		float treeRadius = treeLocs[i].diam / 2.0f;
-		glNormal3f(0, 0, treeRadius);
-		glScalef(treeRadius,treeLocs[i].height,treeRadius);
-
-		RenderGlobalVBO(GL_TRIANGLES,12,TREE);
-
-		glPopMatrix();
+		DrawTree (treeLocs[i]);
 	}
 
 
@@ -109,38 +140,79 @@ void DrawTrees() {
 
 	for (size_t i = 0; i< numItems; i++) {
 		if (itemLocs[i].collectable == 0 || itemLocs[i].type->drawable == false) continue;
-		if (clip_course) {
-			if (ctrl->viewpos.z - itemLocs[i].pt.z > fwd_clip_limit) continue;
-			if (itemLocs[i].pt.z - ctrl->viewpos.z > bwd_clip_limit) continue;
-		}
+		if (ClipObject (ctrl, itemLocs[i].pt)) continue;
 
 		if (itemLocs[i].type != item_type) {
 			item_type = itemLocs[i].type;
 			item_type->texture->Bind();
 		}
+		DrawItem (itemLocs[i], ctrl);
+	}
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	UnbindVBO();
+}
 
-		glPushMatrix();
-		glTranslate(itemLocs[i].pt);
-		ETR_DOUBLE itemRadius = itemLocs[i].diam / 2;
-		ETR_DOUBLE itemHeight = itemLocs[i].height;
-
-		TVector3d normal;
-		if (item_type->use_normal) {
-			normal = item_type->normal;
-		} else {
-			normal = ctrl->viewpos - itemLocs[i].pt;
-			normal.Norm();
-		}
-		glNormal3(normal);
-		normal.y = 0.0;
-		normal.Norm();
-		glScalef(normal.z*itemRadius,itemHeight,normal.x*itemRadius);
+// --------------------------------------------------------------------
+//				render queue
+// --------------------------------------------------------------------
 
-		RenderGlobalVBO(GL_QUADS,4,ITEM);
+static void DrawCourseItem (const TRenderItem *items, size_t count) {
+	RenderCourse ();
+}
 
-		glPopMatrix();
-	}
+void SubmitCourse () {
+	RenderQueue.Submit (RL_TERRAIN, COURSE, NULL, DrawCourseItem);
+}
+
+// one call per tree texture, the trees come front to back
+static void DrawTreeItems (const TRenderItem *items, size_t count) {
+	glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	set_material (colWhite, colBlack, 1.0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	BindGlobalVBO();
+	for (size_t i=0; i<count; i++)
+		DrawTree (*static_cast<const TCollidable*>(items[i].data));
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	UnbindVBO();
+}
+
+static void DrawItemItems (const TRenderItem *items, size_t count) {
+	const CControl* ctrl = g_game.player->ctrl;
+	glTexEnvf (GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	set_material (colWhite, colBlack, 1.0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	BindGlobalVBO();
+	for (size_t i=0; i<count; i++)
+		DrawItem (*static_cast<const TItem*>(items[i].data), ctrl);
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	glDisableClientState(GL_VERTEX_ARRAY);
 	UnbindVBO();
 }
+
+static float ViewDistance (const CControl *ctrl, const TVector3d& pt) {
+	TVector3d d = pt - ctrl->viewpos;
+	return d.x * d.x + d.y * d.y + d.z * d.z;
+}
+
+void SubmitTrees () {
+	const CControl*	ctrl = g_game.player->ctrl;
+
+	for (size_t i = 0; i< Course.CollArr.size(); i++) {
+		const TCollidable& tree = Course.CollArr[i];
+		if (ClipObject (ctrl, tree.pt)) continue;
+		RenderQueue.Submit (RL_OPAQUE, TREES, Course.ObjTypes[tree.tree_type].texture,
+			DrawTreeItems, &tree, ViewDistance (ctrl, tree.pt));
+	}
+
+	for (size_t i = 0; i< Course.NocollArr.size(); i++) {
+		const TItem& item = Course.NocollArr[i];
+		if (item.collectable == 0 || item.type->drawable == false) continue;
+		if (ClipObject (ctrl, item.pt)) continue;
+		RenderQueue.Submit (RL_OPAQUE, TREES, item.type->texture,
+			DrawItemItems, &item, ViewDistance (ctrl, item.pt));
+	}
+}
@@ -25,4 +25,8 @@ void setup_course_tex_gen ();
 void RenderCourse ();
 void DrawTrees ();
 
+// the same for the render queue of the race
+void SubmitCourse ();
+void SubmitTrees ();
+
 #endif
@@ -69,6 +69,7 @@ void CCredits::DrawCreditsText () {
 	if (moving) y_offset += g_game.time_step * 30;
 
 
+	FT.BeginBatch ();
 	for (list<TCredits>::const_iterator i = CreditList.begin(); i != CreditList.end(); ++i) {
 		offs = h - 100 - y_offset + i->offs;
 		if (offs > h || offs < 0.0) // Draw only visible lines
@@ -81,9 +82,10 @@ void CCredits::DrawCreditsText () {
 		FT.AutoSizeN (i->size);
 		FT.DrawString (-1, (int)offs, i->text);
 	}
+	FT.EndBatch ();
 
 
-	glDisable (GL_TEXTURE_2D);
+	GLDisable (GL_TEXTURE_2D);
 	glColor(colBackgr);
 	glRecti (0, 0, w, BOTT_Y);
 
@@ -106,7 +108,7 @@ void CCredits::DrawCreditsText () {
 	glVertex2i (w, h - TOP_Y - 30);
 	glEnd();
 
-	glEnable (GL_TEXTURE_2D);
+	GLEnable (GL_TEXTURE_2D);
 	if (offs < TOP_Y) y_offset = 0;
 }
 
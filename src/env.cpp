@@ -25,6 +25,7 @@ GNU General Public License for more details.
 #include "spx.h"
 #include "view.h"
 #include "course.h"
+#include "render_queue.h"
 
 // --------------------------------------------------------------------
 //					defaults
@@ -42,7 +43,7 @@ void TLight::Enable(GLenum num) const {
 	glLightfv(num, GL_AMBIENT, ambient);
 	glLightfv(num, GL_DIFFUSE, diffuse);
 	glLightfv(num, GL_SPECULAR, specular);
-	glEnable(num);
+	GLEnable(num);
 }
 
 CEnvironment Env;
@@ -89,11 +90,11 @@ void CEnvironment::SetupLight () {
 	if (lights[3].is_on)
 		lights[3].Enable(GL_LIGHT3);
 
-	glEnable(GL_LIGHTING);
+	GLEnable(GL_LIGHTING);
 }
 
 void CEnvironment::SetupFog () {
-	glEnable (GL_FOG);
+	GLEnable (GL_FOG);
 	glFogi   (GL_FOG_MODE, fog.mode);
 	glFogf   (GL_FOG_START, fog.start);
 	glFogf   (GL_FOG_END, fog.end);
@@ -109,9 +110,9 @@ void CEnvironment::SetupFog () {
 void CEnvironment::ResetLight () {
 	lights[0] = default_light;
 	for (int i=1; i<4; i++) lights[i].is_on = false;
-	glDisable (GL_LIGHT1);
-	glDisable (GL_LIGHT2);
-	glDisable (GL_LIGHT3);
+	GLDisable (GL_LIGHT1);
+	GLDisable (GL_LIGHT2);
+	GLDisable (GL_LIGHT3);
 }
 
 void CEnvironment::ResetFog () {
@@ -272,7 +273,7 @@ void CEnvironment::DrawFog () {
 	// --------------- draw the fog plane -----------------------------
 
 	ScopedRenderMode rm(FOG_PLANE);
-	glEnable (GL_FOG);
+	GLEnable (GL_FOG);
 
 #ifdef USE_GLES1
 	GLfloat vtx1[] = {
@@ -343,6 +344,23 @@ void CEnvironment::DrawFog () {
 #endif
 }
 
+static void DrawSkyboxItem (const TRenderItem *items, size_t count) {
+	Env.DrawSkybox (*static_cast<const TVector3d*>(items[0].data));
+}
+
+static void DrawFogItem (const TRenderItem *items, size_t count) {
+	Env.DrawFog ();
+}
+
+// pos must stay valid until the queue is flushed
+void CEnvironment::SubmitSkybox (const TVector3d& pos) {
+	RenderQueue.Submit (RL_SKY, SKY, NULL, DrawSkyboxItem, &pos);
+}
+
+void CEnvironment::SubmitFog () {
+	if (fog.is_on) RenderQueue.Submit (RL_SKY, FOG_PLANE, NULL, DrawFogItem);
+}
+
 
 void CEnvironment::LoadEnvironment (size_t loc, size_t light) {
 	if (loc >= locs.size()) loc = 0;
@@ -80,6 +80,8 @@ public:
 	void SetupLight ();
 	void SetupFog ();
 	void DrawFog ();
+	void SubmitSkybox (const TVector3d& pos);	// to the render queue
+	void SubmitFog ();
 	const TColor& ParticleColor () const { return fog.part_color; }
 	size_t GetEnvIdx (const string& tag) const;
 	size_t GetLightIdx (const string& tag) const;
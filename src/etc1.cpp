@@ -0,0 +1,338 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "etc1.h"
+#include <fstream>
+#include <cstring>
+
+using namespace std;
+
+// modifiers for the pixel indices 0..3, selected by the 3 bit table codeword
+static const int etc1_modifiers[8][4] = {
+	{  2,   8,  -2,   -8 },
+	{  5,  17,  -5,  -17 },
+	{  9,  29,  -9,  -29 },
+	{ 13,  42, -13,  -42 },
+	{ 18,  60, -18,  -60 },
+	{ 24,  80, -24,  -80 },
+	{ 33, 106, -33, -106 },
+	{ 47, 183, -47, -183 }
+};
+
+static inline int clamp255 (int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int Expand4 (int c) { return (c << 4) | c; }
+static inline int Expand5 (int c) { return (c << 3) | (c >> 2); }
+
+// subblock 0 or 1 of pixel x, y
+static inline int SubBlock (int x, int y, bool flip) {
+	return flip ? (y >= 2) : (x >= 2);
+}
+
+size_t ETC1DataSize (int width, int height) {
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * ETC1_BLOCK_SIZE;
+}
+
+// --------------------------------------------------------------------
+//				decoding
+// --------------------------------------------------------------------
+
+void ETC1DecodeBlock (const unsigned char *block, unsigned char *rgb) {
+	unsigned int high = (block[0] << 24) | (block[1] << 16) | (block[2] << 8) | block[3];
+	unsigned int low = (block[4] << 24) | (block[5] << 16) | (block[6] << 8) | block[7];
+	bool diff = (high >> 1) & 1;
+	bool flip = high & 1;
+
+	int base[2][3];
+	if (diff) {
+		for (int c=0; c<3; c++) {
+			int shift = 27 - c * 8;
+			int c1 = (high >> shift) & 31;
+			int d = (high >> (shift - 3)) & 7;
+			if (d >= 4) d -= 8;
+			base[0][c] = Expand5 (c1);
+			base[1][c] = Expand5 ((c1 + d) & 31);
+		}
+	} else {
+		for (int c=0; c<3; c++) {
+			int shift = 28 - c * 8;
+			base[0][c] = Expand4 ((high >> shift) & 15);
+			base[1][c] = Expand4 ((high >> (shift - 4)) & 15);
+		}
+	}
+	int table[2] = { (int)((high >> 5) & 7), (int)((high >> 2) & 7) };
+
+	for (int y=0; y<4; y++) {
+		for (int x=0; x<4; x++) {
+			int p = x * 4 + y;
+			int idx = (((low >> (16 + p)) & 1) << 1) | ((low >> p) & 1);
+			int sb = SubBlock (x, y, flip);
+			int mod = etc1_modifiers[table[sb]][idx];
+			unsigned char *pix = rgb + (y * 4 + x) * 3;
+			for (int c=0; c<3; c++)
+				pix[c] = clamp255 (base[sb][c] + mod);
+		}
+	}
+}
+
+void ETC1DecodeImage (const unsigned char *src, int width, int height, unsigned char *dest) {
+	unsigned char rgb[48];
+	for (int by=0; by<height; by+=4) {
+		for (int bx=0; bx<width; bx+=4) {
+			ETC1DecodeBlock (src, rgb);
+			src += ETC1_BLOCK_SIZE;
+			for (int y=0; y<4 && by+y<height; y++)
+				for (int x=0; x<4 && bx+x<width; x++)
+					memcpy (dest + ((by+y) * width + bx+x) * 3, rgb + (y*4 + x) * 3, 3);
+		}
+	}
+}
+
+// --------------------------------------------------------------------
+//				encoding
+// --------------------------------------------------------------------
+
+// Best table and pixel indices for one subblock with the given base color,
+// returns the squared error
+static int FitSubBlock (const unsigned char *rgb, bool flip, int sb,
+		const int *base, int *table, int *indices) {
+	int best_err = -1;
+	for (int t=0; t<8; t++) {
+		int err = 0;
+		int idx[16];
+		for (int y=0; y<4; y++) {
+			for (int x=0; x<4; x++) {
+				if (SubBlock (x, y, flip) != sb) continue;
+				const unsigned char *pix = rgb + (y * 4 + x) * 3;
+				int best_pix = -1;
+				for (int i=0; i<4; i++) {
+					int e = 0;
+					for (int c=0; c<3; c++) {
+						int d = clamp255 (base[c] + etc1_modifiers[t][i]) - pix[c];
+						e += d * d;
+					}
+					if (best_pix < 0 || e < best_pix) {
+						best_pix = e;
+						idx[x * 4 + y] = i;
+					}
+				}
+				err += best_pix;
+			}
+		}
+		if (best_err < 0 || err < best_err) {
+			best_err = err;
+			*table = t;
+			for (int p=0; p<16; p++)
+				if (SubBlock (p / 4, p % 4, flip) == sb) indices[p] = idx[p];
+		}
+	}
+	return best_err;
+}
+
+static void AverageSubBlock (const unsigned char *rgb, bool flip, int sb, float *avg) {
+	avg[0] = avg[1] = avg[2] = 0;
+	for (int y=0; y<4; y++)
+		for (int x=0; x<4; x++)
+			if (SubBlock (x, y, flip) == sb)
+				for (int c=0; c<3; c++) avg[c] += rgb[(y * 4 + x) * 3 + c];
+	for (int c=0; c<3; c++) avg[c] /= 8.f;
+}
+
+static inline int Quantize (float v, int maxval) {
+	int q = (int)(v * maxval / 255.f + 0.5f);
+	return q < 0 ? 0 : (q > maxval ? maxval : q);
+}
+
+void ETC1EncodeBlock (const unsigned char *rgb, unsigned char *block) {
+	int best_err = -1;
+	unsigned int best_high = 0;
+	unsigned int best_low = 0;
+
+	for (int f=0; f<2; f++) {
+		bool flip = f != 0;
+		float avg[2][3];
+		AverageSubBlock (rgb, flip, 0, avg[0]);
+		AverageSubBlock (rgb, flip, 1, avg[1]);
+
+		for (int diff=0; diff<2; diff++) {
+			int q[2][3];
+			int base[2][3];
+			for (int c=0; c<3; c++) {
+				if (diff) {
+					q[0][c] = Quantize (avg[0][c], 31);
+					q[1][c] = Quantize (avg[1][c], 31);
+					int d = q[1][c] - q[0][c];
+					if (d < -4) q[1][c] = q[0][c] - 4;
+					if (d > 3) q[1][c] = q[0][c] + 3;
+					base[0][c] = Expand5 (q[0][c]);
+					base[1][c] = Expand5 (q[1][c]);
+				} else {
+					q[0][c] = Quantize (avg[0][c], 15);
+					q[1][c] = Quantize (avg[1][c], 15);
+					base[0][c] = Expand4 (q[0][c]);
+					base[1][c] = Expand4 (q[1][c]);
+				}
+			}
+
+			int table[2];
+			int indices[16];
+			int err = FitSubBlock (rgb, flip, 0, base[0], &table[0], indices)
+			        + FitSubBlock (rgb, flip, 1, base[1], &table[1], indices);
+			if (best_err >= 0 && err >= best_err) continue;
+
+			unsigned int high = 0;
+			for (int c=0; c<3; c++) {
+				if (diff) {
+					int shift = 27 - c * 8;
+					high |= q[0][c] << shift;
+					high |= ((q[1][c] - q[0][c]) & 7) << (shift - 3);
+				} else {
+					int shift = 28 - c * 8;
+					high |= q[0][c] << shift;
+					high |= q[1][c] << (shift - 4);
+				}
+			}
+			high |= table[0] << 5;
+			high |= table[1] << 2;
+			high |= diff << 1;
+			high |= f;
+
+			unsigned int low = 0;
+			for (int p=0; p<16; p++) {
+				low |= (indices[p] >> 1) << (16 + p);
+				low |= (indices[p] & 1) << p;
+			}
+
+			best_err = err;
+			best_high = high;
+			best_low = low;
+		}
+	}
+
+	for (int i=0; i<4; i++) {
+		block[i] = (best_high >> (24 - i * 8)) & 255;
+		block[i + 4] = (best_low >> (24 - i * 8)) & 255;
+	}
+}
+
+void ETC1EncodeImage (const unsigned char *src, int width, int height,
+		int depth, int pitch, unsigned char *dest) {
+	unsigned char rgb[48];
+	for (int by=0; by<height; by+=4) {
+		for (int bx=0; bx<width; bx+=4) {
+			// blocks at the border repeat the last row / column
+			for (int y=0; y<4; y++) {
+				int sy = by + y < height ? by + y : height - 1;
+				for (int x=0; x<4; x++) {
+					int sx = bx + x < width ? bx + x : width - 1;
+					memcpy (rgb + (y * 4 + x) * 3, src + sy * pitch + sx * depth, 3);
+				}
+			}
+			ETC1EncodeBlock (rgb, dest);
+			dest += ETC1_BLOCK_SIZE;
+		}
+	}
+}
+
+// --------------------------------------------------------------------
+//				struct TETC1Image
+// --------------------------------------------------------------------
+
+#define PKM_HEADER_SIZE 16
+
+int TETC1Image::LevelWidth (size_t level) const {
+	int w = width >> level;
+	return w > 0 ? w : 1;
+}
+
+int TETC1Image::LevelHeight (size_t level) const {
+	int h = height >> level;
+	return h > 0 ? h : 1;
+}
+
+static inline int ReadBE16 (const unsigned char *p) {
+	return (p[0] << 8) | p[1];
+}
+
+static inline void WriteBE16 (unsigned char *p, int v) {
+	p[0] = (v >> 8) & 255;
+	p[1] = v & 255;
+}
+
+bool TETC1Image::Load (const string& filepath) {
+	ifstream file (filepath.c_str(), ios_base::in | ios_base::binary);
+	if (!file) return false;
+	file.seekg (0, ios_base::end);
+	streamoff len = file.tellg();
+	if (len <= 0) return false;
+	vector<unsigned char> contents ((size_t)len);
+	file.seekg (0, ios_base::beg);
+	if (!file.read (reinterpret_cast<char*>(&contents[0]), len))
+		return false;
+	return Load (&contents[0], contents.size());
+}
+
+bool TETC1Image::Load (const unsigned char *data, size_t size) {
+	levels.clear();
+	const unsigned char *end = data + size;
+	while (end - data >= PKM_HEADER_SIZE) {
+		const unsigned char *header = data;
+		if (memcmp (header, "PKM 10", 6) != 0 || ReadBE16 (header + 6) != 0)
+			return false;
+		int w = ReadBE16 (header + 12);
+		int h = ReadBE16 (header + 14);
+		if (levels.empty()) {
+			width = w;
+			height = h;
+		} else if (w != LevelWidth (levels.size()) || h != LevelHeight (levels.size())) {
+			return false;
+		}
+		data += PKM_HEADER_SIZE;
+
+		size_t levelsize = ETC1DataSize (w, h);
+		if ((size_t)(end - data) < levelsize)
+			return false;
+		levels.push_back (vector<unsigned char>(data, data + levelsize));
+		data += levelsize;
+	}
+	return !levels.empty();
+}
+
+bool TETC1Image::Save (const string& filepath) const {
+	ofstream file (filepath.c_str(), ios_base::out | ios_base::binary);
+	if (!file) return false;
+
+	for (size_t i=0; i<levels.size(); i++) {
+		int w = LevelWidth (i);
+		int h = LevelHeight (i);
+		unsigned char header[PKM_HEADER_SIZE];
+		memcpy (header, "PKM 10", 6);
+		WriteBE16 (header + 6, 0);	// ETC1_RGB_NO_MIPMAPS
+		WriteBE16 (header + 8, (w + 3) & ~3);
+		WriteBE16 (header + 10, (h + 3) & ~3);
+		WriteBE16 (header + 12, w);
+		WriteBE16 (header + 14, h);
+		file.write (reinterpret_cast<const char*>(header), PKM_HEADER_SIZE);
+		file.write (reinterpret_cast<const char*>(&levels[i][0]), levels[i].size());
+	}
+	return file.good();
+}
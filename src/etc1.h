@@ -0,0 +1,69 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef ETC1_H
+#define ETC1_H
+
+// ETC1 block codec and .pkm file handling. This module has no GL or SDL
+// dependencies, it is shared by the game and the offline converter
+// (tools/etc1conv.cpp).
+
+#include <string>
+#include <vector>
+
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+
+#define ETC1_BLOCK_SIZE 8
+
+// size in bytes of the compressed data for a w x h image
+size_t ETC1DataSize (int width, int height);
+
+// block = 4x4 pixels, rgb in rows of 3 bytes, 8 bytes compressed
+void ETC1EncodeBlock (const unsigned char *rgb, unsigned char *block);
+void ETC1DecodeBlock (const unsigned char *block, unsigned char *rgb);
+
+// whole images, depth 3 or 4 (alpha is ignored), rows of pitch bytes.
+// The decoder always writes rgb rows of width * 3 bytes.
+void ETC1EncodeImage (const unsigned char *src, int width, int height,
+	int depth, int pitch, unsigned char *dest);
+void ETC1DecodeImage (const unsigned char *src, int width, int height,
+	unsigned char *dest);
+
+// --------------------------------------------------------------------
+//				struct TETC1Image
+// --------------------------------------------------------------------
+
+// A .pkm file holds one PKM record (16 byte header + data) per mipmap
+// level, starting with the full size level. Files written by etc1conv
+// always contain the complete chain down to 1x1.
+
+struct TETC1Image {
+	int width;
+	int height;
+	std::vector<std::vector<unsigned char> > levels;
+
+	TETC1Image () : width(0), height(0) {}
+	int LevelWidth (size_t level) const;
+	int LevelHeight (size_t level) const;
+
+	bool Load (const std::string& filepath);
+	bool Load (const unsigned char *data, size_t size);	// contents of a .pkm file
+	bool Save (const std::string& filepath) const;
+};
+
+#endif
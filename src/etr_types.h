@@ -90,6 +90,7 @@ struct TGameData {
 	int wind_id;
 	size_t theme_id;
 	TRace* race; // Only valid if not in practice mode
+	string render_course;	// course dir given with --render
 
 	// race results (better in player.ctrl ?)
 	ETR_DOUBLE time;			// reached time
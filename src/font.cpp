@@ -25,9 +25,13 @@ GNU General Public License for more details.
 #include "spx.h"
 #include "ogl.h"
 #include "winsys.h"
+#include "pack.h"
 
 #define USE_UNICODE 1
 
+// the caches are simply dropped when they get this big
+#define MAX_LAYOUT_CACHE 2048
+
 // --------------------------------------------------------------------
 // First some common function used for textboxes and called by
 // CFont::MakeLineList. This bundle of functions generates
@@ -93,6 +97,7 @@ CFont::CFont () {
 	curr_size   = 20;	// default size: 20 px
 	curr_fact   = 0;
 	curr_font   = 0;
+	batch_depth = 0;
 }
 
 CFont::~CFont() {
@@ -100,17 +105,34 @@ CFont::~CFont() {
 }
 
 void CFont::Clear () {
+#ifdef USE_GLES1
+	FTTextBatch::Flush ();
+#endif
 	for(size_t i = 0; i < fonts.size(); i++)
 	{
-		map<float,FTFont*>::iterator it = fonts[i]->fonts.begin();
+		map<unsigned int,FTFont*>::iterator it = fonts[i]->fonts.begin();
 		while (it != fonts[i]->fonts.end())
 		{
 			delete it->second;
 			it++;
 		}
+		delete fonts[i];
 	}
 	fonts.clear();
 	fontindex.clear();
+	ClearLayoutCache();
+}
+
+void CFont::ClearLayoutCache () {
+	size_cache.clear();
+	line_cache.clear();
+}
+
+bool CFont::TLayoutKey::operator< (const TLayoutKey& k) const {
+	if (font != k.font) return font < k.font;
+	if (size != k.size) return size < k.size;
+	if (width != k.width) return width < k.width;
+	return text < k.text;
 }
 
 // --------------------------------------------------------------------
@@ -147,30 +169,24 @@ wstring CFont::UnicodeStr (const char *s) {
 // --------------------------------------------------------------------
 
 int CFont::LoadFont (const string& name, const char *path,float size) {
-	fontinfo* newfont = NULL;
-	if (fontindex.count(name) > 0)
-		newfont = fonts[GetFontIdx(name)];
-	else
+	if (fontindex.count(name) == 0)
 	{
-		newfont = new fontinfo;
+		CVFile file;
+		if (!file.Open (path) || file.Size() == 0) {
+			Message ("Failed to open font", path);
+			return -1;
+		}
+		fontinfo* newfont = new fontinfo;
 		newfont->fontpath=path;
 		newfont->fontname=name;
+		newfont->data.assign (file.Data(), file.Data() + file.Size());
 		fonts.push_back(newfont);
 		fontindex[name] = fonts.size()-1;
 	}
-	int pos = GetFontIdx(name);
-#ifdef USE_GLES1
-	newfont->fonts[size] = new FTGLTextureFont (path);
-#else
-	newfont->fonts[size] = new FTGLPixmapFont (path);
-#endif
-	if (newfont->fonts[size]->Error()) {
-		Message ("Failed to open font");
+	int pos = (int)GetFontIdx(name);
+	float scale;
+	if (GetFont(pos, size, scale) == NULL)
 		return -1;
-	}
-	newfont->fonts[size]->FaceSize (size);
-	newfont->fonts[size]->CharMap (ft_encoding_unicode);
-
 	return pos;
 }
 
@@ -196,11 +212,43 @@ bool CFont::LoadFontlist () {
 	}
 	return true;
 }
-FTFont* CFont::GetFont(const size_t findex,const float size)
+FTFont* CFont::GetFont(const size_t findex,const float size, float &scale)
 {
-	if (fonts[findex]->fonts.count(size) == 0)
-		LoadFont(fonts[findex]->fontname, fonts[findex]->fontpath.c_str(),size);
-	return fonts[findex]->fonts[size];
+#ifdef USE_GLES1
+	// the next step of the ladder at or above the size, so the glyphs are
+	// only ever scaled down
+	float step = 8;
+	unsigned int cachesize = 8;
+	while (cachesize < size) {
+		step *= 1.189207f;	// 2^(1/4)
+		cachesize = (unsigned int)ceil (step - 0.01f);
+	}
+	scale = size / cachesize;
+#else
+	// pixmap fonts can't be scaled
+	unsigned int cachesize = (unsigned int)size;
+	scale = 1;
+#endif
+
+	fontinfo* info = fonts[findex];
+	map<unsigned int,FTFont*>::iterator it = info->fonts.find(cachesize);
+	if (it != info->fonts.end())
+		return it->second;
+
+#ifdef USE_GLES1
+	FTFont* font = new FTGLTextureFont (&info->data[0], info->data.size());
+#else
+	FTFont* font = new FTGLPixmapFont (&info->data[0], info->data.size());
+#endif
+	if (font->Error()) {
+		Message ("Failed to open font", info->fontpath);
+		delete font;
+		return NULL;
+	}
+	font->FaceSize (cachesize);
+	font->CharMap (ft_encoding_unicode);
+	info->fonts[cachesize] = font;
+	return font;
 }
 size_t CFont::GetFontIdx (const string &name) const {
 	return fontindex.at(name);
@@ -245,34 +293,58 @@ int CFont::AutoDistanceN (int rel_val) {
 
 // -------------------- draw (x, y, text) -----------------------------
 
+#ifdef USE_GLES1
+static inline GLubyte ColorByte (ETR_DOUBLE c) {
+	return (GLubyte)(clamp (0.0, c, 1.0) * 255.0 + 0.5);
+}
+#endif
+
+void CFont::BeginBatch () {
+	batch_depth++;
+}
+
+void CFont::EndBatch () {
+	if (batch_depth > 0 && --batch_depth == 0) {
+#ifdef USE_GLES1
+		FTTextBatch::Flush ();
+#endif
+	}
+}
+
 template<typename T>
 void CFont::DrawText(float x, float y, const T* text, size_t font, float size) {
 	if (font >= fonts.size()) return;
 
-	glPushMatrix();
-	FTFont* cf = GetFont(font,size);
-	glColor(curr_col);
-
+	float scale;
+	FTFont* cf = GetFont(font,size,scale);
+	if (cf == NULL) return;
 	float left;
 	if (x >= 0) left = x;
 	else left = (Winsys.resolution.width - GetTextWidth(text)) / 2;
 	if (left < 0) left = 0;
 
 #ifdef USE_GLES1
+	// the glyphs go into the text batch at their final position
 	if (forientation == OR_TOP) {
-		glTranslatef (left, Winsys.resolution.height - curr_size - y, 0.0f);
+		FTTextBatch::Origin (left, Winsys.resolution.height - curr_size - y, scale);
 	} else {
-		glTranslatef (left, y, 0.0f);
+		FTTextBatch::Origin (left, y, scale);
 	}
+	FTTextBatch::Color (ColorByte (curr_col.r), ColorByte (curr_col.g),
+		ColorByte (curr_col.b), ColorByte (curr_col.a));
+	cf->Render (text);
+	if (batch_depth == 0) FTTextBatch::Flush ();
 #else
+	glPushMatrix();
+	glColor(curr_col);
 	if (forientation == OR_TOP) {
 		glRasterPos2i ((int)left, (int)(Winsys.resolution.height - curr_size - y));
 	} else {
 		glRasterPos2i ((int)left, (int)y);
 	}
-#endif
 	cf->Render (text);
 	glPopMatrix();
+#endif
 }
 template void CFont::DrawText<char>(float x, float y, const char* text, size_t font, float size); // instanciate
 template void CFont::DrawText<wchar_t>(float x, float y, const wchar_t* text, size_t font, float size); // instanciate
@@ -327,11 +399,24 @@ void CFont::DrawString (
 void CFont::GetTextSize (const wchar_t *text, float &x, float &y, size_t font, float size) {
 	if (font >= fonts.size()) { x = 0; y = 0; return; }
 
+	TLayoutKey key (font, size, 0, text);
+	map<TLayoutKey, pair<float, float> >::const_iterator it = size_cache.find (key);
+	if (it != size_cache.end()) {
+		x = it->second.first;
+		y = it->second.second;
+		return;
+	}
+
 	float llx, lly, llz, urx, ury, urz;
-	FTFont* cf = GetFont(font,size);
+	float scale;
+	FTFont* cf = GetFont(font,size,scale);
+	if (cf == NULL) { x = 0; y = 0; return; }
 	cf->BBox (text, llx, lly, llz, urx, ury, urz);
-	x = urx - llx;
-	y = ury - lly;
+	x = (urx - llx) * scale;
+	y = (ury - lly) * scale;
+
+	if (size_cache.size() >= MAX_LAYOUT_CACHE) size_cache.clear();
+	size_cache[key] = make_pair (x, y);
 }
 
 void CFont::GetTextSize (const char *text, float &x, float &y, size_t font, float size) {
@@ -341,10 +426,12 @@ void CFont::GetTextSize (const char *text, float &x, float &y, size_t font, floa
 	if (font >= fonts.size()) { x = 0; y = 0; return; }
 
 	float llx, lly, llz, urx, ury, urz;
-	FTFont* cf = GetFont(font,size);
+	float scale;
+	FTFont* cf = GetFont(font,size,scale);
+	if (cf == NULL) { x = 0; y = 0; return; }
 	cf->BBox (text, llx, lly, llz, urx, ury, urz);
-	x = urx - llx;
-	y = ury - lly;
+	x = (urx - llx) * scale;
+	y = (ury - lly) * scale;
 #endif
 }
 
@@ -392,6 +479,11 @@ float CFont::CenterX (const char *text) {
 }
 
 vector<string> CFont::MakeLineList (const char *source, float width) {
+	TLayoutKey key (curr_font, curr_size, width, UnicodeStr (source));
+	map<TLayoutKey, vector<string> >::const_iterator it = line_cache.find (key);
+	if (it != line_cache.end())
+		return it->second;
+
 	vector<string> wordlist;
 	MakeWordList(wordlist, source);
 	vector<string> linelist;
@@ -399,5 +491,7 @@ vector<string> CFont::MakeLineList (const char *source, float width) {
 	for (size_t last = 0; last < wordlist.size();)
 		last = MakeLine(last, wordlist, linelist, width)+1;
 
+	if (line_cache.size() >= MAX_LAYOUT_CACHE) line_cache.clear();
+	line_cache[key] = linelist;
 	return linelist;
 }
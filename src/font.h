@@ -31,10 +31,15 @@ GNU General Public License for more details.
 
 class FTFont;
 
+// The font file is read once and shared by the glyph caches of all sizes.
+// With GLES the caches are made for a few fixed sizes only (steps of
+// 2^(1/4)) and scaled down when drawn, so the number of caches stays the
+// same however many sizes the menus ask for.
 struct fontinfo {
 	string fontpath;
 	string fontname;
-	map<float,FTFont*> fonts;
+	vector<unsigned char> data;
+	map<unsigned int,FTFont*> fonts;	// by rasterized size
 };
 
 class CFont {
@@ -43,22 +48,38 @@ private:
 	map<string, size_t> fontindex;
 	Orientation forientation;
 
+	// measured sizes and wrapped line lists, the menus ask for the same
+	// strings every frame
+	struct TLayoutKey {
+		size_t font;
+		float size;
+		float width;	// line width, only for MakeLineList
+		wstring text;
+		TLayoutKey (size_t f, float s, float w, const wstring& t)
+			: font(f), size(s), width(w), text(t) {}
+		bool operator< (const TLayoutKey& k) const;
+	};
+	map<TLayoutKey, pair<float, float> > size_cache;
+	map<TLayoutKey, vector<string> > line_cache;
+
 	int    curr_font;
 	TColor curr_col;
 	float  curr_size;
 	float  curr_fact;		// the length factor
+	int    batch_depth;
 
 	static wstring UnicodeStr(const char* s);
 	template<typename T>
 	void DrawText(float x, float y, const T* text, size_t font, float size);
 	void GetTextSize(const char *text, float &x, float &y, size_t font, float size);
 	void GetTextSize(const wchar_t *text, float &x, float &y, size_t font, float size);
-	FTFont* GetFont(const size_t findex,const float size);
+	FTFont* GetFont(const size_t findex,const float size, float &scale);
 public:
 	CFont ();
 	~CFont ();
 
 	void Clear ();
+	void ClearLayoutCache ();	// after font or resolution changes
 	int  LoadFont(const string& name, const string& dir, const string& filename,float size);
 	int  LoadFont(const string& name, const char *path, float size);
 	bool LoadFontlist ();
@@ -87,6 +108,13 @@ public:
 	void DrawString (float x, float y, const string &s, const string &fontname, float size);
 	void DrawString (float x, float y, const wstring &s, const string &fontname, float size);
 
+	// the text drawn between BeginBatch and EndBatch is drawn at once by
+	// EndBatch, one call per glyph texture. Nothing else may be drawn and
+	// the matrix must not change in between. Without a batch every string
+	// is drawn right away.
+	void BeginBatch ();
+	void EndBatch ();
+
 	// metrics
 	void  GetTextSize  (const char *text, float &x, float &y);
 	void  GetTextSize  (const char *text, float &x, float &y, const string &fontname, float size);
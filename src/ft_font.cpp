@@ -21,6 +21,9 @@ module.
 #endif
 
 #include "ft_font.h"
+#include "textures.h"
+#include "ogl.h"
+#include <cstring>
 
 // --------------------------------------------------------------------
 //					FTFont
@@ -513,8 +516,6 @@ FTPoint FTGlyphContainer::Render (const unsigned int characterCode,
 //					FTTextureGlyph
 // --------------------------------------------------------------------
 
-GLint FTTextureGlyph::activeTextureID = 0;
-
 FTTextureGlyph::FTTextureGlyph (FT_GlyphSlot glyph, int id, int xOffset,
 								int yOffset, GLsizei width, GLsizei height)
 	: FTGlyph (glyph), destWidth(0), destHeight(0), glTextureID(id) {
@@ -533,7 +534,7 @@ FTTextureGlyph::FTTextureGlyph (FT_GlyphSlot glyph, int id, int xOffset,
 #endif
 		glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
 		
-		glBindTexture (GL_TEXTURE_2D, glTextureID);
+		BindTexture (glTextureID);
 		glTexSubImage2D (GL_TEXTURE_2D, 0, xOffset, yOffset,
 						 destWidth, destHeight, GL_ALPHA, GL_UNSIGNED_BYTE, bitmap.buffer);
 		
@@ -554,37 +555,116 @@ FTTextureGlyph::FTTextureGlyph (FT_GlyphSlot glyph, int id, int xOffset,
 FTTextureGlyph::~FTTextureGlyph() {}
 
 const FTPoint& FTTextureGlyph::Render (const FTPoint& pen) {
-	if (activeTextureID != glTextureID) {
-		glBindTexture (GL_TEXTURE_2D, (GLuint)glTextureID);
-		activeTextureID = glTextureID;
+	FTTextBatch::Move (pen);
+	if (destWidth && destHeight) {
+		FTTextBatch::AddQuad (glTextureID,
+			pos.X(), pos.Y() - destHeight, destWidth + pos.X(), pos.Y(),
+			uv[0].X(), uv[1].Y(), uv[1].X(), uv[0].Y());
 	}
-
-	glTranslatef (pen.X(),  pen.Y(), 0.0f);
-
-	const GLfloat tex[] = {
-		uv[0].X(), uv[0].Y(),
-		uv[0].X(), uv[1].Y(),
-		uv[1].X(), uv[1].Y(),
-		uv[1].X(), uv[0].Y(),
-	};
-	const GLfloat vtx[] = {
-		pos.X(), pos.Y(),
-		pos.X(), pos.Y() - destHeight,
-		destWidth + pos.X(), pos.Y() - destHeight,
-		destWidth + pos.X(), pos.Y()
-	};
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-
-	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glTexCoordPointer(2, GL_FLOAT, 0, tex);
-	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-	glDisableClientState(GL_VERTEX_ARRAY);
 	return advance;
 }
 
+// --------------------------------------------------------------------
+//					FTTextBatch
+// --------------------------------------------------------------------
+
+std::vector<FTTextBatch::Page> FTTextBatch::pages;
+size_t FTTextBatch::currentPage = 0;
+size_t FTTextBatch::numVertices = 0;
+float FTTextBatch::penX = 0;
+float FTTextBatch::penY = 0;
+float FTTextBatch::penScale = 1;
+GLubyte FTTextBatch::color[4] = {0, 0, 0, 255};
+
+void FTTextBatch::Origin (float x, float y, float scale) {
+	penX = x;
+	penY = y;
+	penScale = scale;
+}
+
+void FTTextBatch::Color (GLubyte r, GLubyte g, GLubyte b, GLubyte a) {
+	color[0] = r;
+	color[1] = g;
+	color[2] = b;
+	color[3] = a;
+}
+
+// the pen offsets of a string add up, like the translations they replace
+void FTTextBatch::Move (const FTPoint& pen) {
+	penX += pen.X() * penScale;
+	penY += pen.Y() * penScale;
+}
+
+void FTTextBatch::AddQuad (GLuint texture, float x0, float y0, float x1, float y1,
+		float u0, float v0, float u1, float v1) {
+	if (currentPage >= pages.size() || pages[currentPage].texture != texture) {
+		currentPage = 0;
+		while (currentPage < pages.size() && pages[currentPage].texture != texture)
+			currentPage++;
+		if (currentPage == pages.size()) {
+			pages.push_back (Page());
+			pages.back().texture = texture;
+		}
+	}
+
+	Vertex corner[4];
+	corner[0].x = corner[1].x = penX + x0 * penScale;
+	corner[2].x = corner[3].x = penX + x1 * penScale;
+	corner[0].y = corner[3].y = penY + y0 * penScale;
+	corner[1].y = corner[2].y = penY + y1 * penScale;
+	corner[0].u = corner[1].u = u0;
+	corner[2].u = corner[3].u = u1;
+	corner[0].v = corner[3].v = v0;
+	corner[1].v = corner[2].v = v1;
+	for (int i=0; i<4; i++)
+		memcpy (corner[i].col, color, 4);
+
+	// two triangles, so quads of a page can be drawn in one call
+	std::vector<Vertex>& vertices = pages[currentPage].vertices;
+	static const int order[6] = {0, 1, 2, 0, 2, 3};
+	for (int i=0; i<6; i++)
+		vertices.push_back (corner[order[i]]);
+	numVertices += 6;
+}
+
+void FTTextBatch::Flush () {
+	if (numVertices == 0) return;
+
+#ifdef USE_GLES1
+	glPushAttrib (GL_COLOR_BUFFER_BIT);
+#else
+	glPushAttrib (GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+#endif
+	GLEnable (GL_BLEND);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnableClientState (GL_VERTEX_ARRAY);
+	glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState (GL_COLOR_ARRAY);
+
+	for (size_t i=0; i<pages.size(); i++) {
+		std::vector<Vertex>& vertices = pages[i].vertices;
+		if (vertices.empty()) continue;
+		BindTexture (pages[i].texture);
+		glVertexPointer (2, GL_FLOAT, sizeof(Vertex), &vertices[0].x);
+		glTexCoordPointer (2, GL_FLOAT, sizeof(Vertex), &vertices[0].u);
+		glColorPointer (4, GL_UNSIGNED_BYTE, sizeof(Vertex), vertices[0].col);
+		glDrawArrays (GL_TRIANGLES, 0, (GLsizei)vertices.size());
+		vertices.clear();
+	}
+
+	glDisableClientState (GL_COLOR_ARRAY);
+	glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState (GL_VERTEX_ARRAY);
+	glPopAttrib();
+#ifndef USE_GLES1
+	InvalidateGLState ();
+#endif
+
+	// the current color is undefined after drawing with a color array
+	glColor4ub (color[0], color[1], color[2], color[3]);
+	numVertices = 0;
+}
+
 inline GLuint NextPowerOf2 (GLuint in) {
 	in -= 1;
 
@@ -629,7 +709,7 @@ FTGLTextureFont::FTGLTextureFont (const unsigned char *pBufferBytes, size_t buff
 }
 
 FTGLTextureFont::~FTGLTextureFont() {
-	glDeleteTextures ((GLsizei)textureIDList.size(), (const GLuint*)&textureIDList[0]);
+	DeleteTextures ((GLsizei)textureIDList.size(), (const GLuint*)&textureIDList[0]);
 }
 
 FTGlyph* FTGLTextureFont::MakeGlyph (unsigned int glyphIndex) {
@@ -687,7 +767,7 @@ GLuint FTGLTextureFont::CreateTexture() {
 	GLuint textID;
 	glGenTextures (1, (GLuint*)&textID);
 
-	glBindTexture (GL_TEXTURE_2D, textID);
+	BindTexture (textID);
 #ifdef USE_GLES1
 	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -707,39 +787,13 @@ GLuint FTGLTextureFont::CreateTexture() {
 
 bool FTGLTextureFont::FaceSize (const unsigned int size, const unsigned int res) {
 	if (!textureIDList.empty()) {
-		glDeleteTextures ((GLsizei)textureIDList.size(), (const GLuint*)&textureIDList[0]);
+		DeleteTextures ((GLsizei)textureIDList.size(), (const GLuint*)&textureIDList[0]);
 		textureIDList.clear();
 		remGlyphs = numGlyphs = face.GlyphCount();
 	}
 	return FTFont::FaceSize (size, res);
 }
 
-void FTGLTextureFont::Render (const char* string) {
-#ifdef USE_GLES1
-	glPushAttrib (GL_COLOR_BUFFER_BIT);
-#else
-	glPushAttrib (GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
-#endif
-	glEnable(GL_BLEND);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // GL_ONE
-	FTTextureGlyph::ResetActiveTexture();
-	FTFont::Render (string);
-	glPopAttrib();
-}
-
-void FTGLTextureFont::Render (const wchar_t* string) {
-#ifdef USE_GLES1
-	glPushAttrib (GL_COLOR_BUFFER_BIT);
-#else
-	glPushAttrib (GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
-#endif
-	glEnable(GL_BLEND);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA); // GL_ONE
-	FTTextureGlyph::ResetActiveTexture();
-	FTFont::Render (string);
-	glPopAttrib();
-}
-
 // --------------------------------------------------------------------
 //					FTCharmap (character map)
 // --------------------------------------------------------------------
@@ -867,10 +921,10 @@ void FTGLPixmapFont::Render( const char* string) {
 	glPushAttrib( GL_ENABLE_BIT | GL_PIXEL_MODE_BIT | GL_COLOR_BUFFER_BIT);
 	glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT);
 	
-	glEnable(GL_BLEND);
-	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable(GL_BLEND);
+	GLBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
-	glDisable( GL_TEXTURE_2D);
+	GLDisable( GL_TEXTURE_2D);
 	
 	GLfloat ftglColour[4];
 	glGetFloatv( GL_CURRENT_RASTER_COLOR, ftglColour);
@@ -884,6 +938,7 @@ void FTGLPixmapFont::Render( const char* string) {
 	
 	glPopClientAttrib();
 	glPopAttrib();
+	InvalidateGLState();
 }
 
 
@@ -891,10 +946,10 @@ void FTGLPixmapFont::Render( const wchar_t* string) {
 	glPushAttrib( GL_ENABLE_BIT | GL_PIXEL_MODE_BIT | GL_COLOR_BUFFER_BIT);
 	glPushClientAttrib( GL_CLIENT_PIXEL_STORE_BIT);
 	
-	glEnable(GL_BLEND);
-	glBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable(GL_BLEND);
+	GLBlendFunc( GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
-	glDisable( GL_TEXTURE_2D);
+	GLDisable( GL_TEXTURE_2D);
 	
 	GLfloat ftglColour[4];
 	glGetFloatv( GL_CURRENT_RASTER_COLOR, ftglColour);
@@ -908,6 +963,7 @@ void FTGLPixmapFont::Render( const wchar_t* string) {
 	
 	glPopClientAttrib();
 	glPopAttrib();
+	InvalidateGLState();
 }
 #endif
 
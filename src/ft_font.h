@@ -23,6 +23,7 @@ module.
 
 #include <ft2build.h>
 #include FT_OUTLINE_H
+#include <vector>
 
 typedef ETR_DOUBLE FTGL_DOUBLE;
 
@@ -554,14 +555,45 @@ class FTGL_EXPORT FTTextureGlyph : public FTGlyph {
 			GLsizei width, GLsizei height);
         virtual ~FTTextureGlyph();
         virtual const FTPoint& Render(const FTPoint& pen);
-        static void ResetActiveTexture() { activeTextureID = 0;}
     private:
         int destWidth;
         int destHeight;
         FTPoint pos;
         FTPoint uv[2];
         int glTextureID;
-        static GLint activeTextureID;
+};
+
+// --------------------------------------------------------------------
+//			FTTextBatch
+// --------------------------------------------------------------------
+
+// Texture glyphs are not drawn one by one. Render() appends their quads,
+// already moved to the text position, to a vertex stream per glyph
+// texture, and Flush() draws every stream with a single call.
+class FTGL_EXPORT FTTextBatch {
+    public:
+        // position and scale of the next string, and its color
+        static void Origin(float x, float y, float scale);
+        static void Color(GLubyte r, GLubyte g, GLubyte b, GLubyte a);
+        static void Move(const FTPoint& pen);
+        static void AddQuad(GLuint texture, float x0, float y0, float x1, float y1,
+			float u0, float v0, float u1, float v1);
+        static void Flush();
+    private:
+        struct Vertex {
+            GLfloat x, y;
+            GLfloat u, v;
+            GLubyte col[4];
+        };
+        struct Page {
+            GLuint texture;
+            std::vector<Vertex> vertices;
+        };
+        static std::vector<Page> pages;	// kept, so the buffers are reused
+        static size_t currentPage;
+        static size_t numVertices;
+        static float penX, penY, penScale;
+        static GLubyte color[4];
 };
 
 // --------------------------------------------------------------------
@@ -616,8 +648,6 @@ class FTGL_EXPORT FTGLTextureFont : public FTFont {
         FTGLTextureFont(const unsigned char *pBufferBytes, size_t bufferSizeInBytes);
         virtual ~FTGLTextureFont();
         virtual bool FaceSize(const unsigned int size, const unsigned int res = 72);
-        virtual void Render(const char* string);
-        virtual void Render(const wchar_t* string);
     private:
         inline virtual FTGlyph* MakeGlyph(unsigned int glyphIndex);
         inline void CalculateTextureSize();
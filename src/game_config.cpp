@@ -87,6 +87,12 @@ void LoadConfigFile () {
 		param.full_skybox = SPBoolN (line, "full_skybox", false);
 		param.audio_freq = SPIntN (line, "audio_freq", 22050);
 		param.audio_buffer_size = SPIntN (line, "audio_buffer_size", 512);
+		param.texture_budget = SPIntN (line, "texture_budget", 64);
+		// percent of the screen resolution, a minimum above the start
+		// value is lowered to it
+		param.render_scale = clamp (10, SPIntN (line, "render_scale", 100), 100);
+		param.min_render_scale = clamp (10, SPIntN (line, "min_render_scale", 50), param.render_scale);
+		param.dynamic_resolution = SPBoolN (line, "dynamic_resolution", true);
 		param.use_quad_scale = SPBoolN (line, "use_quad_scale", false);
 
 		param.menu_music = SPStrN (line, "menu_music", "start_1");
@@ -118,6 +124,10 @@ void SetConfigDefaults () {
 	param.course_detail_level = 75;
 	param.audio_freq = 22050;
 	param.audio_buffer_size = 512;
+	param.texture_budget = 64;
+	param.render_scale = 100;
+	param.min_render_scale = 50;
+	param.dynamic_resolution = true;
 
 	param.use_papercut_font = 1;
 	param.ice_cursor = true;
@@ -278,6 +288,21 @@ void SaveConfigFile () {
 	AddIntItem (liste, "audio_buffer_size", param.audio_buffer_size);
 	liste.AddLine();
 
+	AddComment (liste, "Texture memory budget in MB");
+	AddComment (liste, "Least recently used textures are unloaded above this size");
+	AddComment (liste, "and reloaded when they are needed again. 0 = unlimited");
+	AddIntItem (liste, "texture_budget", param.texture_budget);
+	liste.AddLine();
+
+	AddComment (liste, "Resolution of the 3D scene in % of the screen [10...100]");
+	AddComment (liste, "The hud is always drawn at the screen resolution. With");
+	AddComment (liste, "dynamic_resolution the scene is scaled between min_render_scale");
+	AddComment (liste, "and 100 to keep the framerate, render_scale is the start value.");
+	AddIntItem (liste, "render_scale", param.render_scale);
+	AddIntItem (liste, "min_render_scale", param.min_render_scale);
+	AddIntItem (liste, "dynamic_resolution", param.dynamic_resolution);
+	liste.AddLine();
+
 	AddComment (liste, "Select the music:");
 	AddComment (liste, "(the racing music is defined by a music theme)");
 	AddItem (liste, "menu_music", param.menu_music);
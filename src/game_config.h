@@ -63,6 +63,10 @@ struct TParam {
 	int		course_detail_level; // only for quadtree
 	int		audio_freq;
 	int		audio_buffer_size;
+	int		texture_budget;			// MB, 0 = unlimited
+	int		render_scale;			// % of the screen size for the 3D scene
+	int		min_render_scale;
+	bool	dynamic_resolution;		// scale the 3D scene with the frame time
 
 	int		use_papercut_font;
 	bool	ice_cursor;
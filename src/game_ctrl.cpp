@@ -335,10 +335,7 @@ void CCharacter::LoadCharacterList () {
 
 			TCharacter* ch = &CharList[i];
 			ch->preview = new TTexture();
-			if (!ch->preview->LoadMipmap(previewfile, false)) {
-				Message ("could not load previewfile of character");
-//				texid = Tex.TexID (NO_PREVIEW);
-			}
+			ch->preview->SetSource(previewfile, true, false);
 
 
 			ch->shape = new CCharShape;
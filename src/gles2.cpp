@@ -0,0 +1,997 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#define GLES2_NO_REDIRECT
+#define GLSTATS_NO_REDIRECT
+#include "bh.h"
+#include "spx.h"
+
+#ifdef USE_GLES2
+
+#include <cstring>
+#include <cmath>
+#include <map>
+
+// Client arrays and the current color and normal map directly onto vertex
+// attributes, glVertexAttribPointer is called at once so a bound vertex
+// buffer is picked up like in GLES1. Everything else is kept here and
+// handed to the shaders as uniforms when a draw call needs it. There is
+// one program per combination of the enabled features (see ProgramKey),
+// compiled when it is used for the first time.
+//
+// Not emulated because the game doesn't use them: texture matrix, spot
+// lights, light attenuation, two sided lighting, flat shading and
+// GL_NORMALIZE (normals are always normalized).
+
+enum {
+	ATTR_POSITION,
+	ATTR_NORMAL,
+	ATTR_COLOR,
+	ATTR_TEXCOORD
+};
+
+#define MAX_LIGHTS 8
+#define MATRIX_STACK_DEPTH 32
+
+struct TMatrixStack {
+	GLfloat m[MATRIX_STACK_DEPTH][16];
+	int top;
+};
+
+struct TLightState {
+	bool on;
+	GLfloat ambient[4];
+	GLfloat diffuse[4];
+	GLfloat specular[4];
+	GLfloat position[4];	// eye coordinates
+};
+
+struct TTextureInfo {
+	bool alpha;				// GL_ALPHA format, sampled as (0, 0, 0, a)
+	bool generate_mipmap;
+};
+
+static struct {
+	TMatrixStack stacks[3];	// modelview, projection, texture
+	int mode;
+
+	bool texture_2d;
+	bool lighting;
+	bool fog;
+	bool alpha_test;
+	bool color_material;
+	bool normalize;
+	bool line_smooth;
+	bool multisample;
+
+	GLfloat color[4];
+	TLightState lights[MAX_LIGHTS];
+	GLfloat scene_ambient[4];
+	GLfloat mat_ambient[4];
+	GLfloat mat_diffuse[4];
+	GLfloat mat_specular[4];
+	GLfloat mat_emission[4];
+	GLfloat mat_shininess;
+
+	GLenum fog_mode;
+	GLfloat fog_start, fog_end, fog_density;
+	GLfloat fog_color[4];
+
+	GLenum alpha_func;
+	GLfloat alpha_ref;
+	GLenum texenv;
+
+	GLuint texture;
+	map<GLuint, TTextureInfo> textures;
+
+	// bumped on every change, the programs remember what they have
+	unsigned int matrix_serial;
+	unsigned int light_serial;
+	unsigned int material_serial;
+	unsigned int fog_serial;
+	unsigned int alpha_serial;
+} ff;
+
+static bool ff_initialized = false;
+
+static const GLfloat identity[16] = {
+	1, 0, 0, 0,
+	0, 1, 0, 0,
+	0, 0, 1, 0,
+	0, 0, 0, 1
+};
+
+static void Set4 (GLfloat *dst, GLfloat a, GLfloat b, GLfloat c, GLfloat d) {
+	dst[0] = a;
+	dst[1] = b;
+	dst[2] = c;
+	dst[3] = d;
+}
+
+// the GLES1 defaults
+static void InitState () {
+	if (ff_initialized) return;
+	ff_initialized = true;
+	for (int i=0; i<3; i++) {
+		ff.stacks[i].top = 0;
+		memcpy (ff.stacks[i].m[0], identity, sizeof(identity));
+	}
+	ff.mode = 0;
+	ff.texture_2d = false;
+	ff.lighting = false;
+	ff.fog = false;
+	ff.alpha_test = false;
+	ff.color_material = false;
+	ff.normalize = false;
+	ff.line_smooth = false;
+	ff.multisample = true;
+
+	Set4 (ff.color, 1, 1, 1, 1);
+	for (int i=0; i<MAX_LIGHTS; i++) {
+		TLightState& l = ff.lights[i];
+		l.on = false;
+		Set4 (l.ambient, 0, 0, 0, 1);
+		if (i == 0) {
+			Set4 (l.diffuse, 1, 1, 1, 1);
+			Set4 (l.specular, 1, 1, 1, 1);
+		} else {
+			Set4 (l.diffuse, 0, 0, 0, 1);
+			Set4 (l.specular, 0, 0, 0, 1);
+		}
+		Set4 (l.position, 0, 0, 1, 0);
+	}
+	Set4 (ff.scene_ambient, 0.2f, 0.2f, 0.2f, 1);
+	Set4 (ff.mat_ambient, 0.2f, 0.2f, 0.2f, 1);
+	Set4 (ff.mat_diffuse, 0.8f, 0.8f, 0.8f, 1);
+	Set4 (ff.mat_specular, 0, 0, 0, 1);
+	Set4 (ff.mat_emission, 0, 0, 0, 1);
+	ff.mat_shininess = 0;
+
+	ff.fog_mode = GL_EXP;
+	ff.fog_start = 0;
+	ff.fog_end = 1;
+	ff.fog_density = 1;
+	Set4 (ff.fog_color, 0, 0, 0, 0);
+
+	ff.alpha_func = GL_ALWAYS;
+	ff.alpha_ref = 0;
+	ff.texenv = GL_MODULATE;
+	ff.texture = 0;
+
+	ff.matrix_serial = 1;
+	ff.light_serial = 1;
+	ff.material_serial = 1;
+	ff.fog_serial = 1;
+	ff.alpha_serial = 1;
+
+	glVertexAttrib4f (ATTR_COLOR, 1, 1, 1, 1);
+	glVertexAttrib4f (ATTR_NORMAL, 0, 0, 1, 0);
+	glVertexAttrib4f (ATTR_TEXCOORD, 0, 0, 0, 1);
+}
+
+// --------------------------------------------------------------------
+//				matrices
+// --------------------------------------------------------------------
+
+// column major like GL, r = a * b
+static void MultMatrix (GLfloat *r, const GLfloat *a, const GLfloat *b) {
+	GLfloat tmp[16];
+	for (int c=0; c<4; c++)
+		for (int row=0; row<4; row++)
+			tmp[c*4 + row] = a[row] * b[c*4] + a[4 + row] * b[c*4 + 1]
+			               + a[8 + row] * b[c*4 + 2] + a[12 + row] * b[c*4 + 3];
+	memcpy (r, tmp, sizeof(tmp));
+}
+
+static GLfloat *CurrentMatrix () {
+	TMatrixStack& s = ff.stacks[ff.mode];
+	return s.m[s.top];
+}
+
+static void MultCurrent (const GLfloat *m) {
+	GLfloat *cur = CurrentMatrix ();
+	MultMatrix (cur, cur, m);
+	ff.matrix_serial++;
+}
+
+void glMatrixMode (GLenum mode) {
+	InitState ();
+	switch (mode) {
+		case GL_MODELVIEW: ff.mode = 0; break;
+		case GL_PROJECTION: ff.mode = 1; break;
+		case GL_TEXTURE: ff.mode = 2; break;
+	}
+}
+
+void glLoadIdentity () {
+	InitState ();
+	memcpy (CurrentMatrix (), identity, sizeof(identity));
+	ff.matrix_serial++;
+}
+
+void glLoadMatrixf (const GLfloat *m) {
+	InitState ();
+	memcpy (CurrentMatrix (), m, 16 * sizeof(GLfloat));
+	ff.matrix_serial++;
+}
+
+void glMultMatrixf (const GLfloat *m) {
+	InitState ();
+	MultCurrent (m);
+}
+
+void glPushMatrix () {
+	InitState ();
+	TMatrixStack& s = ff.stacks[ff.mode];
+	if (s.top + 1 >= MATRIX_STACK_DEPTH) return;
+	memcpy (s.m[s.top + 1], s.m[s.top], sizeof(s.m[0]));
+	s.top++;
+}
+
+void glPopMatrix () {
+	InitState ();
+	TMatrixStack& s = ff.stacks[ff.mode];
+	if (s.top == 0) return;
+	s.top--;
+	ff.matrix_serial++;
+}
+
+void glTranslatef (GLfloat x, GLfloat y, GLfloat z) {
+	InitState ();
+	GLfloat m[16];
+	memcpy (m, identity, sizeof(m));
+	m[12] = x;
+	m[13] = y;
+	m[14] = z;
+	MultCurrent (m);
+}
+
+void glRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+	InitState ();
+	GLfloat len = sqrtf (x*x + y*y + z*z);
+	if (len == 0) return;
+	x /= len;
+	y /= len;
+	z /= len;
+	GLfloat a = angle * (GLfloat)M_PI / 180.f;
+	GLfloat c = cosf (a);
+	GLfloat s = sinf (a);
+	GLfloat t = 1 - c;
+	GLfloat m[16] = {
+		x*x*t + c,   y*x*t + z*s, x*z*t - y*s, 0,
+		x*y*t - z*s, y*y*t + c,   y*z*t + x*s, 0,
+		x*z*t + y*s, y*z*t - x*s, z*z*t + c,   0,
+		0,           0,           0,           1
+	};
+	MultCurrent (m);
+}
+
+void glScalef (GLfloat x, GLfloat y, GLfloat z) {
+	InitState ();
+	GLfloat m[16];
+	memcpy (m, identity, sizeof(m));
+	m[0] = x;
+	m[5] = y;
+	m[10] = z;
+	MultCurrent (m);
+}
+
+void glOrthof (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
+	InitState ();
+	GLfloat m[16];
+	memcpy (m, identity, sizeof(m));
+	m[0] = 2 / (r - l);
+	m[5] = 2 / (t - b);
+	m[10] = -2 / (f - n);
+	m[12] = -(r + l) / (r - l);
+	m[13] = -(t + b) / (t - b);
+	m[14] = -(f + n) / (f - n);
+	MultCurrent (m);
+}
+
+void glFrustumf (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) {
+	InitState ();
+	GLfloat m[16];
+	memset (m, 0, sizeof(m));
+	m[0] = 2 * n / (r - l);
+	m[5] = 2 * n / (t - b);
+	m[8] = (r + l) / (r - l);
+	m[9] = (t + b) / (t - b);
+	m[10] = -(f + n) / (f - n);
+	m[11] = -1;
+	m[14] = -2 * f * n / (f - n);
+	MultCurrent (m);
+}
+
+// inverse transpose of the upper 3x3 part, column major
+static void NormalMatrix (const GLfloat *m, GLfloat *n) {
+	GLfloat a = m[0], b = m[4], c = m[8];
+	GLfloat d = m[1], e = m[5], f = m[9];
+	GLfloat g = m[2], h = m[6], i = m[10];
+	GLfloat A = e*i - f*h, B = f*g - d*i, C = d*h - e*g;
+	GLfloat det = a*A + b*B + c*C;
+	if (det == 0) det = 1;
+	GLfloat inv = 1 / det;
+	// the transpose of the inverse is the cofactor matrix / det,
+	// stored column major again
+	n[0] = A * inv;
+	n[3] = B * inv;
+	n[6] = C * inv;
+	n[1] = (c*h - b*i) * inv;
+	n[4] = (a*i - c*g) * inv;
+	n[7] = (b*g - a*h) * inv;
+	n[2] = (b*f - c*e) * inv;
+	n[5] = (c*d - a*f) * inv;
+	n[8] = (a*e - b*d) * inv;
+}
+
+// --------------------------------------------------------------------
+//				current values and client arrays
+// --------------------------------------------------------------------
+
+void glColor4f (GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+	InitState ();
+	Set4 (ff.color, r, g, b, a);
+	glVertexAttrib4f (ATTR_COLOR, r, g, b, a);
+	if (ff.color_material) {
+		memcpy (ff.mat_ambient, ff.color, sizeof(ff.color));
+		memcpy (ff.mat_diffuse, ff.color, sizeof(ff.color));
+		ff.material_serial++;
+	}
+}
+
+void glColor4ub (GLubyte r, GLubyte g, GLubyte b, GLubyte a) {
+	glColor4f (r / 255.f, g / 255.f, b / 255.f, a / 255.f);
+}
+
+void glNormal3f (GLfloat x, GLfloat y, GLfloat z) {
+	glVertexAttrib4f (ATTR_NORMAL, x, y, z, 0);
+}
+
+static GLuint ArrayAttrib (GLenum array) {
+	switch (array) {
+		case GL_VERTEX_ARRAY: return ATTR_POSITION;
+		case GL_NORMAL_ARRAY: return ATTR_NORMAL;
+		case GL_COLOR_ARRAY: return ATTR_COLOR;
+		case GL_TEXTURE_COORD_ARRAY: return ATTR_TEXCOORD;
+	}
+	return (GLuint)-1;
+}
+
+void glEnableClientState (GLenum array) {
+	GLuint attr = ArrayAttrib (array);
+	if (attr != (GLuint)-1) glEnableVertexAttribArray (attr);
+}
+
+void glDisableClientState (GLenum array) {
+	GLuint attr = ArrayAttrib (array);
+	if (attr == (GLuint)-1) return;
+	glDisableVertexAttribArray (attr);
+	// like in GLES1 the current color is used again, not the last one
+	// of the array
+	if (attr == ATTR_COLOR)
+		glVertexAttrib4f (ATTR_COLOR, ff.color[0], ff.color[1], ff.color[2], ff.color[3]);
+}
+
+void glVertexPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr) {
+	glVertexAttribPointer (ATTR_POSITION, size, type, GL_FALSE, stride, ptr);
+}
+
+void glNormalPointer (GLenum type, GLsizei stride, const GLvoid *ptr) {
+	glVertexAttribPointer (ATTR_NORMAL, 3, type, type != GL_FLOAT, stride, ptr);
+}
+
+void glColorPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr) {
+	glVertexAttribPointer (ATTR_COLOR, size, type, type != GL_FLOAT, stride, ptr);
+}
+
+void glTexCoordPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr) {
+	glVertexAttribPointer (ATTR_TEXCOORD, size, type, GL_FALSE, stride, ptr);
+}
+
+// --------------------------------------------------------------------
+//				lighting, materials, fog
+// --------------------------------------------------------------------
+
+void glLightf (GLenum light, GLenum pname, GLfloat param) {
+	// spot lights and attenuation aren't used by the game
+}
+
+void glLightfv (GLenum light, GLenum pname, const GLfloat *params) {
+	InitState ();
+	if (light < GL_LIGHT0 || light >= GL_LIGHT0 + MAX_LIGHTS) return;
+	TLightState& l = ff.lights[light - GL_LIGHT0];
+	switch (pname) {
+		case GL_AMBIENT: memcpy (l.ambient, params, sizeof(l.ambient)); break;
+		case GL_DIFFUSE: memcpy (l.diffuse, params, sizeof(l.diffuse)); break;
+		case GL_SPECULAR: memcpy (l.specular, params, sizeof(l.specular)); break;
+		case GL_POSITION: {
+			// stored in eye coordinates, like GL does
+			const GLfloat *mv = ff.stacks[0].m[ff.stacks[0].top];
+			for (int i=0; i<4; i++)
+				l.position[i] = mv[i] * params[0] + mv[4 + i] * params[1]
+				              + mv[8 + i] * params[2] + mv[12 + i] * params[3];
+			break;
+		}
+		default: return;
+	}
+	ff.light_serial++;
+}
+
+void glLightModelf (GLenum pname, GLfloat param) {
+	// only GL_LIGHT_MODEL_TWO_SIDE has a single value, it isn't emulated
+}
+
+void glLightModelfv (GLenum pname, const GLfloat *params) {
+	InitState ();
+	if (pname == GL_LIGHT_MODEL_AMBIENT) {
+		memcpy (ff.scene_ambient, params, sizeof(ff.scene_ambient));
+		ff.light_serial++;
+	}
+}
+
+void glMaterialf (GLenum face, GLenum pname, GLfloat param) {
+	InitState ();
+	if (pname == GL_SHININESS) {
+		ff.mat_shininess = param;
+		ff.material_serial++;
+	}
+}
+
+void glMaterialfv (GLenum face, GLenum pname, const GLfloat *params) {
+	InitState ();
+	switch (pname) {
+		case GL_AMBIENT: memcpy (ff.mat_ambient, params, sizeof(ff.mat_ambient)); break;
+		case GL_DIFFUSE: memcpy (ff.mat_diffuse, params, sizeof(ff.mat_diffuse)); break;
+		case GL_AMBIENT_AND_DIFFUSE:
+			memcpy (ff.mat_ambient, params, sizeof(ff.mat_ambient));
+			memcpy (ff.mat_diffuse, params, sizeof(ff.mat_diffuse));
+			break;
+		case GL_SPECULAR: memcpy (ff.mat_specular, params, sizeof(ff.mat_specular)); break;
+		case GL_EMISSION: memcpy (ff.mat_emission, params, sizeof(ff.mat_emission)); break;
+		case GL_SHININESS: ff.mat_shininess = params[0]; break;
+		default: return;
+	}
+	ff.material_serial++;
+}
+
+void glFogf (GLenum pname, GLfloat param) {
+	InitState ();
+	switch (pname) {
+		case GL_FOG_MODE: ff.fog_mode = (GLenum)param; break;
+		case GL_FOG_START: ff.fog_start = param; break;
+		case GL_FOG_END: ff.fog_end = param; break;
+		case GL_FOG_DENSITY: ff.fog_density = param; break;
+		default: return;
+	}
+	ff.fog_serial++;
+}
+
+void glFogfv (GLenum pname, const GLfloat *params) {
+	InitState ();
+	if (pname == GL_FOG_COLOR) {
+		memcpy (ff.fog_color, params, sizeof(ff.fog_color));
+		ff.fog_serial++;
+	} else {
+		glFogf (pname, params[0]);
+	}
+}
+
+void glAlphaFunc (GLenum func, GLclampf ref) {
+	InitState ();
+	ff.alpha_func = func;
+	ff.alpha_ref = ref;
+	ff.alpha_serial++;
+}
+
+void glShadeModel (GLenum mode) {
+	// always smooth
+}
+
+void glTexEnvf (GLenum target, GLenum pname, GLfloat param) {
+	InitState ();
+	if (target == GL_TEXTURE_ENV && pname == GL_TEXTURE_ENV_MODE)
+		ff.texenv = (GLenum)param;
+}
+
+void glTexEnvi (GLenum target, GLenum pname, GLint param) {
+	glTexEnvf (target, pname, (GLfloat)param);
+}
+
+// --------------------------------------------------------------------
+//				state queries and textures
+// --------------------------------------------------------------------
+
+static bool *FixedCap (GLenum cap) {
+	switch (cap) {
+		case GL_TEXTURE_2D: return &ff.texture_2d;
+		case GL_LIGHTING: return &ff.lighting;
+		case GL_FOG: return &ff.fog;
+		case GL_ALPHA_TEST: return &ff.alpha_test;
+		case GL_COLOR_MATERIAL: return &ff.color_material;
+		case GL_NORMALIZE: return &ff.normalize;
+		case GL_RESCALE_NORMAL: return &ff.normalize;
+		case GL_LINE_SMOOTH: return &ff.line_smooth;
+		case GL_MULTISAMPLE: return &ff.multisample;
+	}
+	if (cap >= GL_LIGHT0 && cap < GL_LIGHT0 + MAX_LIGHTS)
+		return &ff.lights[cap - GL_LIGHT0].on;
+	return NULL;
+}
+
+static void SetCap (GLenum cap, bool on) {
+	InitState ();
+	bool *flag = FixedCap (cap);
+	if (flag == NULL) {
+		if (on) glEnable (cap);
+		else glDisable (cap);
+		return;
+	}
+	if (*flag == on) return;
+	*flag = on;
+	if (cap >= GL_LIGHT0 && cap < GL_LIGHT0 + MAX_LIGHTS) ff.light_serial++;
+	// the material follows the current color at once
+	if (cap == GL_COLOR_MATERIAL && on)
+		glColor4f (ff.color[0], ff.color[1], ff.color[2], ff.color[3]);
+}
+
+void gles2Enable (GLenum cap) {
+	SetCap (cap, true);
+}
+
+void gles2Disable (GLenum cap) {
+	SetCap (cap, false);
+}
+
+GLboolean gles2IsEnabled (GLenum cap) {
+	InitState ();
+	bool *flag = FixedCap (cap);
+	if (flag == NULL) return glIsEnabled (cap);
+	return *flag ? GL_TRUE : GL_FALSE;
+}
+
+void gles2GetFloatv (GLenum pname, GLfloat *params) {
+	InitState ();
+	switch (pname) {
+		case GL_MODELVIEW_MATRIX:
+			memcpy (params, ff.stacks[0].m[ff.stacks[0].top], 16 * sizeof(GLfloat));
+			break;
+		case GL_PROJECTION_MATRIX:
+			memcpy (params, ff.stacks[1].m[ff.stacks[1].top], 16 * sizeof(GLfloat));
+			break;
+		case GL_TEXTURE_MATRIX:
+			memcpy (params, ff.stacks[2].m[ff.stacks[2].top], 16 * sizeof(GLfloat));
+			break;
+		case GL_CURRENT_COLOR:
+			memcpy (params, ff.color, sizeof(ff.color));
+			break;
+		default:
+			glGetFloatv (pname, params);
+	}
+}
+
+void gles2GetIntegerv (GLenum pname, GLint *params) {
+	switch (pname) {
+		case GL_MAX_LIGHTS: *params = MAX_LIGHTS; break;
+		case GL_MAX_MODELVIEW_STACK_DEPTH:
+		case GL_MAX_PROJECTION_STACK_DEPTH:
+		case GL_MAX_TEXTURE_STACK_DEPTH: *params = MATRIX_STACK_DEPTH; break;
+		case GL_BLEND_SRC: glGetIntegerv (GL_BLEND_SRC_RGB, params); break;
+		case GL_BLEND_DST: glGetIntegerv (GL_BLEND_DST_RGB, params); break;
+		default: glGetIntegerv (pname, params);
+	}
+}
+
+void gles2Hint (GLenum target, GLenum mode) {
+	if (target == GL_GENERATE_MIPMAP_HINT) glHint (target, mode);
+}
+
+void gles2BindTexture (GLenum target, GLuint texture) {
+	InitState ();
+	if (target == GL_TEXTURE_2D) ff.texture = texture;
+	glBindTexture (target, texture);
+}
+
+void gles2DeleteTextures (GLsizei n, const GLuint *textures) {
+	InitState ();
+	for (GLsizei i=0; i<n; i++) {
+		ff.textures.erase (textures[i]);
+		if (textures[i] == ff.texture) ff.texture = 0;
+	}
+	glDeleteTextures (n, textures);
+}
+
+void gles2TexParameteri (GLenum target, GLenum pname, GLint param) {
+	InitState ();
+	if (pname == GL_GENERATE_MIPMAP) {
+		ff.textures[ff.texture].generate_mipmap = param != 0;
+		return;
+	}
+	glTexParameteri (target, pname, param);
+}
+
+void gles2TexImage2D (GLenum target, GLint level, GLint internalformat,
+		GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
+		const GLvoid *pixels) {
+	InitState ();
+	glTexImage2D (target, level, internalformat, width, height, border, format, type, pixels);
+	if (level != 0) return;
+	TTextureInfo& info = ff.textures[ff.texture];
+	info.alpha = format == GL_ALPHA;
+	if (info.generate_mipmap) glGenerateMipmap (target);
+}
+
+// --------------------------------------------------------------------
+//				shaders
+// --------------------------------------------------------------------
+
+// key bits
+#define KEY_TEXTURE        0x001
+#define KEY_TEXTURE_ALPHA  0x002
+#define KEY_TEXENV_SHIFT   2		// 2 bits: modulate, replace, decal, add
+#define KEY_LIGHTING       0x010
+#define KEY_COLOR_MATERIAL 0x020
+#define KEY_FOG            0x040
+#define KEY_FOG_SHIFT      7		// 2 bits: linear, exp, exp2
+#define KEY_ALPHA_TEST     0x200
+#define KEY_ALPHA_SHIFT    10		// 3 bits: func - GL_NEVER
+
+static const char *vertex_source =
+	"attribute vec4 a_position;\n"
+	"attribute vec3 a_normal;\n"
+	"attribute vec4 a_color;\n"
+	"attribute vec4 a_texcoord;\n"
+	"uniform mat4 u_mvp;\n"
+	"varying vec4 v_color;\n"
+	"#ifdef TEXTURE\n"
+	"varying vec2 v_texcoord;\n"
+	"#endif\n"
+	"#if defined(LIGHTING) || defined(FOG)\n"
+	"uniform mat4 u_modelview;\n"
+	"#endif\n"
+	"#ifdef LIGHTING\n"
+	"uniform mat3 u_normalmatrix;\n"
+	"uniform int u_numlights;\n"
+	"uniform vec4 u_lightpos[8];\n"
+	"uniform vec4 u_lightambient[8];\n"
+	"uniform vec4 u_lightdiffuse[8];\n"
+	"uniform vec4 u_lightspecular[8];\n"
+	"uniform vec4 u_sceneambient;\n"
+	"uniform vec4 u_ambient;\n"
+	"uniform vec4 u_diffuse;\n"
+	"uniform vec4 u_specular;\n"
+	"uniform vec4 u_emission;\n"
+	"uniform float u_shininess;\n"
+	"#endif\n"
+	"#ifdef FOG\n"
+	"uniform vec4 u_fog;\n"		// end, density, 1 / (end - start)
+	"varying float v_fog;\n"
+	"#endif\n"
+	"void main() {\n"
+	"	gl_Position = u_mvp * a_position;\n"
+	"#if defined(LIGHTING) || defined(FOG)\n"
+	"	vec4 eye = u_modelview * a_position;\n"
+	"#endif\n"
+	"#ifdef LIGHTING\n"
+	"#ifdef COLOR_MATERIAL\n"
+	"	vec4 ambient = a_color;\n"
+	"	vec4 diffuse = a_color;\n"
+	"#else\n"
+	"	vec4 ambient = u_ambient;\n"
+	"	vec4 diffuse = u_diffuse;\n"
+	"#endif\n"
+	"	vec3 n = normalize(u_normalmatrix * a_normal);\n"
+	"	vec3 c = u_emission.rgb + u_sceneambient.rgb * ambient.rgb;\n"
+	"	for (int i = 0; i < 8; i++) {\n"
+	"		if (i >= u_numlights) break;\n"
+	"		vec3 l = u_lightpos[i].w == 0.0 ? normalize(u_lightpos[i].xyz)\n"
+	"			: normalize(u_lightpos[i].xyz - eye.xyz);\n"
+	"		float ndotl = max(dot(n, l), 0.0);\n"
+	"		c += u_lightambient[i].rgb * ambient.rgb;\n"
+	"		c += ndotl * u_lightdiffuse[i].rgb * diffuse.rgb;\n"
+	"		if (ndotl > 0.0) {\n"
+	"			float ndoth = max(dot(n, normalize(l + vec3(0.0, 0.0, 1.0))), 1e-6);\n"
+	"			c += pow(ndoth, u_shininess) * u_lightspecular[i].rgb * u_specular.rgb;\n"
+	"		}\n"
+	"	}\n"
+	"	v_color = clamp(vec4(c, diffuse.a), 0.0, 1.0);\n"
+	"#else\n"
+	"	v_color = a_color;\n"
+	"#endif\n"
+	"#ifdef TEXTURE\n"
+	"	v_texcoord = a_texcoord.xy;\n"
+	"#endif\n"
+	"#ifdef FOG\n"
+	"	float z = abs(eye.z);\n"
+	"#if FOG_MODE == 0\n"
+	"	v_fog = (u_fog.x - z) * u_fog.z;\n"
+	"#elif FOG_MODE == 1\n"
+	"	v_fog = exp(-u_fog.y * z);\n"
+	"#else\n"
+	"	v_fog = exp(-(u_fog.y * z) * (u_fog.y * z));\n"
+	"#endif\n"
+	"	v_fog = clamp(v_fog, 0.0, 1.0);\n"
+	"#endif\n"
+	"}\n";
+
+static const char *fragment_source =
+	"precision mediump float;\n"
+	"varying vec4 v_color;\n"
+	"#ifdef TEXTURE\n"
+	"uniform sampler2D u_texture;\n"
+	"varying vec2 v_texcoord;\n"
+	"#endif\n"
+	"#ifdef FOG\n"
+	"uniform vec4 u_fogcolor;\n"
+	"varying float v_fog;\n"
+	"#endif\n"
+	"#ifdef ALPHA_TEST\n"
+	"uniform float u_alpharef;\n"
+	"#endif\n"
+	"void main() {\n"
+	"	vec4 c = v_color;\n"
+	"#ifdef TEXTURE\n"
+	"	vec4 t = texture2D(u_texture, v_texcoord);\n"
+	"#ifdef TEXTURE_ALPHA\n"
+	"#if TEXENV == 1\n"
+	"	c.a = t.a;\n"
+	"#elif TEXENV != 2\n"
+	"	c.a *= t.a;\n"
+	"#endif\n"
+	"#else\n"
+	"#if TEXENV == 0\n"
+	"	c *= t;\n"
+	"#elif TEXENV == 1\n"
+	"	c = t;\n"
+	"#elif TEXENV == 2\n"
+	"	c.rgb = mix(c.rgb, t.rgb, t.a);\n"
+	"#else\n"
+	"	c = vec4(min(c.rgb + t.rgb, 1.0), c.a * t.a);\n"
+	"#endif\n"
+	"#endif\n"
+	"#endif\n"
+	"#ifdef ALPHA_TEST\n"
+	"	if (!(c.a ALPHA_CMP u_alpharef)) discard;\n"
+	"#endif\n"
+	"#ifdef FOG\n"
+	"	c.rgb = mix(u_fogcolor.rgb, c.rgb, v_fog);\n"
+	"#endif\n"
+	"	gl_FragColor = c;\n"
+	"}\n";
+
+struct TProgram {
+	GLuint id;
+	GLint mvp, modelview, normalmatrix;
+	GLint numlights, lightpos, lightambient, lightdiffuse, lightspecular;
+	GLint sceneambient, ambient, diffuse, specular, emission, shininess;
+	GLint fog, fogcolor, alpharef, texture;
+	unsigned int matrix_serial, light_serial, material_serial, fog_serial, alpha_serial;
+};
+
+static map<unsigned int, TProgram*> programs;
+static TProgram *current_program = NULL;
+
+static unsigned int ProgramKey () {
+	unsigned int key = 0;
+	if (ff.texture_2d && ff.texture != 0) {
+		key |= KEY_TEXTURE;
+		map<GLuint, TTextureInfo>::const_iterator it = ff.textures.find (ff.texture);
+		if (it != ff.textures.end() && it->second.alpha) key |= KEY_TEXTURE_ALPHA;
+		unsigned int env = 0;
+		switch (ff.texenv) {
+			case GL_REPLACE: env = 1; break;
+			case GL_DECAL: env = 2; break;
+			case GL_ADD: env = 3; break;
+		}
+		key |= env << KEY_TEXENV_SHIFT;
+	}
+	if (ff.lighting) {
+		key |= KEY_LIGHTING;
+		if (ff.color_material) key |= KEY_COLOR_MATERIAL;
+	}
+	if (ff.fog) {
+		key |= KEY_FOG;
+		unsigned int mode = ff.fog_mode == GL_LINEAR ? 0 : (ff.fog_mode == GL_EXP ? 1 : 2);
+		key |= mode << KEY_FOG_SHIFT;
+	}
+	if (ff.alpha_test && ff.alpha_func != GL_ALWAYS) {
+		key |= KEY_ALPHA_TEST;
+		key |= ((ff.alpha_func - GL_NEVER) & 7) << KEY_ALPHA_SHIFT;
+	}
+	return key;
+}
+
+static GLuint CompileShader (GLenum type, const string& source) {
+	GLuint shader = glCreateShader (type);
+	const char *src = source.c_str();
+	glShaderSource (shader, 1, &src, NULL);
+	glCompileShader (shader);
+	GLint ok;
+	glGetShaderiv (shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		char log[1024];
+		glGetShaderInfoLog (shader, sizeof(log), NULL, log);
+		Message ("could not compile shader", log);
+	}
+	return shader;
+}
+
+static TProgram *CreateProgram (unsigned int key) {
+	static const char *alpha_cmp[8] = {
+		"< -1.0 +", "<", "==", "<=", ">", "!=", ">=", "> -1.0 +"
+	};
+	string defines;
+	if (key & KEY_TEXTURE) {
+		defines += "#define TEXTURE\n";
+		defines += "#define TEXENV " + Int_StrN ((key >> KEY_TEXENV_SHIFT) & 3) + "\n";
+	}
+	if (key & KEY_TEXTURE_ALPHA) defines += "#define TEXTURE_ALPHA\n";
+	if (key & KEY_LIGHTING) defines += "#define LIGHTING\n";
+	if (key & KEY_COLOR_MATERIAL) defines += "#define COLOR_MATERIAL\n";
+	if (key & KEY_FOG) {
+		defines += "#define FOG\n";
+		defines += "#define FOG_MODE " + Int_StrN ((key >> KEY_FOG_SHIFT) & 3) + "\n";
+	}
+	if (key & KEY_ALPHA_TEST) {
+		defines += "#define ALPHA_TEST\n";
+		defines += string ("#define ALPHA_CMP ") + alpha_cmp[(key >> KEY_ALPHA_SHIFT) & 7] + "\n";
+	}
+
+	GLuint vs = CompileShader (GL_VERTEX_SHADER, defines + vertex_source);
+	GLuint fs = CompileShader (GL_FRAGMENT_SHADER, defines + fragment_source);
+	GLuint id = glCreateProgram ();
+	glAttachShader (id, vs);
+	glAttachShader (id, fs);
+	glBindAttribLocation (id, ATTR_POSITION, "a_position");
+	glBindAttribLocation (id, ATTR_NORMAL, "a_normal");
+	glBindAttribLocation (id, ATTR_COLOR, "a_color");
+	glBindAttribLocation (id, ATTR_TEXCOORD, "a_texcoord");
+	glLinkProgram (id);
+	glDeleteShader (vs);
+	glDeleteShader (fs);
+	GLint ok;
+	glGetProgramiv (id, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		char log[1024];
+		glGetProgramInfoLog (id, sizeof(log), NULL, log);
+		Message ("could not link shader program", log);
+	}
+
+	TProgram *p = new TProgram;
+	p->id = id;
+	p->mvp = glGetUniformLocation (id, "u_mvp");
+	p->modelview = glGetUniformLocation (id, "u_modelview");
+	p->normalmatrix = glGetUniformLocation (id, "u_normalmatrix");
+	p->numlights = glGetUniformLocation (id, "u_numlights");
+	p->lightpos = glGetUniformLocation (id, "u_lightpos");
+	p->lightambient = glGetUniformLocation (id, "u_lightambient");
+	p->lightdiffuse = glGetUniformLocation (id, "u_lightdiffuse");
+	p->lightspecular = glGetUniformLocation (id, "u_lightspecular");
+	p->sceneambient = glGetUniformLocation (id, "u_sceneambient");
+	p->ambient = glGetUniformLocation (id, "u_ambient");
+	p->diffuse = glGetUniformLocation (id, "u_diffuse");
+	p->specular = glGetUniformLocation (id, "u_specular");
+	p->emission = glGetUniformLocation (id, "u_emission");
+	p->shininess = glGetUniformLocation (id, "u_shininess");
+	p->fog = glGetUniformLocation (id, "u_fog");
+	p->fogcolor = glGetUniformLocation (id, "u_fogcolor");
+	p->alpharef = glGetUniformLocation (id, "u_alpharef");
+	p->texture = glGetUniformLocation (id, "u_texture");
+	p->matrix_serial = 0;
+	p->light_serial = 0;
+	p->material_serial = 0;
+	p->fog_serial = 0;
+	p->alpha_serial = 0;
+
+	glUseProgram (id);
+	if (p->texture >= 0) glUniform1i (p->texture, 0);
+	current_program = p;
+	return p;
+}
+
+static void UploadLights (TProgram *p) {
+	GLfloat pos[MAX_LIGHTS * 4], amb[MAX_LIGHTS * 4], diff[MAX_LIGHTS * 4], spec[MAX_LIGHTS * 4];
+	int n = 0;
+	for (int i=0; i<MAX_LIGHTS; i++) {
+		const TLightState& l = ff.lights[i];
+		if (!l.on) continue;
+		memcpy (pos + n*4, l.position, sizeof(l.position));
+		memcpy (amb + n*4, l.ambient, sizeof(l.ambient));
+		memcpy (diff + n*4, l.diffuse, sizeof(l.diffuse));
+		memcpy (spec + n*4, l.specular, sizeof(l.specular));
+		n++;
+	}
+	glUniform1i (p->numlights, n);
+	if (n > 0) {
+		glUniform4fv (p->lightpos, n, pos);
+		glUniform4fv (p->lightambient, n, amb);
+		glUniform4fv (p->lightdiffuse, n, diff);
+		glUniform4fv (p->lightspecular, n, spec);
+	}
+	glUniform4fv (p->sceneambient, 1, ff.scene_ambient);
+}
+
+// selects the program for the current state and brings its uniforms up to date
+static void PrepareDraw () {
+	InitState ();
+	unsigned int key = ProgramKey ();
+	map<unsigned int, TProgram*>::const_iterator it = programs.find (key);
+	TProgram *p;
+	if (it == programs.end()) {
+		p = CreateProgram (key);
+		programs[key] = p;
+	} else {
+		p = it->second;
+	}
+	if (p != current_program) {
+		glUseProgram (p->id);
+		current_program = p;
+	}
+
+	if (p->matrix_serial != ff.matrix_serial) {
+		const GLfloat *mv = ff.stacks[0].m[ff.stacks[0].top];
+		GLfloat mvp[16];
+		MultMatrix (mvp, ff.stacks[1].m[ff.stacks[1].top], mv);
+		glUniformMatrix4fv (p->mvp, 1, GL_FALSE, mvp);
+		if (p->modelview >= 0) glUniformMatrix4fv (p->modelview, 1, GL_FALSE, mv);
+		if (p->normalmatrix >= 0) {
+			GLfloat nm[9];
+			NormalMatrix (mv, nm);
+			glUniformMatrix3fv (p->normalmatrix, 1, GL_FALSE, nm);
+		}
+		p->matrix_serial = ff.matrix_serial;
+	}
+	if (key & KEY_LIGHTING) {
+		if (p->light_serial != ff.light_serial) {
+			UploadLights (p);
+			p->light_serial = ff.light_serial;
+		}
+		if (p->material_serial != ff.material_serial) {
+			glUniform4fv (p->ambient, 1, ff.mat_ambient);
+			glUniform4fv (p->diffuse, 1, ff.mat_diffuse);
+			glUniform4fv (p->specular, 1, ff.mat_specular);
+			glUniform4fv (p->emission, 1, ff.mat_emission);
+			glUniform1f (p->shininess, ff.mat_shininess);
+			p->material_serial = ff.material_serial;
+		}
+	}
+	if ((key & KEY_FOG) && p->fog_serial != ff.fog_serial) {
+		GLfloat range = ff.fog_end - ff.fog_start;
+		glUniform4f (p->fog, ff.fog_end, ff.fog_density, range != 0 ? 1 / range : 0, 0);
+		glUniform4fv (p->fogcolor, 1, ff.fog_color);
+		p->fog_serial = ff.fog_serial;
+	}
+	if ((key & KEY_ALPHA_TEST) && p->alpha_serial != ff.alpha_serial) {
+		glUniform1f (p->alpharef, ff.alpha_ref);
+		p->alpha_serial = ff.alpha_serial;
+	}
+}
+
+void gles2DrawArrays (GLenum mode, GLint first, GLsizei count) {
+	PrepareDraw ();
+	glDrawArrays (mode, first, count);
+}
+
+void gles2DrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+	PrepareDraw ();
+	glDrawElements (mode, count, type, indices);
+}
+
+#endif // USE_GLES2
@@ -0,0 +1,180 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef GLES2_H
+#define GLES2_H
+
+// The GLES2 backend (build with USE_GLES1 and USE_GLES2). The game keeps
+// using the GLES1 API, this module implements the part of it that the
+// game needs on OpenGL ES 2.0: matrix stacks, client arrays, lighting,
+// materials, fog, alpha test and the texture environment are turned into
+// uniforms and attributes of a small set of shader programs. Included by
+// bh.h instead of <GLES/gl.h>.
+
+#include <GLES2/gl2.h>
+
+// --------------------------------------------------------------------
+//				GLES1 enums that GLES2 doesn't have
+// --------------------------------------------------------------------
+
+#define GL_MODELVIEW                      0x1700
+#define GL_PROJECTION                     0x1701
+#ifndef GL_TEXTURE
+#define GL_TEXTURE                        0x1702
+#endif
+#define GL_MODELVIEW_MATRIX               0x0BA6
+#define GL_PROJECTION_MATRIX              0x0BA7
+#define GL_TEXTURE_MATRIX                 0x0BA8
+#define GL_MAX_LIGHTS                     0x0D31
+#define GL_MAX_MODELVIEW_STACK_DEPTH      0x0D36
+#define GL_MAX_PROJECTION_STACK_DEPTH     0x0D38
+#define GL_MAX_TEXTURE_STACK_DEPTH        0x0D39
+
+#define GL_VERTEX_ARRAY                   0x8074
+#define GL_NORMAL_ARRAY                   0x8075
+#define GL_COLOR_ARRAY                    0x8076
+#define GL_TEXTURE_COORD_ARRAY            0x8078
+
+#define GL_LIGHTING                       0x0B50
+#define GL_LIGHT0                         0x4000
+#define GL_LIGHT1                         0x4001
+#define GL_LIGHT2                         0x4002
+#define GL_LIGHT3                         0x4003
+#define GL_LIGHT4                         0x4004
+#define GL_LIGHT5                         0x4005
+#define GL_LIGHT6                         0x4006
+#define GL_LIGHT7                         0x4007
+#define GL_NORMALIZE                      0x0BA1
+#define GL_RESCALE_NORMAL                 0x803A
+#define GL_COLOR_MATERIAL                 0x0B57
+#define GL_FOG                            0x0B60
+#define GL_ALPHA_TEST                     0x0BC0
+#define GL_LINE_SMOOTH                    0x0B20
+#define GL_POINT_SMOOTH                   0x0B10
+#define GL_MULTISAMPLE                    0x809D
+
+#define GL_AMBIENT                        0x1200
+#define GL_DIFFUSE                        0x1201
+#define GL_SPECULAR                       0x1202
+#define GL_POSITION                       0x1203
+#define GL_EMISSION                       0x1600
+#define GL_SHININESS                      0x1601
+#define GL_AMBIENT_AND_DIFFUSE            0x1602
+#define GL_LIGHT_MODEL_AMBIENT            0x0B53
+#define GL_LIGHT_MODEL_TWO_SIDE           0x0B52
+
+#define GL_FOG_DENSITY                    0x0B62
+#define GL_FOG_START                      0x0B63
+#define GL_FOG_END                        0x0B64
+#define GL_FOG_MODE                       0x0B65
+#define GL_FOG_COLOR                      0x0B66
+#define GL_EXP                            0x0800
+#define GL_EXP2                           0x0801
+
+#define GL_FLAT                           0x1D00
+#define GL_SMOOTH                         0x1D01
+
+#define GL_TEXTURE_ENV                    0x2300
+#define GL_TEXTURE_ENV_MODE               0x2200
+#define GL_MODULATE                       0x2100
+#define GL_DECAL                          0x2101
+#define GL_ADD                            0x0104
+
+#define GL_PERSPECTIVE_CORRECTION_HINT    0x0C50
+#define GL_POINT_SMOOTH_HINT              0x0C51
+#define GL_LINE_SMOOTH_HINT               0x0C52
+#define GL_FOG_HINT                       0x0C54
+#define GL_GENERATE_MIPMAP                0x8191
+
+#define GL_BLEND_SRC                      0x0BE1
+#define GL_BLEND_DST                      0x0BE0
+#define GL_CURRENT_COLOR                  0x0B00
+
+// --------------------------------------------------------------------
+//				emulated GLES1 functions
+// --------------------------------------------------------------------
+
+void glMatrixMode (GLenum mode);
+void glLoadIdentity ();
+void glLoadMatrixf (const GLfloat *m);
+void glMultMatrixf (const GLfloat *m);
+void glPushMatrix ();
+void glPopMatrix ();
+void glTranslatef (GLfloat x, GLfloat y, GLfloat z);
+void glRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z);
+void glScalef (GLfloat x, GLfloat y, GLfloat z);
+void glOrthof (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f);
+void glFrustumf (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f);
+
+void glColor4f (GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+void glColor4ub (GLubyte r, GLubyte g, GLubyte b, GLubyte a);
+void glNormal3f (GLfloat x, GLfloat y, GLfloat z);
+
+void glEnableClientState (GLenum array);
+void glDisableClientState (GLenum array);
+void glVertexPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr);
+void glNormalPointer (GLenum type, GLsizei stride, const GLvoid *ptr);
+void glColorPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr);
+void glTexCoordPointer (GLint size, GLenum type, GLsizei stride, const GLvoid *ptr);
+
+void glLightf (GLenum light, GLenum pname, GLfloat param);
+void glLightfv (GLenum light, GLenum pname, const GLfloat *params);
+void glLightModelf (GLenum pname, GLfloat param);
+void glLightModelfv (GLenum pname, const GLfloat *params);
+void glMaterialf (GLenum face, GLenum pname, GLfloat param);
+void glMaterialfv (GLenum face, GLenum pname, const GLfloat *params);
+void glFogf (GLenum pname, GLfloat param);
+void glFogfv (GLenum pname, const GLfloat *params);
+void glAlphaFunc (GLenum func, GLclampf ref);
+void glShadeModel (GLenum mode);
+void glTexEnvf (GLenum target, GLenum pname, GLfloat param);
+void glTexEnvi (GLenum target, GLenum pname, GLint param);
+
+// --------------------------------------------------------------------
+//				GLES2 functions that see the fixed function state
+// --------------------------------------------------------------------
+
+void gles2Enable (GLenum cap);
+void gles2Disable (GLenum cap);
+GLboolean gles2IsEnabled (GLenum cap);
+void gles2GetFloatv (GLenum pname, GLfloat *params);
+void gles2GetIntegerv (GLenum pname, GLint *params);
+void gles2Hint (GLenum target, GLenum mode);
+void gles2DrawArrays (GLenum mode, GLint first, GLsizei count);
+void gles2DrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices);
+void gles2BindTexture (GLenum target, GLuint texture);
+void gles2DeleteTextures (GLsizei n, const GLuint *textures);
+void gles2TexParameteri (GLenum target, GLenum pname, GLint param);
+void gles2TexImage2D (GLenum target, GLint level, GLint internalformat,
+	GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
+	const GLvoid *pixels);
+
+#ifndef GLES2_NO_REDIRECT
+#define glEnable gles2Enable
+#define glDisable gles2Disable
+#define glIsEnabled gles2IsEnabled
+#define glGetFloatv gles2GetFloatv
+#define glGetIntegerv gles2GetIntegerv
+#define glHint gles2Hint
+#define glDrawArrays gles2DrawArrays
+#define glDrawElements gles2DrawElements
+#define glBindTexture gles2BindTexture
+#define glDeleteTextures gles2DeleteTextures
+#define glTexParameteri gles2TexParameteri
+#define glTexImage2D gles2TexImage2D
+#endif
+
+#endif
@@ -0,0 +1,105 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef GLSTATS_H
+#define GLSTATS_H
+
+// Counts the GL work of a frame. Included by bh.h after the GL header, the
+// macros at the end send the draw, bind, enable and matrix calls of the
+// game through the counting functions below. The counts go to the bucket
+// of the active render mode, see GLStats in ogl.h.
+
+struct TGLCounts {
+	unsigned int draws;
+	unsigned int vertices;		// or indices
+	unsigned int binds;
+	unsigned int enables;		// glEnable and glDisable
+	unsigned int matrix_ops;
+};
+
+extern TGLCounts *glcounts;
+
+inline void StatDrawArrays (GLenum mode, GLint first, GLsizei count) {
+	glcounts->draws++;
+	glcounts->vertices += count;
+	glDrawArrays (mode, first, count);
+}
+
+inline void StatDrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid *indices) {
+	glcounts->draws++;
+	glcounts->vertices += count;
+	glDrawElements (mode, count, type, indices);
+}
+
+inline void StatBindTexture (GLenum target, GLuint texture) {
+	glcounts->binds++;
+	glBindTexture (target, texture);
+}
+
+inline void StatEnable (GLenum cap) {
+	glcounts->enables++;
+	glEnable (cap);
+}
+
+inline void StatDisable (GLenum cap) {
+	glcounts->enables++;
+	glDisable (cap);
+}
+
+inline void StatPushMatrix () { glcounts->matrix_ops++; glPushMatrix (); }
+inline void StatPopMatrix () { glcounts->matrix_ops++; glPopMatrix (); }
+inline void StatLoadIdentity () { glcounts->matrix_ops++; glLoadIdentity (); }
+inline void StatLoadMatrixf (const GLfloat *m) { glcounts->matrix_ops++; glLoadMatrixf (m); }
+inline void StatMultMatrixf (const GLfloat *m) { glcounts->matrix_ops++; glMultMatrixf (m); }
+
+inline void StatTranslatef (GLfloat x, GLfloat y, GLfloat z) {
+	glcounts->matrix_ops++;
+	glTranslatef (x, y, z);
+}
+
+inline void StatRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z) {
+	glcounts->matrix_ops++;
+	glRotatef (angle, x, y, z);
+}
+
+inline void StatScalef (GLfloat x, GLfloat y, GLfloat z) {
+	glcounts->matrix_ops++;
+	glScalef (x, y, z);
+}
+
+// the GLES2 backend implements these itself, it mustn't count its own calls
+#ifndef GLSTATS_NO_REDIRECT
+#undef glDrawArrays
+#undef glDrawElements
+#undef glBindTexture
+#undef glEnable
+#undef glDisable
+#define glDrawArrays StatDrawArrays
+#define glDrawElements StatDrawElements
+#define glBindTexture StatBindTexture
+#define glEnable StatEnable
+#define glDisable StatDisable
+#define glPushMatrix StatPushMatrix
+#define glPopMatrix StatPopMatrix
+#define glLoadIdentity StatLoadIdentity
+#define glLoadMatrixf StatLoadMatrixf
+#define glMultMatrixf StatMultMatrixf
+#define glTranslatef StatTranslatef
+#define glRotatef StatRotatef
+#define glScalef StatScalef
+#endif
+
+#endif
@@ -120,7 +120,7 @@ void TTextField::Draw() const {
 		int h = 26 * Winsys.scale;
 		int scrheight = Winsys.resolution.height;
 
-		glDisable (GL_TEXTURE_2D);
+		GLDisable (GL_TEXTURE_2D);
 		glColor(colYellow);
 		const GLshort vtx[] = {
 			GLshort(x),     GLshort(scrheight - mouseRect.top - h - 9),
@@ -132,7 +132,7 @@ void TTextField::Draw() const {
 		glVertexPointer(2, GL_SHORT, 0, vtx);
 		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 		glDisableClientState(GL_VERTEX_ARRAY);
-		glEnable (GL_TEXTURE_2D);
+		GLEnable (GL_TEXTURE_2D);
 	}
 }
 
@@ -241,8 +241,8 @@ void TIconButton::Draw () const {
 	DrawFrameX (position.x-line, position.y-line,
 	            framesize, framesize, line, colBlack, framecol, 1.0);
 
-	glEnable (GL_TEXTURE_2D);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	texture->Bind();
 	glColor4f (1.0, 1.0, 1.0, 1.0);
 
@@ -275,11 +275,13 @@ void TIconButton::Draw () const {
 			0.5, 0.5
 		}
 	};
+	GLfloat texcoords[8];
+	texture->MapTexCoords(tex[value], texcoords, 4);
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	glVertexPointer(2, GL_SHORT, 0, vtx);
-	glTexCoordPointer(2, GL_FLOAT, 0, tex[value]);
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoords);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -332,17 +334,19 @@ void TArrow::Draw() const {
 	if (down)
 		type += 3;
 
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
 	Tex.BindTex (LB_ARROWS);
 	glColor4f (1.0, 1.0, 1.0, 1.0);
 
-	const GLfloat tex[] = {
+	const GLfloat coords[] = {
 		textl[type], texbl[type],
 		textr[type], texbl[type],
 		textr[type], texbr[type],
 		textl[type], texbr[type]
 	};
+	GLfloat tex[8];
+	Tex.GetTexture (LB_ARROWS)->MapTexCoords(coords, tex, 4);
 	const GLshort vtx[] = {
 		GLshort(position.x),      GLshort(Winsys.resolution.height - position.y - 48),
 		GLshort(position.x + 48), GLshort(Winsys.resolution.height - position.y - 48),
@@ -460,7 +464,7 @@ void DrawFrameX (int x, int y, int w, int h, int line, const TColor& backcol, co
 	if (x < 0) x = (Winsys.resolution.width -w) / 2;
 
 	glPushMatrix();
-	glDisable(GL_TEXTURE_2D);
+	GLDisable(GL_TEXTURE_2D);
 	glEnableClientState(GL_VERTEX_ARRAY);
 
 	glColor(framecol, transp);
@@ -485,7 +489,7 @@ void DrawFrameX (int x, int y, int w, int h, int line, const TColor& backcol, co
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_VERTEX_ARRAY);
-	glEnable (GL_TEXTURE_2D);
+	GLEnable (GL_TEXTURE_2D);
 	glPopMatrix();
 }
 
@@ -517,9 +521,10 @@ void DrawBonusExt (int y, size_t numraces, size_t num) {
 	bl.y = Winsys.resolution.height - y - 32 -4;
 	tr.y = Winsys.resolution.height - y - 0 -4;
 
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
 	Tex.BindTex (TUXBONUS);
+	const TTexture* bonustex = Tex.GetTexture (TUXBONUS);
 	glColor4f (1.0, 1.0, 1.0, 1.0);
 
 	glEnableClientState(GL_VERTEX_ARRAY);
@@ -538,12 +543,14 @@ void DrawBonusExt (int y, size_t numraces, size_t num) {
 			float bott = 0.5;
 			float top = 1.0;
 
-			const GLfloat tex[] = {
+			const GLfloat coords[] = {
 				0, bott,
 				1, bott,
 				1, top,
 				0, top
 			};
+			GLfloat tex[8];
+			bonustex->MapTexCoords(coords, tex, 4);
 			const GLshort vtx[] = {
 				GLshort(bl.x), GLshort(bl.y),
 				GLshort(tr.x), GLshort(bl.y),
@@ -64,6 +64,7 @@ void CHelp::Loop() {
 		draw_ui_snow();
 	}
 
+	FT.BeginBatch ();
 	FT.AutoSizeN (4);
 	FT.SetColor(colWhite);
 	const int xleft1 = 40;
@@ -86,6 +87,7 @@ void CHelp::Loop() {
 	FT.DrawString (xleft1, ytop + offs * 12, Trans.Text(56));
 
 	FT.DrawString (CENTER, AutoYPosN (90), Trans.Text(65));
+	FT.EndBatch ();
 	Winsys.SwapBuffers();
 }
 
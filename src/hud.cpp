@@ -28,6 +28,7 @@ GNU General Public License for more details.
 #include "course.h"
 #include "physics.h"
 #include "winsys.h"
+#include "render_queue.h"
 
 
 #define GAUGE_IMG_SIZE 128
@@ -481,3 +482,11 @@ void DrawHud (const CControl *ctrl) {
 	DrawCoursePosition (ctrl);
 	DrawWind (Wind.Angle (), Wind.Speed (), ctrl);
 }
+
+static void DrawHudItem (const TRenderItem *items, size_t count) {
+	DrawHud (static_cast<const CControl*>(items[0].data));
+}
+
+void SubmitHud (const CControl *ctrl) {
+	if (param.show_hud) RenderQueue.Submit (RL_OVERLAY, TEXFONT, NULL, DrawHudItem, ctrl);
+}
@@ -21,5 +21,6 @@ GNU General Public License for more details.
 #include "bh.h"
 
 void DrawHud (const CControl *ctrl);
+void SubmitHud (const CControl *ctrl);
 
 #endif
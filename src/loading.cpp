@@ -70,6 +70,7 @@ void CLoading::Loop() {
 	Winsys.SwapBuffers ();
 
 	Course.LoadCourse (g_game.course);
+	Sound.Preload ("racing");
 	g_game.location_id = Course.GetEnv ();
 	Env.LoadEnvironment (g_game.location_id, g_game.light_id);
 	State::manager.RequestEnterState (Intro);
@@ -28,15 +28,26 @@ GNU General Public License for more details.
 #include "tools.h"
 #include "ogl_test.h"
 #include "winsys.h"
+#include "pack.h"
 #include <iostream>
 #include <ctime>
+#include <cstdlib>
 
 TGameData g_game;
 
 void InitGame (int argc, char **argv) {
 	g_game.toolmode = NONE;
 	g_game.argument = 0;
-	if (argc == 4) {
+	if (argc == 5) {
+		// --render <course> <frame> <file.png>: races the course without
+		// input and writes the given frame to a png file, then quits
+		string group_arg = argv[1];
+		if (group_arg == "--render") {
+			g_game.argument = 5;
+			g_game.render_course = argv[2];
+			Winsys.DumpFrame (atoi (argv[3]), argv[4]);
+		}
+	} else if (argc == 4) {
 		string group_arg = argv[1];
 		if (group_arg == "--char") g_game.argument = 4;
 		Tools.SetParameter(argv[2], argv[3]);
@@ -73,8 +84,13 @@ int main( int argc, char **argv ) {
 	cout << "\n----------- Extreme Tux Racer " ETR_VERSION_STRING " ----------------";
 	cout << "\n----------- (C) 2010-2013 Extreme Tuxracer Team  --------\n\n";
 
+#ifdef USE_HEADLESS
+	srand (1);
+#else
 	srand (time (NULL));
+#endif
 	InitConfig (argv[0]);
+	Pack.Open (param.data_dir + SEP "data.pack", param.data_dir);	// optional
 	InitGame (argc, argv);
 	Winsys.Init ();
 	InitOpenglExtensions ();
@@ -86,6 +102,7 @@ int main( int argc, char **argv ) {
 	//	PrintGLInfo ();
 
 	// theses resources must or should be loaded before splashscreen starts
+	TexCache.SetBudget ((size_t)param.texture_budget * 1024 * 1024);
 	Tex.LoadTextureList ();
 	FT.LoadFontlist ();
 	Winsys.SetFonttype ();
@@ -95,6 +112,7 @@ int main( int argc, char **argv ) {
 
 	switch (g_game.argument) {
 		case 0:
+		case 5:
 			State::manager.Run(SplashScreen);
 			break;
 		case 4:
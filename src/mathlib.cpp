@@ -33,12 +33,38 @@ TVector3d ProjectToPlane (const TVector3d& nml, const TVector3d& v) {
 }
 
 
+#if defined(ETR_SIMD_NEON) || defined(ETR_SIMD_SSE)
+// v.x * mat[0] + v.y * mat[1] + v.z * mat[2] (+ mat[3] for points), one matrix row per lane set.
+// TVector3d is only 12 bytes, so the components are broadcast instead of loaded as a vector.
+static inline TVector3d TransformSIMD(const TMatrix<4, 4>& mat, const TVector3d& v, bool point) {
+	float res[4];
+#if defined(ETR_SIMD_NEON)
+	float32x4_t r = vmulq_n_f32(vld1q_f32(mat[0]), v.x);
+	r = vmlaq_n_f32(r, vld1q_f32(mat[1]), v.y);
+	r = vmlaq_n_f32(r, vld1q_f32(mat[2]), v.z);
+	if (point) r = vaddq_f32(r, vld1q_f32(mat[3]));
+	vst1q_f32(res, r);
+#else
+	__m128 r = _mm_mul_ps(_mm_loadu_ps(mat[0]), _mm_set1_ps(v.x));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(mat[1]), _mm_set1_ps(v.y)));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_loadu_ps(mat[2]), _mm_set1_ps(v.z)));
+	if (point) r = _mm_add_ps(r, _mm_loadu_ps(mat[3]));
+	_mm_storeu_ps(res, r);
+#endif
+	return TVector3d(res[0], res[1], res[2]);
+}
+#endif
+
 TVector3d TransformVector(const TMatrix<4, 4>& mat, const TVector3d& v) {
+#if defined(ETR_SIMD_NEON) || defined(ETR_SIMD_SSE)
+	return TransformSIMD(mat, v, false);
+#else
 	TVector3d r;
 	r.x = v.x * mat[0][0] + v.y * mat[1][0] + v.z * mat[2][0];
 	r.y = v.x * mat[0][1] + v.y * mat[1][1] + v.z * mat[2][1];
 	r.z = v.x * mat[0][2] + v.y * mat[1][2] + v.z * mat[2][2];
 	return r;
+#endif
 }
 
 TVector3d TransformNormal(const TVector3d& n, const TMatrix<4, 4>& mat) {
@@ -50,6 +76,9 @@ TVector3d TransformNormal(const TVector3d& n, const TMatrix<4, 4>& mat) {
 }
 
 TVector3d TransformPoint(const TMatrix<4, 4>& mat, const TVector3d& p) {
+#if defined(ETR_SIMD_NEON) || defined(ETR_SIMD_SSE)
+	return TransformSIMD(mat, p, true);
+#else
 	TVector3d r;
 	r.x = p.x * mat[0][0] + p.y * mat[1][0] + p.z * mat[2][0];
 	r.y = p.x * mat[0][1] + p.y * mat[1][1] + p.z * mat[2][1];
@@ -58,6 +87,7 @@ TVector3d TransformPoint(const TMatrix<4, 4>& mat, const TVector3d& p) {
 	r.y += mat[3][1];
 	r.z += mat[3][2];
 	return r;
+#endif
 }
 
 bool IntersectPlanes (const TPlane& s1, const TPlane& s2, const TPlane& s3, TVector3d *p) {
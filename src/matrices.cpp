@@ -145,12 +145,39 @@ template<>
 TMatrix<4, 4> operator*<4, 4>(const TMatrix<4, 4>& l, const TMatrix<4, 4>& r) {
 	TMatrix<4, 4> ret;
 
+	// Row j of the result is r[j][0]*l[0] + r[j][1]*l[1] + r[j][2]*l[2] + r[j][3]*l[3]
+#if defined(ETR_SIMD_NEON)
+	float32x4_t l0 = vld1q_f32(l[0]);
+	float32x4_t l1 = vld1q_f32(l[1]);
+	float32x4_t l2 = vld1q_f32(l[2]);
+	float32x4_t l3 = vld1q_f32(l[3]);
+	for (int j = 0; j < 4; j++) {
+		float32x4_t row = vmulq_n_f32(l0, r[j][0]);
+		row = vmlaq_n_f32(row, l1, r[j][1]);
+		row = vmlaq_n_f32(row, l2, r[j][2]);
+		row = vmlaq_n_f32(row, l3, r[j][3]);
+		vst1q_f32(ret[j], row);
+	}
+#elif defined(ETR_SIMD_SSE)
+	__m128 l0 = _mm_loadu_ps(l[0]);
+	__m128 l1 = _mm_loadu_ps(l[1]);
+	__m128 l2 = _mm_loadu_ps(l[2]);
+	__m128 l3 = _mm_loadu_ps(l[3]);
+	for (int j = 0; j < 4; j++) {
+		__m128 row = _mm_mul_ps(l0, _mm_set1_ps(r[j][0]));
+		row = _mm_add_ps(row, _mm_mul_ps(l1, _mm_set1_ps(r[j][1])));
+		row = _mm_add_ps(row, _mm_mul_ps(l2, _mm_set1_ps(r[j][2])));
+		row = _mm_add_ps(row, _mm_mul_ps(l3, _mm_set1_ps(r[j][3])));
+		_mm_storeu_ps(ret[j], row);
+	}
+#else
 	for (int i = 0; i < 4; i++)
 		for (int j = 0; j < 4; j++)
 			ret[j][i] = l[0][i] * r[j][0] +
 			            l[1][i] * r[j][1] +
 			            l[2][i] * r[j][2] +
 			            l[3][i] * r[j][3];
+#endif
 
 	return ret;
 }
@@ -19,6 +19,19 @@ GNU General Public License for more details.
 
 #include "vectors.h"
 
+// The 4x4 matrix product and the point/vector transformations are
+// vectorized when the scalar type is float and the target offers NEON
+// or SSE. Define ETR_NO_SIMD to force the portable scalar code.
+#if !defined(ETR_NO_SIMD) && defined(USE_GLES1)
+#	if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#		define ETR_SIMD_NEON
+#		include <arm_neon.h>
+#	elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#		define ETR_SIMD_SSE
+#		include <xmmintrin.h>
+#	endif
+#endif
+
 template<int ix, int iy>
 class TMatrix {
 	ETR_DOUBLE _data[ix][iy];
@@ -24,6 +24,7 @@ GNU General Public License for more details.
 #include "winsys.h"
 //#include <GL/glu.h>
 #include <stack>
+#include <cstring>
 
 #define GLOBAL_VERTEX_INDEX_SIZE 5*(12+4+12)
 
@@ -308,7 +309,7 @@ void set_material (const TColor& diffuse_colour, const TColor& specular_colour,
 		static_cast<GLfloat>(diffuse_colour.b),
 		static_cast<GLfloat>(diffuse_colour.a)
 	};
-	glMaterialfv (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, mat_amb_diff);
+	GLMaterial (GL_AMBIENT_AND_DIFFUSE, mat_amb_diff);
 
 	GLfloat mat_specular[4] = {
 		static_cast<GLfloat>(specular_colour.r),
@@ -316,21 +317,21 @@ void set_material (const TColor& diffuse_colour, const TColor& specular_colour,
 		static_cast<GLfloat>(specular_colour.b),
 		static_cast<GLfloat>(specular_colour.a)
 	};
-	glMaterialfv (GL_FRONT_AND_BACK, GL_SPECULAR, mat_specular);
+	GLMaterial (GL_SPECULAR, mat_specular);
 
-	glMaterialf (GL_FRONT_AND_BACK, GL_SHININESS, specular_exp);
+	GLMaterial (GL_SHININESS, specular_exp);
 
 	glColor(diffuse_colour);
 }
 void ClearRenderContext () {
-	glDepthMask (GL_TRUE);
+	GLDepthMask (GL_TRUE);
 	glClearColor (colBackgr.r, colBackgr.g, colBackgr.b, colBackgr.a);
 	glClearStencil (0);
 	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 void ClearRenderContext (const TColor& col) {
-	glDepthMask (GL_TRUE);
+	GLDepthMask (GL_TRUE);
 	glClearColor (col.r, col.g, col.b, col.a);
 	glClearStencil (0);
 	glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
@@ -392,6 +393,290 @@ void Reshape (int w, int h) {
 	glMatrixMode (GL_MODELVIEW);
 }
 
+// ====================================================================
+//					GL state shadow
+// ====================================================================
+
+// the capabilities the game switches, others are passed through
+static const GLenum shadow_caps[] = {
+	GL_TEXTURE_2D, GL_DEPTH_TEST, GL_CULL_FACE, GL_LIGHTING, GL_NORMALIZE,
+	GL_ALPHA_TEST, GL_BLEND, GL_STENCIL_TEST, GL_COLOR_MATERIAL, GL_FOG,
+	GL_LINE_SMOOTH, GL_MULTISAMPLE, GL_POLYGON_OFFSET_FILL,
+	GL_LIGHT0, GL_LIGHT1, GL_LIGHT2, GL_LIGHT3,
+	GL_LIGHT4, GL_LIGHT5, GL_LIGHT6, GL_LIGHT7,
+#ifndef USE_GLES1
+	GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T,
+#endif
+};
+#define NUM_SHADOW_CAPS (sizeof(shadow_caps) / sizeof(shadow_caps[0]))
+
+// 1 or 0 for the flags, -1 and the valid flags mark unknown state, which
+// is always sent
+static struct {
+	signed char caps[NUM_SHADOW_CAPS];
+	signed char depth_mask;
+	bool blend_valid;
+	GLenum blend_src, blend_dst;
+	bool alpha_valid;
+	GLenum alpha_func;
+	GLclampf alpha_ref;
+	bool depth_func_valid;
+	GLenum depth_func;
+	bool shade_valid;
+	GLenum shade_model;
+	bool amb_diff_valid;
+	GLfloat amb_diff[4];
+	bool specular_valid;
+	GLfloat specular[4];
+	bool shininess_valid;
+	GLfloat shininess;
+	bool texture_valid;
+	GLuint texture;
+} gls = {
+	{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+	  -1, -1, -1, -1, -1, -1, -1, -1,
+#ifndef USE_GLES1
+	  -1, -1,
+#endif
+	},
+	-1, false, 0, 0, false, 0, 0, false, 0, false, 0,
+	false, {0, 0, 0, 0}, false, {0, 0, 0, 0}, false, 0,
+	true, 0		// a new context has texture 0 bound
+};
+
+// glBegin/glEnd blocks still pending must be drawn with the old state
+static inline void StateChange () {
+#ifdef USE_GLES1
+	glesFlush ();
+#endif
+}
+
+static int CapIndex (GLenum cap) {
+	for (size_t i=0; i<NUM_SHADOW_CAPS; i++)
+		if (shadow_caps[i] == cap) return (int)i;
+	return -1;
+}
+
+void GLEnable (GLenum cap) {
+	int idx = CapIndex (cap);
+	if (idx >= 0) {
+		if (gls.caps[idx] == 1) return;
+		gls.caps[idx] = 1;
+	}
+	StateChange ();
+	// from now on glColor changes the material
+	if (cap == GL_COLOR_MATERIAL) gls.amb_diff_valid = false;
+	glEnable (cap);
+}
+
+void GLDisable (GLenum cap) {
+	int idx = CapIndex (cap);
+	if (idx >= 0) {
+		if (gls.caps[idx] == 0) return;
+		gls.caps[idx] = 0;
+	}
+	StateChange ();
+	glDisable (cap);
+}
+
+bool GLIsEnabled (GLenum cap) {
+	int idx = CapIndex (cap);
+	if (idx < 0) return glIsEnabled (cap) == GL_TRUE;
+	if (gls.caps[idx] < 0) gls.caps[idx] = glIsEnabled (cap) == GL_TRUE ? 1 : 0;
+	return gls.caps[idx] == 1;
+}
+
+void GLBlendFunc (GLenum sfactor, GLenum dfactor) {
+	if (gls.blend_valid && gls.blend_src == sfactor && gls.blend_dst == dfactor)
+		return;
+	StateChange ();
+	gls.blend_valid = true;
+	gls.blend_src = sfactor;
+	gls.blend_dst = dfactor;
+	glBlendFunc (sfactor, dfactor);
+}
+
+void GLGetBlendFunc (GLenum *sfactor, GLenum *dfactor) {
+	if (!gls.blend_valid) {
+		GLint src, dst;
+		glGetIntegerv (GL_BLEND_SRC, &src);
+		glGetIntegerv (GL_BLEND_DST, &dst);
+		gls.blend_valid = true;
+		gls.blend_src = (GLenum)src;
+		gls.blend_dst = (GLenum)dst;
+	}
+	*sfactor = gls.blend_src;
+	*dfactor = gls.blend_dst;
+}
+
+void GLAlphaFunc (GLenum func, GLclampf ref) {
+	if (gls.alpha_valid && gls.alpha_func == func && gls.alpha_ref == ref)
+		return;
+	StateChange ();
+	gls.alpha_valid = true;
+	gls.alpha_func = func;
+	gls.alpha_ref = ref;
+	glAlphaFunc (func, ref);
+}
+
+void GLDepthFunc (GLenum func) {
+	if (gls.depth_func_valid && gls.depth_func == func) return;
+	StateChange ();
+	gls.depth_func_valid = true;
+	gls.depth_func = func;
+	glDepthFunc (func);
+}
+
+void GLDepthMask (GLboolean flag) {
+	signed char mask = flag ? 1 : 0;
+	if (gls.depth_mask == mask) return;
+	StateChange ();
+	gls.depth_mask = mask;
+	glDepthMask (flag);
+}
+
+void GLShadeModel (GLenum mode) {
+	if (gls.shade_valid && gls.shade_model == mode) return;
+	StateChange ();
+	gls.shade_valid = true;
+	gls.shade_model = mode;
+	glShadeModel (mode);
+}
+
+static bool SameColor (bool valid, const GLfloat *a, const GLfloat *b) {
+	return valid && a[0] == b[0] && a[1] == b[1] && a[2] == b[2] && a[3] == b[3];
+}
+
+void GLMaterial (GLenum pname, const GLfloat *params) {
+	switch (pname) {
+		case GL_AMBIENT_AND_DIFFUSE:
+			if (SameColor (gls.amb_diff_valid, gls.amb_diff, params)) return;
+			memcpy (gls.amb_diff, params, sizeof(gls.amb_diff));
+			// with color material the next glColor overwrites it
+			gls.amb_diff_valid = gls.caps[CapIndex (GL_COLOR_MATERIAL)] == 0;
+			break;
+		case GL_SPECULAR:
+			if (SameColor (gls.specular_valid, gls.specular, params)) return;
+			memcpy (gls.specular, params, sizeof(gls.specular));
+			gls.specular_valid = true;
+			break;
+		case GL_SHININESS:
+			GLMaterial (pname, params[0]);
+			return;
+		default:
+			break;
+	}
+	StateChange ();
+	glMaterialfv (GL_FRONT_AND_BACK, pname, params);
+}
+
+void GLMaterial (GLenum pname, GLfloat param) {
+	if (pname == GL_SHININESS) {
+		if (gls.shininess_valid && gls.shininess == param) return;
+		gls.shininess_valid = true;
+		gls.shininess = param;
+	}
+	StateChange ();
+	glMaterialf (GL_FRONT_AND_BACK, pname, param);
+}
+
+void InvalidateGLState () {
+	for (size_t i=0; i<NUM_SHADOW_CAPS; i++) gls.caps[i] = -1;
+	gls.depth_mask = -1;
+	gls.blend_valid = false;
+	gls.alpha_valid = false;
+	gls.depth_func_valid = false;
+	gls.shade_valid = false;
+	gls.amb_diff_valid = false;
+	gls.specular_valid = false;
+	gls.shininess_valid = false;
+	gls.texture_valid = false;
+}
+
+void BindTexture (GLuint id) {
+	if (gls.texture_valid && gls.texture == id) return;
+	StateChange ();
+	glBindTexture (GL_TEXTURE_2D, id);
+	gls.texture_valid = true;
+	gls.texture = id;
+}
+
+void DeleteTextures (GLsizei n, const GLuint *ids) {
+	// GL falls back to texture 0 when the bound texture is deleted, and the
+	// name may be handed out again by glGenTextures
+	for (GLsizei i=0; i<n; i++)
+		if (ids[i] == gls.texture) gls.texture = 0;
+	glDeleteTextures (n, ids);
+}
+
+// ====================================================================
+//					GL statistics
+// ====================================================================
+
+// one bucket per render mode, the first one for RM_UNINITIALIZED
+#define NUM_STATS_MODES (TRACK_MARKS + 2)
+
+static const char *stats_mode_names[NUM_STATS_MODES] = {
+	"none", "gui", "gauge bars", "texfont", "course", "trees", "particles",
+	"tux", "tux shadow", "sky", "fog plane", "track marks"
+};
+
+static TGLCounts stats_frame[NUM_STATS_MODES];
+static TGLCounts stats_last[NUM_STATS_MODES];
+TGLCounts *glcounts = &stats_frame[0];
+
+static void AddCounts (TGLCounts& sum, const TGLCounts& c) {
+	sum.draws += c.draws;
+	sum.vertices += c.vertices;
+	sum.binds += c.binds;
+	sum.enables += c.enables;
+	sum.matrix_ops += c.matrix_ops;
+}
+
+void GLStatsEndFrame () {
+	memcpy (stats_last, stats_frame, sizeof(stats_last));
+	memset (stats_frame, 0, sizeof(stats_frame));
+}
+
+const TGLCounts& GLStats (TRenderMode mode) {
+	return stats_last[mode + 1];
+}
+
+TGLCounts GLStatsTotal () {
+	TGLCounts sum;
+	memset (&sum, 0, sizeof(sum));
+	for (int i=0; i<NUM_STATS_MODES; i++) AddCounts (sum, stats_last[i]);
+	return sum;
+}
+
+static string StatsLine (const char *name, const TGLCounts& c) {
+	char line[128];
+	snprintf (line, sizeof(line), "%-12s %6u %8u %6u %7u %7u", name,
+		c.draws, c.vertices, c.binds, c.enables, c.matrix_ops);
+	return line;
+}
+
+string GLStatsReport () {
+	string report = "mode          draws vertices  binds enables  matrix\n";
+	for (int i=0; i<NUM_STATS_MODES; i++) {
+		const TGLCounts& c = stats_last[i];
+		if (c.draws || c.binds || c.enables || c.matrix_ops)
+			report += StatsLine (stats_mode_names[i], c) + '\n';
+	}
+	report += StatsLine ("total", GLStatsTotal ()) + '\n';
+	return report;
+}
+
+void GLStatsLog () {
+	string report = GLStatsReport ();
+	size_t oldpos = 0;
+	size_t pos;
+	while ((pos = report.find ('\n', oldpos)) != string::npos) {
+		Message (report.substr (oldpos, pos - oldpos));
+		oldpos = pos + 1;
+	}
+}
+
 // ====================================================================
 //					GL options
 // ====================================================================
@@ -399,44 +684,47 @@ void Reshape (int w, int h) {
 TRenderMode currentMode = RM_UNINITIALIZED;
 void set_gl_options (TRenderMode mode) {
 	currentMode = mode;
+	// pending glBegin blocks still belong to the old mode
+	StateChange ();
+	glcounts = &stats_frame[mode + 1];
 	switch (mode) {
 		case GUI:
-			glEnable (GL_TEXTURE_2D);
-			glDisable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLDisable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
-			glDisable (GL_FOG);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
+			GLDisable (GL_FOG);
 			break;
 
 		case GAUGE_BARS:
-			glEnable (GL_TEXTURE_2D);
-			glDisable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLDisable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glEnable (GL_TEXTURE_GEN_S);
-			glEnable (GL_TEXTURE_GEN_T);
+			GLEnable (GL_TEXTURE_GEN_S);
+			GLEnable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 
 #ifndef USE_GLES1
 			glTexGeni (GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
@@ -445,41 +733,41 @@ void set_gl_options (TRenderMode mode) {
 			break;
 
 		case TEXFONT:
-			glEnable (GL_TEXTURE_2D);
-			glDisable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLDisable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 			break;
 
 		case COURSE:
-			glEnable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glEnable (GL_CULL_FACE);
-			glEnable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLEnable (GL_CULL_FACE);
+			GLEnable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glEnable (GL_TEXTURE_GEN_S);
-			glEnable (GL_TEXTURE_GEN_T);
+			GLEnable (GL_TEXTURE_GEN_S);
+			GLEnable (GL_TEXTURE_GEN_T);
 #endif
-			glEnable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LEQUAL);
+			GLEnable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LEQUAL);
 
 #ifndef USE_GLES1
 			glTexGeni (GL_S, GL_TEXTURE_GEN_MODE, GL_OBJECT_LINEAR);
@@ -488,145 +776,145 @@ void set_gl_options (TRenderMode mode) {
 			break;
 
 		case TREES:
-			glEnable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glEnable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glEnable (GL_ALPHA_TEST);
-			glDisable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLEnable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLEnable (GL_ALPHA_TEST);
+			GLDisable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 
-			glAlphaFunc (GL_GEQUAL, 0.5);
+			GLAlphaFunc (GL_GEQUAL, 0.5);
 			break;
 
 		case PARTICLES:
-			glEnable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glEnable (GL_ALPHA_TEST);
-			glDisable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLEnable (GL_ALPHA_TEST);
+			GLDisable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 
-			glAlphaFunc (GL_GEQUAL, 0.5);
+			GLAlphaFunc (GL_GEQUAL, 0.5);
 			break;
 
 		case SKY:
-			glEnable (GL_TEXTURE_2D);
-			glDisable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glDisable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLEnable (GL_TEXTURE_2D);
+			GLDisable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLDisable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_FALSE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_FALSE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 			break;
 
 		case FOG_PLANE:
-			glDisable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLDisable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 			break;
 
 		case TUX:
-			glDisable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glEnable (GL_CULL_FACE);
-			glEnable (GL_LIGHTING);
-			glEnable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
+			GLDisable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLEnable (GL_CULL_FACE);
+			GLEnable (GL_LIGHTING);
+			GLEnable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDisable (GL_COLOR_MATERIAL);
-			glDepthMask (GL_TRUE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLDepthMask (GL_TRUE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 			break;
 
 		case TUX_SHADOW:
-			glDisable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glDisable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_COLOR_MATERIAL);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LESS);
+			GLDisable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLDisable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_COLOR_MATERIAL);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LESS);
 #ifdef USE_STENCIL_BUFFER
-			glDisable (GL_CULL_FACE);
-			glEnable (GL_STENCIL_TEST);
-			glDepthMask (GL_FALSE);
+			GLDisable (GL_CULL_FACE);
+			GLEnable (GL_STENCIL_TEST);
+			GLDepthMask (GL_FALSE);
 
 			glStencilFunc (GL_EQUAL, 0, ~0);
 			glStencilOp (GL_KEEP, GL_KEEP, GL_INCR);
 #else
-			glEnable (GL_CULL_FACE);
-			glDisable (GL_STENCIL_TEST);
-			glDepthMask (GL_TRUE);
+			GLEnable (GL_CULL_FACE);
+			GLDisable (GL_STENCIL_TEST);
+			GLDepthMask (GL_TRUE);
 #endif
 			break;
 
 		case TRACK_MARKS:
-			glEnable (GL_TEXTURE_2D);
-			glEnable (GL_DEPTH_TEST);
-			glDisable (GL_CULL_FACE);
-			glEnable (GL_LIGHTING);
-			glDisable (GL_NORMALIZE);
-			glDisable (GL_ALPHA_TEST);
-			glEnable (GL_BLEND);
-			glDisable (GL_STENCIL_TEST);
-			glDisable (GL_COLOR_MATERIAL);
+			GLEnable (GL_TEXTURE_2D);
+			GLEnable (GL_DEPTH_TEST);
+			GLDisable (GL_CULL_FACE);
+			GLEnable (GL_LIGHTING);
+			GLDisable (GL_NORMALIZE);
+			GLDisable (GL_ALPHA_TEST);
+			GLEnable (GL_BLEND);
+			GLDisable (GL_STENCIL_TEST);
+			GLDisable (GL_COLOR_MATERIAL);
 #ifndef USE_GLES1
-			glDisable (GL_TEXTURE_GEN_S);
-			glDisable (GL_TEXTURE_GEN_T);
+			GLDisable (GL_TEXTURE_GEN_S);
+			GLDisable (GL_TEXTURE_GEN_T);
 #endif
-			glDepthMask (GL_FALSE);
-			glShadeModel (GL_SMOOTH);
-			glDepthFunc (GL_LEQUAL);
+			GLDepthMask (GL_FALSE);
+			GLShadeModel (GL_SMOOTH);
+			GLDepthFunc (GL_LEQUAL);
 			break;
 
 		default:
@@ -720,14 +1008,17 @@ void PopRenderMode() {
 
 
 void glColor(const TColor& col) {
+	StateChange ();
 	glColor4d(col.r, col.g, col.b, col.a);
 }
 
 void glColor(const TColor& col, ETR_DOUBLE alpha) {
+	StateChange ();
 	glColor4d(col.r, col.g, col.b, alpha);
 }
 
 void glTranslate(const TVector3d& vec) {
+	StateChange ();
 	glTranslated(vec.x, vec.y, vec.z);
 }
 
@@ -744,5 +1035,6 @@ void glTexCoord2(const TVector2d& vec) {
 }
 
 void glMultMatrix(const TMatrix<4, 4>& mat) {
+	StateChange ();
 	glMultMatrixd((const ETR_DOUBLE*)mat.data());
 }
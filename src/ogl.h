@@ -68,6 +68,47 @@ void set_material (const TColor& diffuse_colour,
                    const TColor& specular_colour,
                    float specular_exp);
 
+// --------------------------------------------------------------------
+//				GL state shadow
+// --------------------------------------------------------------------
+
+// The game keeps a copy of the fixed function state it changes, calls that
+// wouldn't change anything are dropped before they reach the driver. This
+// state must only be changed through these functions, InvalidateGLState
+// forgets the copy when that can't be guaranteed (new context, the real
+// glPopAttrib of desktop GL). Materials are always set for both faces.
+void GLEnable (GLenum cap);
+void GLDisable (GLenum cap);
+void GLBlendFunc (GLenum sfactor, GLenum dfactor);
+void GLAlphaFunc (GLenum func, GLclampf ref);
+void GLDepthFunc (GLenum func);
+void GLDepthMask (GLboolean flag);
+void GLShadeModel (GLenum mode);
+void GLMaterial (GLenum pname, const GLfloat *params);
+void GLMaterial (GLenum pname, GLfloat param);
+void InvalidateGLState ();
+
+// read the shadow, GL is only asked while the state is unknown
+bool GLIsEnabled (GLenum cap);
+void GLGetBlendFunc (GLenum *sfactor, GLenum *dfactor);
+
+// All texture binds go through here, so the cached binding stays valid
+void BindTexture (GLuint id);
+void DeleteTextures (GLsizei n, const GLuint *ids);
+
+
+// --------------------------------------------------------------------
+//				GL statistics
+// --------------------------------------------------------------------
+
+// The calls counted by glstats.h, per render mode. The counts of the
+// previous frame can be read while the next one is drawn.
+void GLStatsEndFrame ();	// once per frame, by Winsys.SwapBuffers
+const TGLCounts& GLStats (TRenderMode mode);
+TGLCounts GLStatsTotal ();
+string GLStatsReport ();	// a table of the previous frame
+void GLStatsLog ();			// the table to the console
+
 
 void PushRenderMode(TRenderMode mode);
 void PopRenderMode();
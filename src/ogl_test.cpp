@@ -39,7 +39,7 @@ static const TLight light = {
 
 void SetTestLight () {
 	light.Enable(GL_LIGHT0);
-	glEnable(GL_LIGHTING);
+	GLEnable(GL_LIGHTING);
 }
 
 
@@ -1,5 +1,6 @@
 #include "bh.h"
-#include <cstdlib>
+#include "ogl.h"
+#include <vector>
 /*
 This is an limited implementation based on this game need.
 Only these flags are managed :
@@ -12,118 +13,125 @@ GL_MULTISAMPLE flag
 GL_POLYGON_OFFSET_FILL flag
 GL_TEXTURE_2D flag
 GL_LIGHTING flag
-GL_LIGHTi where 0 <= i < GL_MAX_LIGHTS
+GL_LIGHTi where 0 <= i < 8
+GL_FOG, GL_NORMALIZE, GL_STENCIL_TEST and GL_COLOR_MATERIAL flags
+and with GL_COLOR_BUFFER_BIT the blend function.
+
+The flags are taken from the state shadow in ogl.cpp instead of asking
+the driver, and the stack has a fixed size like the one of desktop GL.
 */
 
-typedef struct node
-{
-	unsigned int data;
-	struct node * next;
-} node;
+static const GLenum attrib_flags[] = {
+	GL_ALPHA_TEST, GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_LINE_SMOOTH,
+	GL_MULTISAMPLE, GL_POLYGON_OFFSET_FILL, GL_TEXTURE_2D, GL_LIGHTING,
+	GL_LIGHT0, GL_LIGHT1, GL_LIGHT2, GL_LIGHT3,
+	GL_LIGHT4, GL_LIGHT5, GL_LIGHT6, GL_LIGHT7,
+	GL_FOG, GL_NORMALIZE, GL_STENCIL_TEST, GL_COLOR_MATERIAL
+};
+#define NUM_ATTRIB_FLAGS (sizeof(attrib_flags) / sizeof(attrib_flags[0]))
+#define ATTRIB_STACK_DEPTH 16
 
-node * stackTop = NULL;
+struct TAttribs {
+	unsigned int flags;		// bit i = attrib_flags[i]
+	bool blend_func;
+	GLenum blend_src;
+	GLenum blend_dst;
+};
 
-#define PUSHFLAG(a)                     \
-        glGetBooleanv(a, &b);           \
-        if (b == GL_TRUE) n->data++;    \
-        n->data = n->data<<1;
-#define POPFLAG(a)                      \
-        c->data = c->data>>1;           \
-        if ((c->data & 1) > 0)            \
-                glEnable(a);            \
-        else                            \
-                glDisable(a);
+static TAttribs attrib_stack[ATTRIB_STACK_DEPTH];
+static int attrib_depth = 0;	// can exceed ATTRIB_STACK_DEPTH, see glPushAttrib
 
 void glPushAttrib(int t)
 {
-        static node     *n;
-        GLboolean       b;
-        GLint           ln;
-        n = (node*)calloc(1, sizeof(node));
-        glGetIntegerv(GL_MAX_LIGHTS, &ln);      // 8 for current SGX
-
-        n->data = 0;
-        PUSHFLAG(GL_ALPHA_TEST)
-        PUSHFLAG(GL_BLEND)
-        PUSHFLAG(GL_CULL_FACE)
-        PUSHFLAG(GL_DEPTH_TEST)
-        PUSHFLAG(GL_LINE_SMOOTH)
-        PUSHFLAG(GL_MULTISAMPLE)
-        PUSHFLAG(GL_POLYGON_OFFSET_FILL)
-        PUSHFLAG(GL_TEXTURE_2D)
-        PUSHFLAG(GL_LIGHTING)
-
-        for(GLint i=0;i<ln;i++)
-        {
-                PUSHFLAG(GL_LIGHT0+i)
-        }
-        //printf("glPushAttrib : %d\n", n->data);
-
-        n->next = stackTop;
-        stackTop = n;
+	// a push on the full stack is ignored, and so is its pop
+	if (attrib_depth >= ATTRIB_STACK_DEPTH) {
+		attrib_depth++;
+		return;
+	}
+	TAttribs& a = attrib_stack[attrib_depth++];
+	a.flags = 0;
+	for (size_t i=0; i<NUM_ATTRIB_FLAGS; i++)
+		if (GLIsEnabled (attrib_flags[i])) a.flags |= 1u << i;
+	a.blend_func = (t & GL_COLOR_BUFFER_BIT) != 0;
+	if (a.blend_func) GLGetBlendFunc (&a.blend_src, &a.blend_dst);
 }
 
 void glPopAttrib()
 {
-        GLint           ln;
-        node * c = stackTop;
-        if (c == NULL)
-                return;
-        glGetIntegerv(GL_MAX_LIGHTS, &ln);
-        //printf("glPopAttrib  : %d\n", c->data);
-
-        for(GLint i=ln-1;i>=0;i--)
-        {
-                POPFLAG(GL_LIGHT0+i)
-        }
-        POPFLAG(GL_LIGHTING)
-        POPFLAG(GL_TEXTURE_2D)
-        POPFLAG(GL_POLYGON_OFFSET_FILL)
-        POPFLAG(GL_MULTISAMPLE)
-        POPFLAG(GL_LINE_SMOOTH)
-        POPFLAG(GL_DEPTH_TEST)
-        POPFLAG(GL_CULL_FACE)
-        POPFLAG(GL_BLEND)
-        POPFLAG(GL_ALPHA_TEST)
-
-        stackTop = c->next;
-        free(c);
+	if (attrib_depth == 0)
+		return;
+	if (attrib_depth-- > ATTRIB_STACK_DEPTH)
+		return;
+	const TAttribs& a = attrib_stack[attrib_depth];
+	for (size_t i=0; i<NUM_ATTRIB_FLAGS; i++) {
+		if (a.flags & (1u << i)) GLEnable (attrib_flags[i]);
+		else GLDisable (attrib_flags[i]);
+	}
+	if (a.blend_func) GLBlendFunc (a.blend_src, a.blend_dst);
 }
 
 // emulation of glBegin/glEnd and other opengl calls in opengl-es
+//
+// The floats of the current glBegin/glEnd block are collected in block.
+// glEnd turns triangles, strips and fans into indexed triangles in the
+// stream, which is drawn with one glDrawElements by glesFlush. Outside of
+// glesBeginBatch/glesEndBatch that happens at once. Inside, the stream
+// grows until the vertex format changes, it is full or the state shadow
+// in ogl.cpp is about to change something, so consecutive blocks are
+// drawn together. The buffers keep their size, after the first frames
+// nothing is allocated any more.
+
+#define STREAM_STRIDE 5			// x, y, z, s, t
+#define STREAM_MAX_VERTICES 65536	// GLushort indices
 
-GLfloat* globalvertexbuffer = new GLfloat[1024];
-int globalvertexbuffersize = 1024;
-int globalvertexbuffercurpos = 0;
-GLenum globalvertexmodemode;
-bool globalvertexhastexturecoordinates;
-bool globalvertextexturecoordinatesfirst;
-int glesGetGlobalVertexBufferCurPos()
+static vector<GLfloat> block;
+static GLenum blockmode;
+static bool blockhastexcoords;
+static bool blocktexcoordsfirst;
+
+static vector<GLfloat> stream;
+static vector<GLushort> streamindices;
+static bool streamhastexcoords;
+static int batchdepth = 0;
+
+void glesFlush()
 {
-	return globalvertexbuffercurpos;
+	if (streamindices.empty())
+		return;
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, STREAM_STRIDE*sizeof(GLfloat), &stream[0]);
+	if (streamhastexcoords)
+	{
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glTexCoordPointer(2, GL_FLOAT, STREAM_STRIDE*sizeof(GLfloat), &stream[3]);
+	}
+	glDrawElements(GL_TRIANGLES, (GLsizei)streamindices.size(), GL_UNSIGNED_SHORT, &streamindices[0]);
+
+	glDisableClientState(GL_VERTEX_ARRAY);
+	if (streamhastexcoords)
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	stream.clear();
+	streamindices.clear();
 }
-void glesSetGlobalVertexBufferCurPos(int pos)
+
+void glesBeginBatch()
 {
-	globalvertexbuffercurpos = pos;
+	batchdepth++;
 }
 
-GLfloat* glesGetGlobalVertexBuffer(int minsize)
+void glesEndBatch()
 {
-	if (globalvertexbuffersize < minsize)
-	{
-		globalvertexbuffer=(GLfloat*)realloc(globalvertexbuffer,(minsize+minsize/2)*sizeof(GLfloat));
-		globalvertexbuffersize = minsize+minsize/2;
-	}
-	return globalvertexbuffer;
+	if (--batchdepth == 0)
+		glesFlush();
 }
+
 void glesCleanUp()
 {
-	if (globalvertexbuffer != NULL)
-		delete globalvertexbuffer;
-	globalvertexbuffer = NULL;
+	vector<GLfloat>().swap(block);
+	vector<GLfloat>().swap(stream);
+	vector<GLushort>().swap(streamindices);
 }
 
-
 void glLightModeli(GLenum pname, GLint param)
 {
     glLightModelf(pname, param);
@@ -131,13 +139,10 @@ void glLightModeli(GLenum pname, GLint param)
 
 void glTexCoord2f(GLfloat s, GLfloat t)
 {
-	globalvertexhastexturecoordinates=true;
-	int curpos = glesGetGlobalVertexBufferCurPos();
-	if (curpos == 0) globalvertextexturecoordinatesfirst = true;
-	GLfloat* buf = glesGetGlobalVertexBuffer(curpos+2);
-	buf[curpos++]=s;
-	buf[curpos++]=t;
-	glesSetGlobalVertexBufferCurPos(curpos);
+	blockhastexcoords=true;
+	if (block.empty()) blocktexcoordsfirst = true;
+	block.push_back(s);
+	block.push_back(t);
 }
 
 GLuint glGenLists(GLsizei range)
@@ -153,33 +158,109 @@ void glDeleteLists(GLuint list, GLsizei range)
 
 void glBegin(GLenum mode)
 {
-	glesSetGlobalVertexBufferCurPos(0);
-	globalvertexmodemode = mode;
-	globalvertexhastexturecoordinates = false;
-	globalvertextexturecoordinatesfirst = false;
+	block.clear();
+	blockmode = mode;
+	blockhastexcoords = false;
+	blocktexcoordsfirst = false;
 }
 
-
-void glEnd()
+// drawn directly, without the stream
+static void DrawBlock(int stride)
 {
-	GLfloat* buf = glesGetGlobalVertexBuffer(0);
-	int stride = globalvertexhastexturecoordinates ? 5 : 3;
+	const GLfloat* buf = &block[0];
 	glEnableClientState(GL_VERTEX_ARRAY);
-	if (globalvertexhastexturecoordinates)
+	if (blockhastexcoords)
 	{
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glTexCoordPointer(2, GL_FLOAT, stride*sizeof(GLfloat), globalvertextexturecoordinatesfirst ? buf : buf+3);
+		glTexCoordPointer(2, GL_FLOAT, stride*sizeof(GLfloat), blocktexcoordsfirst ? buf : buf+3);
 	}
-	glVertexPointer(3, GL_FLOAT, stride*sizeof(GLfloat), globalvertextexturecoordinatesfirst ? buf+2 : buf);
-	glDrawArrays(globalvertexmodemode,0,glesGetGlobalVertexBufferCurPos()/stride);
+	glVertexPointer(3, GL_FLOAT, stride*sizeof(GLfloat), blocktexcoordsfirst ? buf+2 : buf);
+	glDrawArrays(blockmode,0,(GLsizei)(block.size()/stride));
 
 	glDisableClientState(GL_VERTEX_ARRAY);
-	if (globalvertexhastexturecoordinates)
+	if (blockhastexcoords)
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 }
 
+void glEnd()
+{
+	int stride = blockhastexcoords ? 5 : 3;
+	size_t count = block.size() / stride;
+	// lines and points, and blocks too big for GLushort indices
+	if ((blockmode != GL_TRIANGLES && blockmode != GL_TRIANGLE_STRIP && blockmode != GL_TRIANGLE_FAN)
+	        || count > STREAM_MAX_VERTICES)
+	{
+		glesFlush();
+		if (count > 0) DrawBlock(stride);
+		return;
+	}
+	if (count < 3)
+		return;
+
+	if (!streamindices.empty() && (streamhastexcoords != blockhastexcoords
+	        || stream.size() / STREAM_STRIDE + count > STREAM_MAX_VERTICES))
+		glesFlush();
+	streamhastexcoords = blockhastexcoords;
+
+	// the vertices in the layout of the stream, a block has the texture
+	// coordinates either before or after each vertex
+	GLushort base = (GLushort)(stream.size() / STREAM_STRIDE);
+	for (size_t i=0; i<count; i++)
+	{
+		const GLfloat* v = &block[i * stride];
+		const GLfloat* pos = blocktexcoordsfirst && blockhastexcoords ? v+2 : v;
+		stream.push_back(pos[0]);
+		stream.push_back(pos[1]);
+		stream.push_back(pos[2]);
+		if (blockhastexcoords)
+		{
+			const GLfloat* tex = blocktexcoordsfirst ? v : v+3;
+			stream.push_back(tex[0]);
+			stream.push_back(tex[1]);
+		}
+		else
+		{
+			stream.push_back(0);
+			stream.push_back(0);
+		}
+	}
+
+	// the triangles, with the same winding as the strip or fan
+	switch (blockmode)
+	{
+	case GL_TRIANGLES:
+		for (size_t i=0; i+2<count; i+=3)
+		{
+			streamindices.push_back(base+i);
+			streamindices.push_back(base+i+1);
+			streamindices.push_back(base+i+2);
+		}
+		break;
+	case GL_TRIANGLE_STRIP:
+		for (size_t i=0; i+2<count; i++)
+		{
+			streamindices.push_back(base+i+(i&1));
+			streamindices.push_back(base+i+1-(i&1));
+			streamindices.push_back(base+i+2);
+		}
+		break;
+	case GL_TRIANGLE_FAN:
+		for (size_t i=1; i+1<count; i++)
+		{
+			streamindices.push_back(base);
+			streamindices.push_back(base+i);
+			streamindices.push_back(base+i+1);
+		}
+		break;
+	}
+
+	if (batchdepth == 0)
+		glesFlush();
+}
+
 void glRectf(GLfloat x, GLfloat y, GLfloat w, GLfloat h)
 {
+	glesFlush();
 	GLfloat vtx1[] = { x, y,   x, h,   w, h, w, y};
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glVertexPointer(2, GL_SHORT, 0, vtx1);
@@ -189,12 +270,9 @@ void glRectf(GLfloat x, GLfloat y, GLfloat w, GLfloat h)
 
 void glVertex3f(GLfloat x, GLfloat y, GLfloat z)
 {
-	int curpos = glesGetGlobalVertexBufferCurPos();
-	GLfloat* buf = glesGetGlobalVertexBuffer(curpos+3);
-	buf[curpos++]=x;
-	buf[curpos++]=y;
-	buf[curpos++]=z;
-	glesSetGlobalVertexBufferCurPos(curpos);
+	block.push_back(x);
+	block.push_back(y);
+	block.push_back(z);
 }
 void glVertex2f(GLfloat x, GLfloat y)
 {
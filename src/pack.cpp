@@ -0,0 +1,217 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "pack.h"
+#include <sys/stat.h>
+#include <fstream>
+#include <cstring>
+#if defined(OS_WIN32_MSC) || defined(OS_WIN32_MINGW)
+#define PACK_NO_MMAP
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+CAssetPack Pack;
+
+static inline size_t ReadLE32 (const unsigned char *p) {
+	return (size_t)p[0] | ((size_t)p[1] << 8) | ((size_t)p[2] << 16) | ((size_t)p[3] << 24);
+}
+
+static inline size_t ReadLE16 (const unsigned char *p) {
+	return (size_t)p[0] | ((size_t)p[1] << 8);
+}
+
+// --------------------------------------------------------------------
+//				class CAssetPack
+// --------------------------------------------------------------------
+
+CAssetPack::CAssetPack () {
+	base = NULL;
+	length = 0;
+}
+
+CAssetPack::~CAssetPack () {
+	Close ();
+}
+
+bool CAssetPack::Open (const string& packfile, const string& dir) {
+	Close ();
+#ifdef PACK_NO_MMAP
+	ifstream file (packfile.c_str(), ios_base::in | ios_base::binary);
+	if (!file) return false;
+	file.seekg (0, ios_base::end);
+	streamoff len = file.tellg();
+	if (len <= 0) return false;
+	length = (size_t)len;
+	base = new unsigned char[length];
+	file.seekg (0, ios_base::beg);
+	if (!file.read (reinterpret_cast<char*>(base), length)) {
+		Close ();
+		return false;
+	}
+#else
+	int fd = open (packfile.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat (fd, &info) != 0 || info.st_size <= 0) {
+		close (fd);
+		return false;
+	}
+	length = (size_t)info.st_size;
+	void *mem = mmap (NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+	close (fd);		// the mapping stays valid
+	if (mem == MAP_FAILED) {
+		Message ("could not map", packfile);
+		length = 0;
+		return false;
+	}
+	base = static_cast<unsigned char*>(mem);
+#endif
+
+	root = dir + SEP;
+	if (!ReadIndex ()) {
+		Message ("invalid pack file", packfile);
+		Close ();
+		return false;
+	}
+	return true;
+}
+
+bool CAssetPack::ReadIndex () {
+	if (length < 16 || memcmp (base, PACK_MAGIC, 8) != 0) return false;
+	size_t count = ReadLE32 (base + 8);
+	size_t pos = 16;
+	for (size_t i=0; i<count; i++) {
+		if (pos + 10 > length) return false;
+		TEntry entry;
+		entry.offset = ReadLE32 (base + pos);
+		entry.size = ReadLE32 (base + pos + 4);
+		size_t namelen = ReadLE16 (base + pos + 8);
+		pos += 10;
+		if (pos + namelen > length) return false;
+		if (entry.offset > length || entry.size > length - entry.offset) return false;
+		entries[string (reinterpret_cast<const char*>(base + pos), namelen)] = entry;
+		pos += namelen;
+	}
+	return true;
+}
+
+void CAssetPack::Close () {
+	if (base != NULL) {
+#ifdef PACK_NO_MMAP
+		delete[] base;
+#else
+		munmap (base, length);
+#endif
+	}
+	base = NULL;
+	length = 0;
+	entries.clear();
+}
+
+// the name in the index: relative to the root, '/' separated, without
+// empty or "." parts
+bool CAssetPack::MakeName (const string& path, string& name) const {
+	if (path.compare (0, root.size(), root) != 0) return false;
+	name.clear();
+	size_t pos = root.size();
+	while (pos <= path.size()) {
+		size_t end = path.find_first_of ("/\\", pos);
+		if (end == string::npos) end = path.size();
+		size_t len = end - pos;
+		if (len == 2 && path.compare (pos, 2, "..") == 0) {
+			size_t slash = name.rfind ('/');
+			if (name.empty()) return false;		// outside the root
+			name.erase (slash == string::npos ? 0 : slash);
+		} else if (len > 0 && !(len == 1 && path[pos] == '.')) {
+			if (!name.empty()) name += '/';
+			name.append (path, pos, len);
+		}
+		pos = end + 1;
+	}
+	return !name.empty();
+}
+
+bool CAssetPack::Find (const string& path, const unsigned char *&data, size_t &size) const {
+	if (base == NULL) return false;
+	string name;
+	if (!MakeName (path, name)) return false;
+	map<string, TEntry>::const_iterator it = entries.find (name);
+	if (it == entries.end()) return false;
+	data = base + it->second.offset;
+	size = it->second.size;
+	return true;
+}
+
+bool CAssetPack::HasDir (const string& path) const {
+	if (base == NULL) return false;
+	string name;
+	if (!MakeName (path, name)) return false;
+	name += '/';
+	map<string, TEntry>::const_iterator it = entries.lower_bound (name);
+	return it != entries.end() && it->first.compare (0, name.size(), name) == 0;
+}
+
+// --------------------------------------------------------------------
+//				virtual files
+// --------------------------------------------------------------------
+
+bool CVFile::Open (const string& path) {
+	buffer.clear();
+	data = NULL;
+	size = 0;
+	if (Pack.Find (path, data, size)) return true;
+
+	// ifstream opens a directory and gives it a bogus length
+	struct stat st;
+	if (stat (path.c_str(), &st) != 0 || !S_ISREG (st.st_mode)) return false;
+	ifstream file (path.c_str(), ios_base::in | ios_base::binary);
+	if (!file) return false;
+	file.seekg (0, ios_base::end);
+	streamoff len = file.tellg();
+	if (len < 0) return false;
+	buffer.resize ((size_t)len);
+	file.seekg (0, ios_base::beg);
+	if (len > 0 && !file.read (reinterpret_cast<char*>(&buffer[0]), len)) {
+		buffer.clear();
+		return false;
+	}
+	data = buffer.empty() ? NULL : &buffer[0];
+	size = buffer.size();
+	return true;
+}
+
+bool VFileExists (const string& path) {
+	const unsigned char *data;
+	size_t size;
+	if (Pack.Find (path, data, size)) return true;
+	struct stat info;
+	return stat (path.c_str(), &info) == 0;
+}
+
+SDL_RWops *VFileRW (const string& path) {
+	const unsigned char *data;
+	size_t size;
+	if (Pack.Find (path, data, size))
+		return SDL_RWFromConstMem (data, (int)size);
+	return SDL_RWFromFile (path.c_str(), "rb");
+}
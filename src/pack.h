@@ -0,0 +1,99 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef PACK_H
+#define PACK_H
+
+#include "bh.h"
+#include <SDL2/SDL.h>
+#include <vector>
+#include <map>
+
+// --------------------------------------------------------------------
+//				class CAssetPack
+// --------------------------------------------------------------------
+
+// The data directory can be shipped as one archive (data/data.pack, built
+// by tools/mkpack.cpp), which is mapped into memory at startup instead of
+// opening hundreds of small files. Files that aren't in the pack are read
+// from the disk as before.
+//
+// Format, all numbers little endian:
+//   "ETRPACK1", u32 number of files, u32 0
+//   per file: u32 offset, u32 size, u16 name length, name
+//   file data, each file starting at a multiple of PACK_ALIGN
+// The names are relative to the packed directory and separated by '/'.
+
+#define PACK_MAGIC "ETRPACK1"
+#define PACK_ALIGN 16
+
+class CAssetPack {
+private:
+	struct TEntry {
+		size_t offset;
+		size_t size;
+	};
+	map<string, TEntry> entries;
+	string root;			// the directory the pack replaces, with SEP
+	unsigned char *base;	// the mapping
+	size_t length;
+
+	bool MakeName (const string& path, string& name) const;
+	bool ReadIndex ();
+public:
+	CAssetPack ();
+	~CAssetPack ();
+
+	bool Open (const string& packfile, const string& dir);
+	void Close ();
+	bool IsOpen () const { return base != NULL; }
+
+	// the lookups are read only and can be used by the workers
+	bool Find (const string& path, const unsigned char *&data, size_t &size) const;
+	bool HasDir (const string& path) const;
+};
+
+extern CAssetPack Pack;
+
+// --------------------------------------------------------------------
+//				virtual files
+// --------------------------------------------------------------------
+
+// The contents of a file, either a view into the pack or a copy read
+// from the disk. Silent and thread safe.
+class CVFile {
+private:
+	const unsigned char *data;
+	size_t size;
+	vector<unsigned char> buffer;
+	CVFile (const CVFile&);
+	CVFile& operator= (const CVFile&);
+public:
+	CVFile () : data(NULL), size(0) {}
+	bool Open (const string& path);
+	const unsigned char *Data () const { return data; }
+	size_t Size () const { return size; }
+};
+
+// silent and thread safe
+bool VFileExists (const string& path);
+
+// For the SDL loaders, which should free it (freesrc = 1). Pack entries
+// are read from memory, other files through SDL_RWFromFile, so streamed
+// music keeps reading from the file. NULL if the file doesn't exist.
+SDL_RWops *VFileRW (const string& path);
+
+#endif
@@ -28,6 +28,7 @@ GNU General Public License for more details.
 #include "game_over.h"
 #include "winsys.h"
 #include "physics.h"
+#include "render_queue.h"
 #include <cstdlib>
 #include <list>
 #include <algorithm>
@@ -1146,6 +1147,31 @@ void DrawSnow (const CControl *ctrl) {
 	Curtain.Draw ();
 }
 
+// particles and flakes use the same texture, the queue draws them together
+static void DrawParticleItem (const TRenderItem *items, size_t count) {
+	draw_particles (static_cast<const CControl*>(items[0].data));
+}
+
+static void DrawFlakeItem (const TRenderItem *items, size_t count) {
+	Flakes.Draw (static_cast<const CControl*>(items[0].data));
+}
+
+static void DrawCurtainItem (const TRenderItem *items, size_t count) {
+	Curtain.Draw ();
+}
+
+void submit_particles (const CControl *ctrl) {
+	if (particles.size() == 0)
+		return;
+	RenderQueue.Submit (RL_OPAQUE, PARTICLES, Tex.GetTexture (SNOW_PART), DrawParticleItem, ctrl);
+}
+
+void SubmitSnow (const CControl *ctrl) {
+	if (g_game.snow_id < 1 || g_game.snow_id > 3) return;
+	RenderQueue.Submit (RL_OPAQUE, PARTICLES, Tex.GetTexture (SNOW_PART), DrawFlakeItem, ctrl);
+	RenderQueue.Submit (RL_OPAQUE, PARTICLES, NULL, DrawCurtainItem);
+}
+
 void InitWind () {
 	Wind.Init (g_game.wind_id);
 }
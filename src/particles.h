@@ -39,6 +39,7 @@ void create_new_particles (const TVector3d& loc, const TVector3d& vel, int num);
 void update_particles ();
 void clear_particles ();
 void draw_particles (const CControl *ctrl);
+void submit_particles (const CControl *ctrl);	// to the render queue
 void generate_particles (const CControl *ctrl, ETR_DOUBLE dtime, const TVector3d& pos, ETR_DOUBLE speed);
 
 // --------------------------------------------------------------------
@@ -226,6 +227,7 @@ extern CWind Wind;
 void InitSnow (const CControl *ctrl);
 void UpdateSnow (const CControl *ctrl);
 void DrawSnow (const CControl *ctrl);
+void SubmitSnow (const CControl *ctrl);
 void InitWind ();
 void UpdateWind ();
 
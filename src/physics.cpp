@@ -154,7 +154,7 @@ bool CControl::CheckTreeCollisions (const TVector3d& pos, TVector3d *tree_loc, E
 		if (hit == true) {
 			if (tree_loc != NULL) *tree_loc = loc;
 			if (tree_diam != NULL) *tree_diam = diam;
-			Sound.Play ("tree_hit", 0);
+			Sound.Queue ("tree_hit", 0);
 			break;
 		}
 	}
@@ -220,10 +220,10 @@ void CControl::CheckItemCollection (const TVector3d& pos) {
 		        (pos.y - 0.6 <= loc.y && pos.y + 0.6 >= loc.y + height)) {
 			items[i].collectable = 0;
 			g_game.herring += 1;
-			Sound.HaltAll ();
-			Sound.Play ("pickup1", 0);
-			Sound.Play ("pickup2", 0);
-			Sound.Play ("pickup3", 0);
+			Sound.QueueHaltAll ();
+			Sound.Queue ("pickup1", 0);
+			Sound.Queue ("pickup2", 0);
+			Sound.Queue ("pickup3", 0);
 		}
 	}
 }
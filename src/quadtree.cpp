@@ -797,7 +797,7 @@ void quadsquare::Render (const quadcornerdata& cd, GLubyte *vnc_array) {
 		RenderAux (cd, SomeClip, -1);
 
 		if (VertexArrayCounter != 0) {
-			glDisable (GL_FOG);
+			GLDisable (GL_FOG);
 			for (GLuint i=0; i<VertexArrayCounter; i++) {
 				colorval (VertexArrayIndices[i], 0) = 0;
 				colorval (VertexArrayIndices[i], 1) = 0;
@@ -806,8 +806,8 @@ void quadsquare::Render (const quadcornerdata& cd, GLubyte *vnc_array) {
 			}
 			Course.TerrList[0].texture->Bind();
 			DrawTris();
-			if (fog_on) glEnable (GL_FOG);
-			glBlendFunc  (GL_SRC_ALPHA, GL_ONE);
+			if (fog_on) GLEnable (GL_FOG);
+			GLBlendFunc  (GL_SRC_ALPHA, GL_ONE);
 			for (GLuint i=0; i<VertexArrayCounter; i++) {
 				colorval (VertexArrayIndices[i], 0) = 255;
 				colorval (VertexArrayIndices[i], 1) = 255;
@@ -827,7 +827,7 @@ void quadsquare::Render (const quadcornerdata& cd, GLubyte *vnc_array) {
 			}
 		}
 	}
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 clip_result_t quadsquare::ClipSquare (const quadcornerdata& cd) {
@@ -202,6 +202,7 @@ void CRaceSelect::Loop() {
 //			0, colMBackgr, colBlack, 0.2);
 
 	// course selection
+	Course.SelectCourse (course->GetValue());
 	col = colWhite;
 	DrawFrameX (area.left, frametop, framewidth - 100, frameheight, 3, colMBackgr, col, 1.0);
 	FT.AutoSizeN (4);
@@ -215,11 +216,13 @@ void CRaceSelect::Loop() {
 	FT.AutoSizeN (2);
 	FT.SetColor (colWhite);
 	int dist = FT.AutoDistanceN (0);
+	FT.BeginBatch ();
 	for (size_t i=0; i<CourseList[course->GetValue()].num_lines; i++) {
 		FT.DrawString (boxleft+8, prevtop+i*dist, CourseList[course->GetValue()].desc[i]);
 	}
 
 	FT.DrawString (CENTER, prevtop + prevheight + 10, "Author:  " + CourseList[course->GetValue()].author);
+	FT.EndBatch ();
 
 	//FT.DrawString (CENTER, AutoYPosN (45), info);
 
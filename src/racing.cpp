@@ -37,6 +37,8 @@ GNU General Public License for more details.
 #include "winsys.h"
 #include "physics.h"
 #include "tux.h"
+#include "render_queue.h"
+#include "scene_target.h"
 #include <algorithm>
 
 #define MAX_JUMP_AMT 1.0
@@ -148,6 +150,9 @@ void CRacing::Keyb (unsigned int key, bool special, bool release, int x, int y)
 		case SDLK_F8:
 			if (!release) trees = !trees;
 			break;
+		case SDLK_g:
+			if (!release) GLStatsLog ();
+			break;
 	}
 }
 
@@ -229,6 +234,7 @@ void CRacing::Enter() {
 
 	g_game.finish = false;
 	InitViewFrustum ();
+	SceneTarget.Reset ();
 }
 
 // -------------------- sound -----------------------------------------
@@ -251,8 +257,8 @@ void PlayTerrainSound (CControl *ctrl, bool airborne) {
 			newsound = (int)Course.TerrList[terridx].sound;
 		} else newsound = -1;
 	} else newsound = -1;
-	if ((newsound != lastsound) && (lastsound >= 0)) Sound.Halt (lastsound);
-	if (newsound >= 0) Sound.Play (newsound, -1);
+	if ((newsound != lastsound) && (lastsound >= 0)) Sound.QueueHalt (lastsound);
+	if (newsound >= 0) Sound.Queue (newsound, -1);
 
 	lastsound = newsound;
 }
@@ -352,6 +358,7 @@ void CRacing::Loop () {
 	bool airborne = (bool) (ctrl->cpos.y > (ycoord + JUMP_MAX_START_HEIGHT));
 
 	check_gl_error();
+	SceneTarget.Begin (g_game.time_step);
 	ClearRenderContext ();
 	Env.SetupFog ();
 	Music.Update ();
@@ -369,20 +376,23 @@ void CRacing::Loop () {
 	UpdateTrackmarks (ctrl);
 
 	SetupViewFrustum (ctrl);
-	if (sky) Env.DrawSkybox (ctrl->viewpos);
-	if (fog) Env.DrawFog ();
-	if (terr) RenderCourse ();
-	DrawTrackmarks ();
-	if (trees) DrawTrees ();
+	if (sky) Env.SubmitSkybox (ctrl->viewpos);
+	if (fog) Env.SubmitFog ();
+	if (terr) SubmitCourse ();
+	SubmitTrackmarks ();
+	if (trees) SubmitTrees ();
 	if (param.perf_level > 2) {
 		update_particles ();
-		draw_particles (ctrl);
+		submit_particles (ctrl);
 	}
-	g_game.character->shape->Draw();
+	g_game.character->shape->Submit();
 	UpdateWind ();
 	UpdateSnow (ctrl);
-	DrawSnow (ctrl);
-	DrawHud (ctrl);
+	SubmitSnow (ctrl);
+	SubmitHud (ctrl);
+	RenderQueue.Flush (RL_TRANSPARENT);
+	SceneTarget.End ();
+	RenderQueue.Flush ();	// the hud at the screen resolution
 
 	Reshape (Winsys.resolution.width, Winsys.resolution.height);
 	Winsys.SwapBuffers ();
@@ -392,4 +402,5 @@ void CRacing::Loop () {
 void CRacing::Exit() {
 	Sound.HaltAll ();
 	break_track_marks ();
+	SceneTarget.Clear ();
 }
@@ -0,0 +1,80 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "render_queue.h"
+#include "textures.h"
+#include <algorithm>
+#include <functional>
+
+CRenderQueue RenderQueue;
+
+void CRenderQueue::Submit (TRenderLayer layer, TRenderMode mode, TTexture *texture,
+		TRenderFunc func, const void *data, float depth) {
+	TRenderItem item;
+	item.layer = layer;
+	item.mode = mode;
+	item.texture = texture;
+	item.func = func;
+	item.data = data;
+	item.depth = depth;
+	item.seq = items.size();
+	items.push_back (item);
+}
+
+static bool ItemOrder (const TRenderItem& a, const TRenderItem& b) {
+	if (a.layer != b.layer) return a.layer < b.layer;
+	if (a.layer == RL_TRANSPARENT && a.depth != b.depth) return a.depth > b.depth;
+	if (a.mode != b.mode) return a.mode < b.mode;
+	if (a.texture != b.texture) return std::less<TTexture*>() (a.texture, b.texture);
+	if (a.layer == RL_OPAQUE && a.depth != b.depth) return a.depth < b.depth;
+	return a.seq < b.seq;
+}
+
+static bool SameGroup (const TRenderItem& a, const TRenderItem& b) {
+	return a.func == b.func && a.mode == b.mode && a.texture == b.texture;
+}
+
+void CRenderQueue::Flush (TRenderLayer last) {
+	sort (items.begin(), items.end(), ItemOrder);
+	size_t count = 0;
+	while (count < items.size() && items[count].layer <= last) count++;
+
+	numgroups = 0;
+	bool pushed = false;
+	for (size_t i=0; i<count; ) {
+		size_t end = i + 1;
+		while (end < count && SameGroup (items[i], items[end])) end++;
+
+		if (!pushed || items[i].mode != items[i-1].mode) {
+			if (pushed) PopRenderMode ();
+			PushRenderMode (items[i].mode);
+			pushed = true;
+		}
+		if (items[i].texture != NULL) items[i].texture->Bind ();
+		items[i].func (&items[i], end - i);
+
+		numgroups++;
+		i = end;
+	}
+	if (pushed) PopRenderMode ();
+	items.erase (items.begin(), items.begin() + count);
+	// the remaining items are submitted again to the front
+	for (size_t i=0; i<items.size(); i++) items[i].seq = i;
+}
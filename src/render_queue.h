@@ -0,0 +1,76 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "bh.h"
+#include "ogl.h"
+#include <vector>
+
+// The race scene is not drawn in a fixed order. Each subsystem submits
+// draw items, the queue sorts them once per frame and draws them with as
+// few changes of render mode and texture as possible.
+//
+// Layers are drawn in order. Within a layer the items are sorted by render
+// mode and texture, items of the same state front to back. Blended items
+// go to RL_TRANSPARENT, they are drawn back to front after everything
+// else. Items that compare equal keep the submission order.
+
+enum TRenderLayer {
+	RL_SKY,				// no depth test, drawn first
+	RL_TERRAIN,			// blends with the sky and fog plane behind it
+	RL_OPAQUE,
+	RL_TRANSPARENT,
+	RL_OVERLAY			// hud
+};
+
+class TTexture;
+struct TRenderItem;
+
+// Draws a run of consecutive items with the same function, mode and
+// texture. The mode is set and the texture is bound by the queue.
+typedef void (*TRenderFunc) (const TRenderItem *items, size_t count);
+
+struct TRenderItem {
+	TRenderLayer layer;
+	TRenderMode mode;
+	TTexture *texture;		// NULL if the function binds its own textures
+	TRenderFunc func;
+	const void *data;
+	float depth;			// squared distance to the viewer
+	size_t seq;
+};
+
+class CRenderQueue {
+private:
+	std::vector<TRenderItem> items;
+	size_t numgroups;
+public:
+	CRenderQueue () : numgroups(0) {}
+
+	void Submit (TRenderLayer layer, TRenderMode mode, TTexture *texture,
+		TRenderFunc func, const void *data = NULL, float depth = 0);
+	// sorts and draws the items up to the given layer and removes them,
+	// the rest stays for the next flush
+	void Flush (TRenderLayer last = RL_OVERLAY);
+
+	size_t NumGroups () const { return numgroups; }	// of the last flush
+};
+
+extern CRenderQueue RenderQueue;
+
+#endif
@@ -0,0 +1,101 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "res_scaler.h"
+#include <cmath>
+
+#define SETTLE_FRAMES 10		// not measured after a change
+#define AVERAGE_FRAMES 20		// measured before the next change
+#define AVERAGE_WEIGHT 0.1f
+#define HITCH_LIMIT 1.4f		// times the average
+#define OVER_BUDGET 1.05f
+#define UNDER_BUDGET 0.8f
+#define MAX_STEP 0.15f
+#define PROBE_STEP 0.05f
+#define PROBE_FRAMES 120
+#define MAX_PROBE_FRAMES 1920
+
+CResolutionScaler::CResolutionScaler () {
+	Init (1.f / 60, 0.5f, 1.f, 1.f);
+}
+
+void CResolutionScaler::Init (float target_time, float min_scale_, float max_scale_, float start_scale) {
+	target = target_time;
+	min_scale = min_scale_;
+	max_scale = max_scale_;
+	scale = start_scale;
+	if (scale < min_scale) scale = min_scale;
+	if (scale > max_scale) scale = max_scale;
+	average = target;
+	samples = 0;
+	probe_wait = PROBE_FRAMES;
+	probing = false;
+}
+
+void CResolutionScaler::SetScale (float newscale) {
+	if (newscale < min_scale) newscale = min_scale;
+	if (newscale > max_scale) newscale = max_scale;
+	scale = newscale;
+	samples = 0;
+}
+
+float CResolutionScaler::Update (float frame_time) {
+	samples++;
+	if (samples <= SETTLE_FRAMES) return scale;
+
+	// single hitches (loading, a swapped out texture) shouldn't count much,
+	// one frame can't push an average in the budget over OVER_BUDGET
+	if (frame_time > 4 * target) frame_time = 4 * target;
+	if (samples == SETTLE_FRAMES + 1) average = frame_time;
+	else {
+		if (frame_time > HITCH_LIMIT * average) frame_time = HITCH_LIMIT * average;
+		average += (frame_time - average) * AVERAGE_WEIGHT;
+	}
+	if (samples < SETTLE_FRAMES + AVERAGE_FRAMES) return scale;
+
+	// the fill time goes with the pixels, the square of the scale
+	float step = scale * sqrt (target / average) - scale;
+	if (step < -MAX_STEP) step = -MAX_STEP;
+	if (step > MAX_STEP) step = MAX_STEP;
+
+	if (average > target * OVER_BUDGET) {
+		if (scale > min_scale) {
+			if (probing && probe_wait < MAX_PROBE_FRAMES) probe_wait *= 2;
+			probing = false;
+			SetScale (scale + step);
+		}
+	} else if (average < target * UNDER_BUDGET) {
+		if (scale < max_scale) {
+			probe_wait = PROBE_FRAMES;
+			probing = false;
+			SetScale (scale + step);
+		}
+	} else {
+		// still in the budget, so the last step up was fine and the load
+		// has gone down, the next one can come sooner
+		if (probing) probe_wait = PROBE_FRAMES;
+		probing = false;
+		if (scale < max_scale && samples >= SETTLE_FRAMES + probe_wait) {
+			probing = true;
+			SetScale (scale + PROBE_STEP);
+		}
+	}
+	return scale;
+}
@@ -0,0 +1,54 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef RES_SCALER_H
+#define RES_SCALER_H
+
+// Chooses the resolution of the 3D scene from the measured frame times,
+// see CSceneTarget. The scale applies to both axes. It doesn't depend on
+// GL or on the rest of the game, so it can be fed with made up frame
+// times.
+//
+// The frame times are averaged. When the average is over the budget the
+// scale is lowered in proportion (the fill cost goes with the square of
+// the scale); when it's clearly under the budget the scale is raised the
+// same way. With vsync the frame time doesn't go below the budget, so after
+// a while in the budget a small step up is tried. If the step turns out to
+// be too much, the next try waits twice as long, a step that holds resets
+// the wait. tools/rescaletest.cpp drives it through a few cases.
+
+class CResolutionScaler {
+private:
+	float target;			// frame time budget in seconds
+	float min_scale;
+	float max_scale;
+	float scale;
+	float average;
+	int samples;			// since the last change of the scale
+	int probe_wait;			// frames in the budget before a step up
+	bool probing;
+	void SetScale (float newscale);
+public:
+	CResolutionScaler ();
+
+	// resets the measurement, the scale starts at start_scale
+	void Init (float target_time, float min_scale_, float max_scale_, float start_scale);
+	// one frame, returns the scale for the next one
+	float Update (float frame_time);
+	float Scale () const { return scale; }
+};
+
+#endif
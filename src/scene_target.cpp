@@ -0,0 +1,263 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "scene_target.h"
+#include "ogl.h"
+#include "winsys.h"
+#include <cstring>
+#include <algorithm>
+
+#ifdef USE_HEADLESS
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#define GetGLProc(name) eglGetProcAddress (name)
+#else
+#define GetGLProc(name) SDL_GL_GetProcAddress (name)
+#endif
+
+#ifndef USE_GLES2
+// GLES1 has framebuffer objects as the OES_framebuffer_object extension,
+// the functions are looked up under the GLES2 names
+#include <GLES/glext.h>
+
+#define GL_FRAMEBUFFER GL_FRAMEBUFFER_OES
+#define GL_RENDERBUFFER GL_RENDERBUFFER_OES
+#define GL_COLOR_ATTACHMENT0 GL_COLOR_ATTACHMENT0_OES
+#define GL_DEPTH_ATTACHMENT GL_DEPTH_ATTACHMENT_OES
+#define GL_STENCIL_ATTACHMENT GL_STENCIL_ATTACHMENT_OES
+#define GL_DEPTH_COMPONENT16 GL_DEPTH_COMPONENT16_OES
+#define GL_FRAMEBUFFER_COMPLETE GL_FRAMEBUFFER_COMPLETE_OES
+
+static PFNGLGENFRAMEBUFFERSOESPROC glGenFramebuffers = NULL;
+static PFNGLDELETEFRAMEBUFFERSOESPROC glDeleteFramebuffers = NULL;
+static PFNGLBINDFRAMEBUFFEROESPROC glBindFramebuffer = NULL;
+static PFNGLFRAMEBUFFERTEXTURE2DOESPROC glFramebufferTexture2D = NULL;
+static PFNGLFRAMEBUFFERRENDERBUFFEROESPROC glFramebufferRenderbuffer = NULL;
+static PFNGLCHECKFRAMEBUFFERSTATUSOESPROC glCheckFramebufferStatus = NULL;
+static PFNGLGENRENDERBUFFERSOESPROC glGenRenderbuffers = NULL;
+static PFNGLDELETERENDERBUFFERSOESPROC glDeleteRenderbuffers = NULL;
+static PFNGLBINDRENDERBUFFEROESPROC glBindRenderbuffer = NULL;
+static PFNGLRENDERBUFFERSTORAGEOESPROC glRenderbufferStorage = NULL;
+#endif
+
+#ifndef GL_DEPTH24_STENCIL8_OES
+#define GL_DEPTH24_STENCIL8_OES 0x88F0
+#endif
+
+CSceneTarget SceneTarget;
+
+static bool HasExtension (const char *name) {
+	const char *extensions = (const char*)glGetString (GL_EXTENSIONS);
+	return extensions != NULL && strstr (extensions, name) != NULL;
+}
+
+static int NextPowerOfTwo (int n) {
+	int p = 1;
+	while (p < n) p *= 2;
+	return p;
+}
+
+CSceneTarget::CSceneTarget () {
+	checked = false;
+	supported = false;
+	active = false;
+	packed_stencil = false;
+	npot = false;
+	framebuffer = 0;
+	colortex = 0;
+	depthbuffer = 0;
+	width = height = 0;
+	texwidth = texheight = 0;
+	scenewidth = sceneheight = 0;
+}
+
+bool CSceneTarget::CheckSupport () {
+	if (checked) return supported;
+	checked = true;
+#ifdef USE_GLES2
+	supported = true;
+	npot = true;	// without mipmaps and repeat
+#else
+	if (!HasExtension ("GL_OES_framebuffer_object")) return false;
+	glGenFramebuffers = (PFNGLGENFRAMEBUFFERSOESPROC) GetGLProc ("glGenFramebuffersOES");
+	glDeleteFramebuffers = (PFNGLDELETEFRAMEBUFFERSOESPROC) GetGLProc ("glDeleteFramebuffersOES");
+	glBindFramebuffer = (PFNGLBINDFRAMEBUFFEROESPROC) GetGLProc ("glBindFramebufferOES");
+	glFramebufferTexture2D = (PFNGLFRAMEBUFFERTEXTURE2DOESPROC) GetGLProc ("glFramebufferTexture2DOES");
+	glFramebufferRenderbuffer = (PFNGLFRAMEBUFFERRENDERBUFFEROESPROC) GetGLProc ("glFramebufferRenderbufferOES");
+	glCheckFramebufferStatus = (PFNGLCHECKFRAMEBUFFERSTATUSOESPROC) GetGLProc ("glCheckFramebufferStatusOES");
+	glGenRenderbuffers = (PFNGLGENRENDERBUFFERSOESPROC) GetGLProc ("glGenRenderbuffersOES");
+	glDeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSOESPROC) GetGLProc ("glDeleteRenderbuffersOES");
+	glBindRenderbuffer = (PFNGLBINDRENDERBUFFEROESPROC) GetGLProc ("glBindRenderbufferOES");
+	glRenderbufferStorage = (PFNGLRENDERBUFFERSTORAGEOESPROC) GetGLProc ("glRenderbufferStorageOES");
+	supported = glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer
+		&& glFramebufferTexture2D && glFramebufferRenderbuffer && glCheckFramebufferStatus
+		&& glGenRenderbuffers && glDeleteRenderbuffers && glBindRenderbuffer
+		&& glRenderbufferStorage;
+	npot = HasExtension ("GL_OES_texture_npot");
+#endif
+	// the shadow of tux needs the stencil buffer
+	packed_stencil = HasExtension ("GL_OES_packed_depth_stencil");
+	if (!supported) Message ("no framebuffer objects, the scene is not scaled");
+	return supported;
+}
+
+bool CSceneTarget::Create (int w, int h) {
+	if (framebuffer != 0 && w == width && h == height) return true;
+	if (!CheckSupport ()) return false;
+	Delete ();
+
+	width = w;
+	height = h;
+	texwidth = npot ? w : NextPowerOfTwo (w);
+	texheight = npot ? h : NextPowerOfTwo (h);
+
+	// no alpha, the scene covers the screen when it is drawn in GUI mode
+	glGenTextures (1, &colortex);
+	BindTexture (colortex);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexImage2D (GL_TEXTURE_2D, 0, GL_RGB, texwidth, texheight, 0,
+		GL_RGB, GL_UNSIGNED_BYTE, NULL);
+
+	glGenRenderbuffers (1, &depthbuffer);
+	glBindRenderbuffer (GL_RENDERBUFFER, depthbuffer);
+	glRenderbufferStorage (GL_RENDERBUFFER,
+		packed_stencil ? GL_DEPTH24_STENCIL8_OES : GL_DEPTH_COMPONENT16,
+		texwidth, texheight);
+	glBindRenderbuffer (GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers (1, &framebuffer);
+	glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D (GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colortex, 0);
+	glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+	if (packed_stencil)
+		glFramebufferRenderbuffer (GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthbuffer);
+	GLenum status = glCheckFramebufferStatus (GL_FRAMEBUFFER);
+	glBindFramebuffer (GL_FRAMEBUFFER, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		Message ("the scene framebuffer is incomplete, the scene is not scaled");
+		Delete ();
+		supported = false;
+		return false;
+	}
+	return true;
+}
+
+void CSceneTarget::Delete () {
+	if (framebuffer != 0) glDeleteFramebuffers (1, &framebuffer);
+	if (depthbuffer != 0) glDeleteRenderbuffers (1, &depthbuffer);
+	if (colortex != 0) DeleteTextures (1, &colortex);
+	framebuffer = 0;
+	depthbuffer = 0;
+	colortex = 0;
+	width = height = 0;
+}
+
+void CSceneTarget::Clear () {
+	if (supported) Delete ();
+	active = false;
+}
+
+void CSceneTarget::Reset () {
+	float target = 1.f / (param.framerate > 0 ? param.framerate : 60);
+	scaler.Init (target, param.min_render_scale / 100.f, 1.f, param.render_scale / 100.f);
+}
+
+float CSceneTarget::Scale () const {
+	if (!param.dynamic_resolution) {
+		float scale = param.render_scale / 100.f;
+		return scale < 1.f ? scale : 1.f;
+	}
+	return scaler.Scale ();
+}
+
+void CSceneTarget::Begin (float frame_time) {
+	active = false;
+#ifndef USE_HEADLESS
+	if (param.dynamic_resolution) scaler.Update (frame_time);
+#endif
+	float scale = Scale ();
+	if (scale >= 1.f) return;
+
+	int w = Winsys.resolution.width;
+	int h = Winsys.resolution.height;
+	if (Winsys.orient & ORIENT_ROTATE) swap (w, h);
+	if (!Create (w, h)) return;
+
+	scenewidth = max (1, (int)(w * scale + 0.5f));
+	sceneheight = max (1, (int)(h * scale + 0.5f));
+	glBindFramebuffer (GL_FRAMEBUFFER, framebuffer);
+	glViewport (0, 0, scenewidth, sceneheight);
+	active = true;
+}
+
+void CSceneTarget::End () {
+	if (!active) return;
+	active = false;
+	glBindFramebuffer (GL_FRAMEBUFFER, 0);
+	glViewport (0, 0, width, height);
+	ClearRenderContext ();
+
+	ScopedRenderMode rm(GUI);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	BindTexture (colortex);
+
+	// the framebuffer is in the orientation of the screen, so the whole
+	// viewport is covered without the projection
+	glMatrixMode (GL_PROJECTION);
+	glPushMatrix ();
+	glLoadIdentity ();
+	glMatrixMode (GL_MODELVIEW);
+	glPushMatrix ();
+	glLoadIdentity ();
+
+	GLfloat s = (GLfloat)scenewidth / texwidth;
+	GLfloat t = (GLfloat)sceneheight / texheight;
+	const GLfloat tex[] = {
+		0, 0,
+		s, 0,
+		s, t,
+		0, t
+	};
+	const GLshort vtx[] = {
+		-1, -1,
+		1, -1,
+		1, 1,
+		-1, 1
+	};
+	glColor4f (1.0, 1.0, 1.0, 1.0);
+	glEnableClientState (GL_VERTEX_ARRAY);
+	glEnableClientState (GL_TEXTURE_COORD_ARRAY);
+
+	glVertexPointer (2, GL_SHORT, 0, vtx);
+	glTexCoordPointer (2, GL_FLOAT, 0, tex);
+	glDrawArrays (GL_TRIANGLE_FAN, 0, 4);
+
+	glDisableClientState (GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState (GL_VERTEX_ARRAY);
+
+	glMatrixMode (GL_PROJECTION);
+	glPopMatrix ();
+	glMatrixMode (GL_MODELVIEW);
+	glPopMatrix ();
+}
@@ -0,0 +1,64 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef SCENE_TARGET_H
+#define SCENE_TARGET_H
+
+#include "bh.h"
+#include "res_scaler.h"
+
+// Renders the 3D scene of the race at a lower resolution when the frames
+// take too long. Between Begin and End the scene goes to an offscreen
+// framebuffer of the scaled size, End draws it stretched over the screen.
+// The hud is drawn after End, so it keeps the screen resolution. At full
+// scale, or without framebuffer objects, the scene is drawn to the screen
+// as before.
+//
+// The scale comes from CResolutionScaler (param.dynamic_resolution) or is
+// fixed at param.render_scale. Headless builds don't adapt, their frames
+// must not depend on the speed of the machine.
+
+class CSceneTarget {
+private:
+	CResolutionScaler scaler;
+	bool checked;			// for framebuffer support
+	bool supported;
+	bool active;			// the scene of this frame goes to the framebuffer
+	bool packed_stencil;
+	bool npot;
+	GLuint framebuffer;
+	GLuint colortex;
+	GLuint depthbuffer;
+	int width, height;		// of the screen, in the orientation of GL
+	int texwidth, texheight;
+	int scenewidth, sceneheight;
+
+	bool CheckSupport ();
+	bool Create (int w, int h);
+	void Delete ();
+public:
+	CSceneTarget ();
+
+	void Reset ();			// at the start of a race
+	void Begin (float frame_time);
+	void End ();
+	float Scale () const;
+	void Clear ();			// frees the framebuffer
+};
+
+extern CSceneTarget SceneTarget;
+
+#endif
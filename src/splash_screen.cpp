@@ -36,6 +36,8 @@ GNU General Public License for more details.
 #include "regist.h"
 #include "winsys.h"
 #include "game_type_select.h"
+#include "workers.h"
+#include "loading.h"
 
 CSplashScreen SplashScreen;
 
@@ -52,6 +54,68 @@ void CSplashScreen::Keyb(unsigned int key, bool special, bool release, int x, in
 }
 
 
+// ---------------------------- startup tasks -------------------------
+
+static void MakePolyhedrons () { Course.MakeStandardPolyhedrons (); }
+static void LoadSounds () { Sound.LoadSoundList (); }
+static void LoadCredits () { Credits.LoadCreditList (); }
+static void LoadCharacters () { Char.LoadCharacterList (); }
+static void LoadObjectTypes () { Course.LoadObjectTypes (); }
+static void LoadTerrainTypes () { Course.LoadTerrainTypes (); }
+static void LoadEnvironments () { Env.LoadEnvironmentList (); }
+static void LoadCourses () { Course.LoadCourseList (); }
+static void LoadHighScore () { Score.LoadHighScore (); }
+static void LoadEvents () { Events.LoadEventList (); }
+static void LoadAvatars () { Players.LoadAvatars (); }
+static void LoadPlayers () { Players.LoadPlayers (); }
+
+// The lists are parsed on the worker pool, only the avatars are loaded on
+// this thread because they are uploaded at once. Music and translations
+// are already loaded at this point.
+void LoadGameData () {
+	CTaskGraph graph;
+	graph.Add (MakePolyhedrons);
+	size_t sounds = graph.Add (LoadSounds);
+	graph.Add (LoadCredits);
+	graph.Add (LoadCharacters);
+	graph.Add (LoadObjectTypes);
+	size_t terrains = graph.Add (LoadTerrainTypes);
+	size_t envs = graph.Add (LoadEnvironments);
+	size_t courses = graph.Add (LoadCourses);
+	size_t scores = graph.Add (LoadHighScore);
+	size_t events = graph.Add (LoadEvents);
+	size_t avatars = graph.Add (LoadAvatars, true);
+	size_t players = graph.Add (LoadPlayers);
+
+	graph.Depends (terrains, sounds);	// terrain sounds
+	graph.Depends (courses, envs);		// course environments
+	graph.Depends (scores, courses);
+	graph.Depends (events, courses);
+	graph.Depends (players, avatars);
+	graph.Run ();
+}
+
+// --render: a practice race on the given course with the default
+// conditions, see main.cpp
+static void StartRender () {
+	g_game.course = NULL;
+	for (size_t i=0; i<Course.CourseList.size(); i++)
+		if (Course.CourseList[i].dir == g_game.render_course)
+			g_game.course = &Course.CourseList[i];
+	if (g_game.course == NULL) {
+		Message ("unknown course", g_game.render_course);
+		State::manager.RequestQuit ();
+		return;
+	}
+	g_game.mirrorred = false;
+	g_game.light_id = 0;
+	g_game.snow_id = 0;
+	g_game.wind_id = 0;
+	g_game.theme_id = g_game.course->music_theme;
+	g_game.game_type = PRACTICING;
+	State::manager.RequestEnterState (Loading);
+}
+
 void CSplashScreen::Enter() {
 	Winsys.ShowCursor (!param.ice_cursor);
 	init_ui_snow ();
@@ -75,24 +139,17 @@ void CSplashScreen::Loop() {
 	FT.DrawString (CENTER, top+dist, Trans.Text(68));
 
 	Winsys.SwapBuffers();
-	Course.MakeStandardPolyhedrons ();
-	Sound.LoadSoundList ();
-	Credits.LoadCreditList ();
-	Char.LoadCharacterList ();
-	Course.LoadObjectTypes ();
-	Course.LoadTerrainTypes ();
-	Env.LoadEnvironmentList ();
-	Course.LoadCourseList ();
-	Score.LoadHighScore (); // after LoadCourseList !!!
-	Events.LoadEventList ();
-	Players.LoadAvatars (); // before LoadPlayers !!!
-	Players.LoadPlayers ();
+	LoadGameData ();
 
 	Players.ResetControls();
 	Players.AllocControl(g_game.start_player);
 	g_game.player = Players.GetPlayer(g_game.start_player);
 	g_game.character = &Char.CharList[g_game.start_character];
 
+	if (g_game.argument == 5) {
+		StartRender ();
+		return;
+	}
 	State::manager.RequestEnterState (GameTypeSelect);
 
 //	State::manager.RequestEnterState (Regist);
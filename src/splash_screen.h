@@ -30,4 +30,7 @@ public:
 
 extern CSplashScreen SplashScreen;
 
+// the lists of the game, on the worker pool (tools/startbench.cpp)
+void LoadGameData ();
+
 #endif
@@ -19,11 +19,14 @@ GNU General Public License for more details.
 #endif
 
 #include "spx.h"
+#include "pack.h"
 
 #include <sstream>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <cmath>
+#include <cstring>
 
 const string emptyString = "";
 const string errorString = "error";
@@ -104,11 +107,112 @@ string Bool_StrN(const bool val) {
 	else return "false";
 }
 
+// The numbers in the lists are converted without a stream. The fast
+// routines only accept the plain forms (no exponent, at most 15 digits),
+// which they convert exactly like operator>> in the "C" locale. Anything
+// else is left to an istringstream, so the results never differ.
+
+enum ENumResult { NUM_OK, NUM_FAIL, NUM_SLOW };
+
+static inline bool IsSpace (char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+static inline bool IsDigit (char c) {
+	return c >= '0' && c <= '9';
+}
+
+static ENumResult FastNumber (const char *&p, const char *end, int &val) {
+	while (p < end && IsSpace (*p)) p++;
+	bool neg = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		neg = *p == '-';
+		p++;
+	}
+	int num = 0;
+	int digits = 0;
+	while (p < end && IsDigit (*p)) {
+		if (++digits > 9) return NUM_SLOW;	// might overflow
+		num = num * 10 + (*p - '0');
+		p++;
+	}
+	if (digits == 0) return NUM_FAIL;
+	val = neg ? -num : num;
+	return NUM_OK;
+}
+
+// The powers of ten are multiplied out, the literals 1e11.. would be
+// rounded to float by -fsingle-precision-constant
+static struct TPow10 {
+	double v[16];
+	TPow10 () {
+		v[0] = 1;
+		for (int i=1; i<16; i++) v[i] = v[i-1] * 10;
+	}
+} powers10;
+
+static ENumResult FastNumber (const char *&p, const char *end, double &val) {
+	while (p < end && IsSpace (*p)) p++;
+	bool neg = false;
+	if (p < end && (*p == '-' || *p == '+')) {
+		neg = *p == '-';
+		p++;
+	}
+	// mantissa and divisor are exact, so the division rounds correctly
+	double mant = 0;
+	int digits = 0;
+	int frac = 0;
+	bool point = false;
+	for (; p < end; p++) {
+		if (IsDigit (*p)) {
+			if (++digits > 15) return NUM_SLOW;
+			mant = mant * 10 + (*p - '0');
+			if (point) frac++;
+		} else if (*p == '.' && !point) {
+			point = true;
+		} else break;
+	}
+	if (p < end && (*p == 'e' || *p == 'E')) return NUM_SLOW;
+	if (digits == 0) return NUM_FAIL;
+	val = mant / powers10.v[frac];
+	if (neg) val = -val;
+	return NUM_OK;
+}
+
+static ENumResult FastNumber (const char *&p, const char *end, float &val) {
+	double d;
+	ENumResult res = FastNumber (p, end, d);
+	if (res != NUM_OK) return res;
+	// rounding the double again is only wrong if it lies exactly halfway
+	// between two floats
+	int exp;
+	double m = ldexp (frexp (d, &exp), 25);
+	if (m == floor (m) && fmod (m, 2.0) != 0.0) return NUM_SLOW;
+	val = (float)d;
+	return NUM_OK;
+}
+
+// reads count numbers, false if the stream would fail
+template<typename T>
+static bool ParseNumbers (const char *s, size_t len, T *vals, size_t count) {
+	const char *p = s;
+	const char *end = s + len;
+	for (size_t i=0; i<count; i++) {
+		ENumResult res = FastNumber (p, end, vals[i]);
+		if (res == NUM_FAIL) return false;
+		if (res == NUM_SLOW) {
+			istringstream is(string (s, len));
+			for (size_t j=0; j<count; j++)
+				is >> vals[j];
+			return !is.fail();
+		}
+	}
+	return true;
+}
+
 int Str_IntN (const string &s, const int def) {
 	int val;
-	istringstream is(s);
-	is >> val;
-	if (is.fail()) return def;
+	if (!ParseNumbers (s.data(), s.size(), &val, 1)) return def;
 	else return val;
 }
 
@@ -122,67 +226,52 @@ bool Str_BoolN (const string &s, const bool def) {
 
 float Str_FloatN (const string &s, const float def) {
 	float val;
-	istringstream is(s);
-	is >> val;
-	if (is.fail()) return def;
+	if (!ParseNumbers (s.data(), s.size(), &val, 1)) return def;
 	else return val;
 }
 
 template<typename T>
 TVector2<T> Str_Vector2(const string &s, const TVector2<T> &def) {
-	T x, y;
-	istringstream is(s);
-	is >> x >> y;
-	if (is.fail()) return def;
-	else return TVector2<T>(x, y);
+	T v[2];
+	if (!ParseNumbers (s.data(), s.size(), v, 2)) return def;
+	else return TVector2<T>(v[0], v[1]);
 }
 template TVector2<ETR_DOUBLE> Str_Vector2(const string &s, const TVector2<ETR_DOUBLE> &def);
 template TVector2<int> Str_Vector2(const string &s, const TVector2<int> &def);
 
 template<typename T>
 TVector3<T> Str_Vector3(const string &s, const TVector3<T> &def) {
-	T x, y, z;
-	istringstream is(s);
-	is >> x >> y >> z;
-	if (is.fail()) return def;
-	else return TVector3<T>(x, y, z);
+	T v[3];
+	if (!ParseNumbers (s.data(), s.size(), v, 3)) return def;
+	else return TVector3<T>(v[0], v[1], v[2]);
 }
 template TVector3<ETR_DOUBLE> Str_Vector3(const string &s, const TVector3<ETR_DOUBLE> &def);
 template TVector3<int> Str_Vector3(const string &s, const TVector3<int> &def);
 
 template<typename T>
 TVector4<T> Str_Vector4(const string &s, const TVector4<T> &def) {
-	T x, y, z, w;
-	istringstream is(s);
-	is >> x >> y >> z >> w;
-	if (is.fail()) return def;
-	else return TVector4<T>(x, y, z, w);
+	T v[4];
+	if (!ParseNumbers (s.data(), s.size(), v, 4)) return def;
+	else return TVector4<T>(v[0], v[1], v[2], v[3]);
 }
 template TVector4<ETR_DOUBLE> Str_Vector4(const string &s, const TVector4<ETR_DOUBLE> &def);
 template TVector4<int> Str_Vector4(const string &s, const TVector4<int> &def);
 
 
 TColor Str_ColorN (const string &s, const TColor &def) {
-	float r, g, b, a;
-	istringstream is(s);
-	is >> r >> g >> b >> a;
-	if (is.fail()) return def;
-	else return TColor(r, g, b, a);
+	float c[4];
+	if (!ParseNumbers (s.data(), s.size(), c, 4)) return def;
+	else return TColor(c[0], c[1], c[2], c[3]);
 }
 
 TColor3 Str_Color3N (const string &s, const TColor3 &def) {
-	float r, g, b;
-	istringstream is(s);
-	is >> r >> g >> b;
-	if (is.fail()) return def;
-	else return TColor3(r, g, b);
+	float c[3];
+	if (!ParseNumbers (s.data(), s.size(), c, 3)) return def;
+	else return TColor3(c[0], c[1], c[2]);
 }
 
 void Str_ArrN (const string &s, float *arr, size_t count, float def) {
-	istringstream is(s);
-	for (size_t i = 0; i < count; i++)
-		is >> arr[i];
-	if (is.fail())
+	if (!ParseNumbers (s.data(), s.size(), arr, count))
 		for (size_t i=0; i<count; i++) arr[i] = def;
 }
 
@@ -190,19 +279,30 @@ void Str_ArrN (const string &s, float *arr, size_t count, float def) {
 //				SP functions for parsing lines
 // --------------------------------------------------------------------
 
-string SPItemN (const string &s, const string &tag) {
-	if (s.empty() || tag.empty()) return "";
-
-	string tg = '[' + tag + ']';
-	size_t i = SPosN (s, tg);
-	if (i == string::npos) return "";
-	size_t ii = i + tg.size();
-	string item;
-	while (ii < s.size() && s[ii] != '[' && s[ii] != '#') {
-		item += s[ii];
-		ii++;
+// finds the value of the first [tag] without copying, it ends at the
+// next '[' or '#'
+static bool SPFindN (const string &s, const string &tag, size_t &pos, size_t &len) {
+	if (s.empty() || tag.empty()) return false;
+
+	size_t i = s.find ('[');
+	while (i != string::npos) {
+		size_t close = i + 1 + tag.size();
+		if (close < s.size() && s[close] == ']' && s.compare (i + 1, tag.size(), tag) == 0) {
+			pos = close + 1;
+			len = s.find_first_of ("[#", pos);
+			if (len == string::npos) len = s.size();
+			len -= pos;
+			return true;
+		}
+		i = s.find ('[', i + 1);
 	}
-	return item;
+	return false;
+}
+
+string SPItemN (const string &s, const string &tag) {
+	size_t pos, len;
+	if (!SPFindN (s, tag, pos, len)) return "";
+	return s.substr (pos, len);
 }
 
 string SPStrN (const string &s, const string &tag, const string& def) {
@@ -213,7 +313,11 @@ string SPStrN (const string &s, const string &tag, const string& def) {
 }
 
 int SPIntN (const string &s, const string &tag, const int def) {
-	return (Str_IntN (SPItemN (s, tag), def));
+	size_t pos, len;
+	int val;
+	if (!SPFindN (s, tag, pos, len)) return def;
+	if (!ParseNumbers (s.data() + pos, len, &val, 1)) return def;
+	return val;
 }
 
 bool SPBoolN (const string &s, const string &tag, const bool def) {
@@ -223,7 +327,11 @@ bool SPBoolN (const string &s, const string &tag, const bool def) {
 }
 
 float SPFloatN (const string &s, const string &tag, const float def) {
-	return (Str_FloatN (SPItemN (s, tag), def));
+	size_t pos, len;
+	float val;
+	if (!SPFindN (s, tag, pos, len)) return def;
+	if (!ParseNumbers (s.data() + pos, len, &val, 1)) return def;
+	return val;
 }
 
 template<typename T>
@@ -260,8 +368,83 @@ void SPArrN (const string &s, const string &tag, float *arr, size_t count, float
 }
 
 size_t SPPosN (const string &s, const string &tag) {
-	string tg = '[' + tag + ']';
-	return SPosN (s, tg);
+	size_t pos, len;
+	if (!SPFindN (s, tag, pos, len)) return string::npos;
+	return pos - tag.size() - 2;
+}
+
+// --------------------------------------------------------------------
+//				class CSPLine
+// --------------------------------------------------------------------
+
+void CSPLine::Parse (const string& s) {
+	line = &s;
+	items.clear();
+
+	size_t i = s.find ('[');
+	while (i != string::npos) {
+		size_t close = s.find_first_of ("[]", i + 1);
+		if (close == string::npos) break;
+		if (s[close] == '[') {	// "[[tag]" is read like SPFindN does
+			i = close;
+			continue;
+		}
+		TItem item;
+		item.tag = i + 1;
+		item.taglen = close - i - 1;
+		item.pos = close + 1;
+		size_t end = s.find_first_of ("[#", item.pos);
+		if (end == string::npos) end = s.size();
+		item.len = end - item.pos;
+		items.push_back (item);
+		i = s.find ('[', end);
+	}
+}
+
+bool CSPLine::Find (const string& tag, size_t &pos, size_t &len) const {
+	if (tag.empty()) return false;
+	if (tag.find ('[') != string::npos) return SPFindN (*line, tag, pos, len);
+	for (size_t i=0; i<items.size(); i++) {
+		const TItem& item = items[i];
+		if (item.taglen == tag.size() && line->compare (item.tag, item.taglen, tag) == 0) {
+			pos = item.pos;
+			len = item.len;
+			return true;
+		}
+	}
+	return false;
+}
+
+string CSPLine::Str (const string& tag, const string& def) const {
+	size_t pos, len;
+	if (!Find (tag, pos, len) || len == 0) return def;
+	string item = line->substr (pos, len);
+	STrimN (item);
+	return item;
+}
+
+int CSPLine::Int (const string& tag, const int def) const {
+	size_t pos, len;
+	int val;
+	if (!Find (tag, pos, len)) return def;
+	if (!ParseNumbers (line->data() + pos, len, &val, 1)) return def;
+	return val;
+}
+
+bool CSPLine::Bool (const string& tag, const bool def) const {
+	size_t pos, len;
+	if (!Find (tag, pos, len)) return def;
+	string item = line->substr (pos, len);
+	STrimN (item);
+	return Str_BoolN (item, def);
+}
+
+float CSPLine::Float (const string& tag, const float def) const {
+	size_t pos, len;
+	float val;
+	if (!Find (tag, pos, len)) return def;
+	if (!ParseNumbers (line->data() + pos, len, &val, 1)) return def;
+	return val;
 }
 
 // ------------------ add ---------------------------------------------
@@ -387,19 +570,21 @@ void CSPList::Print () const {
 }
 
 bool CSPList::Load (const string &filepath) {
-	std::ifstream tempfile(filepath.c_str());
+	CVFile file;
 	string line;
 
-	if (!tempfile) {
+	if (!file.Open (filepath)) {
 		Message ("CSPList::Load - unable to open " + filepath);
 		return false;
 	} else {
+		const char *text = reinterpret_cast<const char*>(file.Data());
+		const char *end = text + file.Size();
 		bool backflag = false;
-		while (getline(tempfile, line)) {
-
-			// delete new line char if in string
-			size_t npos = line.rfind ('\n');
-			if (npos != string::npos) SDeleteN (line, npos, 1);
+		while (text < end) {
+			const char *eol = static_cast<const char*>(memchr (text, '\n', end - text));
+			if (eol == NULL) eol = end;
+			line.assign (text, eol);
+			text = eol + 1;
 
 			bool valid = true;
 			if (line.empty()) valid = false;	// empty line
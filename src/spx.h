@@ -78,6 +78,29 @@ TColor   SPColorN     (const string &s, const string &tag, const TColor& def);
 TColor3  SPColor3N    (const string &s, const string &tag, const TColor3& def);
 void     SPArrN       (const string &s, const string &tag, float *arr, size_t count, float def);
 
+// A line split once into its [tag] items, for reading many tags of the
+// same line. The values are the same as those of the SP functions. The
+// line must not change or go away while the CSPLine is used.
+class CSPLine {
+private:
+	struct TItem {
+		size_t tag, taglen;		// inside the brackets
+		size_t pos, len;		// value
+	};
+	const string *line;
+	vector<TItem> items;
+	bool Find (const string& tag, size_t &pos, size_t &len) const;
+public:
+	CSPLine () : line(&emptyString) {}
+	explicit CSPLine (const string& s) { Parse (s); }
+	void Parse (const string& s);
+
+	string Str   (const string& tag, const string& def = emptyString) const;
+	int    Int   (const string& tag, const int def) const;
+	bool   Bool  (const string& tag, const bool def) const;
+	float  Float (const string& tag, const float def) const;
+};
+
 // ----- making SP strings --------------------------------------------
 void     SPAddIntN    (string &s, const string &tag, const int val);
 void     SPAddFloatN  (string &s, const string &tag, const float val, size_t count);
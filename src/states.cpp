@@ -22,42 +22,58 @@ GNU General Public License for more details.
 #include "states.h"
 #include "ogl.h"
 #include "winsys.h"
+#include "textures.h"
+#include "audio.h"
 #include <ctime>
+#ifndef USE_HEADLESS
 #include <ubuntu/application/sensors/accelerometer.h>
 
 static UASensorsAccelerometer *accel = NULL;
+#endif
 static float accelx = 0;
 static float accely = 0;
 static float accelz = 0;
 
+#ifndef USE_HEADLESS
 void tilt_cb(UASAccelerometerEvent *event, void*/*context*/) {
 	float value = 0;
 	if (uas_accelerometer_event_get_acceleration_x(event, &value) == U_STATUS_SUCCESS) accelx = value;
 	if (uas_accelerometer_event_get_acceleration_y(event, &value) == U_STATUS_SUCCESS) accely = value;
 	if (uas_accelerometer_event_get_acceleration_z(event, &value) == U_STATUS_SUCCESS) accelz = value;
 }
+#endif
+
+// headless frames advance the game by a fixed time, so that frame n always
+// shows the same picture
+#define HEADLESS_TIME_STEP (1.0 / 30)
 
 State::Manager State::manager(Winsys);
 
 State::Manager::~Manager() {
+#ifndef USE_HEADLESS
 	if (accel)
 		ua_sensors_accelerometer_disable(accel);
+#endif
 	if (current)
 		current->Exit();
 }
 
 void State::Manager::Run(State& entranceState) {
+#ifndef USE_HEADLESS
 	SDL_setenv("UBUNTU_PLATFORM_API_BACKEND", "touch_mirclient", 1);
 	accel = ua_sensors_accelerometer_new();
 	ua_sensors_accelerometer_set_reading_cb(accel, tilt_cb, 0);
 	ua_sensors_accelerometer_enable(accel);
+#endif
 
 	current = &entranceState;
 	current->Enter();
 	//clock_t ticks = clock();
 	while (!quit) {
 		PollEvent();
+#ifndef USE_HEADLESS
 		Tilt();
+#endif
 		if (next)
 			EnterNextState();
 		CallLoopFunction();
@@ -236,9 +252,15 @@ void State::Manager::PollEvent() {
 }
 
 void State::Manager::CallLoopFunction() {
+#ifdef USE_HEADLESS
+	g_game.time_step = HEADLESS_TIME_STEP;
+#else
 	float cur_time = SDL_GetTicks() * 1.e-3;
 	g_game.time_step = cur_time - clock_time;
 	if (g_game.time_step < 0.0001) g_game.time_step = 0.0001;
 	clock_time = cur_time;
+#endif
+	TexCache.NewFrame();
 	current->Loop();
+	Sound.Update();
 }
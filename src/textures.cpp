@@ -24,20 +24,24 @@ GNU General Public License for more details.
 #include "course.h"
 #include "winsys.h"
 #include "ogl.h"
+#include "workers.h"
+#include "etc1.h"
+#include "pack.h"
 #include <SDL2/SDL_image.h>
 //#include <GL/glu.h>
 #include <fstream>
 #include <cctype>
+#include <cstring>
+#include <algorithm>
 
 
-static const GLshort fullsize_texture[] = {
+static const GLfloat fullsize_texture[] = {
 	0, 0,
 	1, 0,
 	1, 1,
 	0, 1
 };
 
-#ifdef USE_GLES1
 static int GLES2D_p2( int input )
 {
 	int value = 1;
@@ -48,6 +52,92 @@ static int GLES2D_p2( int input )
 	}
 	return value;
 }
+
+#ifdef USE_GLES1
+
+// Box filter weights for resampling n source pixels to dn destination
+// pixels: destination pixel i covers the source interval [i*s, (i+1)*s)
+// and each source pixel contributes with its overlap.
+struct TBoxWeights {
+	vector<int> first;
+	vector<int> count;
+	vector<float> weights;
+	int maxcount;
+
+	TBoxWeights (int n, int dn) : first(dn), count(dn), maxcount(0) {
+		float s = (float)n / dn;
+		for (int i=0; i<dn; i++) {
+			float lo = i * s;
+			float hi = (i + 1) * s;
+			int j0 = (int)lo;
+			int j1 = min((int)ceil(hi), n);
+			first[i] = j0;
+			count[i] = j1 - j0;
+			maxcount = max(maxcount, j1 - j0);
+		}
+		weights.resize(dn * maxcount);
+		for (int i=0; i<dn; i++) {
+			float lo = i * s;
+			float hi = (i + 1) * s;
+			float sum = 0;
+			for (int k=0; k<count[i]; k++) {
+				int j = first[i] + k;
+				float w = min(hi, (float)(j + 1)) - max(lo, (float)j);
+				weights[i * maxcount + k] = w;
+				sum += w;
+			}
+			for (int k=0; k<count[i]; k++)
+				weights[i * maxcount + k] /= sum;
+		}
+	}
+	float Weight (int i, int k) const { return weights[i * maxcount + k]; }
+};
+
+// Separable box resampling of rgb or rgba data. Colors are weighted by
+// alpha, so transparent texels don't darken the edges of sprites.
+static void ResampleBox (const unsigned char *src, int w, int h, int srcpitch, int depth,
+		unsigned char *dest, int dw, int dh, bool mirroring) {
+	TBoxWeights wx(w, dw);
+	TBoxWeights wy(h, dh);
+	bool alpha = depth == 4;
+
+	// horizontal pass: premultiplied channels followed by alpha
+	vector<float> tmp(h * dw * depth);
+	for (int y=0; y<h; y++) {
+		const unsigned char *row = src + y * srcpitch;
+		float *out = &tmp[y * dw * depth];
+		for (int i=0; i<dw; i++) {
+			float acc[4] = {0, 0, 0, 0};
+			for (int k=0; k<wx.count[i]; k++) {
+				const unsigned char *pix = row + (wx.first[i] + k) * depth;
+				float w = wx.Weight(i, k);
+				float a = alpha ? pix[3] / 255.f : 1.f;
+				for (int c=0; c<3; c++) acc[c] += w * a * pix[c];
+				if (alpha) acc[3] += w * pix[3];
+			}
+			for (int c=0; c<depth; c++) out[i * depth + c] = acc[c];
+		}
+	}
+
+	// vertical pass
+	for (int j=0; j<dh; j++) {
+		unsigned char *row = dest + (mirroring ? dh-1-j : j) * dw * depth;
+		for (int i=0; i<dw; i++) {
+			float acc[4] = {0, 0, 0, 0};
+			for (int k=0; k<wy.count[j]; k++) {
+				const float *pix = &tmp[((wy.first[j] + k) * dw + i) * depth];
+				float w = wy.Weight(j, k);
+				for (int c=0; c<depth; c++) acc[c] += w * pix[c];
+			}
+			float unmul = 1.f;
+			if (alpha) unmul = acc[3] > 0 ? 255.f / acc[3] : 0.f;
+			for (int c=0; c<3; c++)
+				row[i * depth + c] = (unsigned char)min(acc[c] * unmul + 0.5f, 255.f);
+			if (alpha)
+				row[i * depth + 3] = (unsigned char)min(acc[3] + 0.5f, 255.f);
+		}
+	}
+}
 #endif
 // --------------------------------------------------------------------
 //				class CImage
@@ -70,15 +160,14 @@ void CImage::DisposeData () {
 	data = NULL;
 }
 
-bool CImage::LoadPng (const char *filepath, bool mirroring,bool needsquared) {
+bool CImage::DecodePng (const char *filepath, bool mirroring,bool needpot) {
 	SDL_Surface *sdlImage;
 	unsigned char *sdlData;
 
-	sdlImage = IMG_Load (filepath);
-	if (sdlImage == 0) {
-		Message ("could not load image", filepath);
-		return false;
-	}
+	SDL_RWops *rw = VFileRW (filepath);
+	if (rw == NULL) return false;
+	sdlImage = IMG_Load_RW (rw, 1);
+	if (sdlImage == 0) return false;
 
 	nx    = sdlImage->w;
 	ny    = sdlImage->h;
@@ -86,15 +175,19 @@ bool CImage::LoadPng (const char *filepath, bool mirroring,bool needsquared) {
 	pitch = sdlImage->pitch;
 	DisposeData ();
 #ifdef USE_GLES1
-	int squared =GLES2D_p2(max(nx,ny));
-	data  = new unsigned char[squared * squared * depth];
+	int potx = GLES2D_p2(nx);
+	int poty = GLES2D_p2(ny);
+	bool resample = needpot && (potx != nx || poty != ny);
+	if (resample)
+		data  = new unsigned char[potx * poty * depth];
+	else
+		data  = new unsigned char[pitch * ny];
 #else
 	data  = new unsigned char[pitch * ny];
 #endif
 	if (SDL_MUSTLOCK (sdlImage)) {
 	    if (SDL_LockSurface (sdlImage) < 0) {
  			SDL_FreeSurface (sdlImage);
-			Message ("mustlock error");
 			return false;
 		};
 	}
@@ -102,7 +195,12 @@ bool CImage::LoadPng (const char *filepath, bool mirroring,bool needsquared) {
 	sdlData = (unsigned char *) sdlImage->pixels;
 
 #ifdef USE_GLES1
-	if (!needsquared || (squared == sdlImage->w && squared == sdlImage->h))
+	if (resample)
+	{
+		ResampleBox (sdlData, nx, ny, pitch, depth, data, potx, poty, mirroring);
+		pitch = potx * depth;
+	}
+	else
 	{
 		if (mirroring) {
 			for (int y=0; y<ny; y++) {
@@ -112,21 +210,6 @@ bool CImage::LoadPng (const char *filepath, bool mirroring,bool needsquared) {
 			memcpy(data, sdlData, ny*pitch);
 		}
 	}
-	else
-	{
-		int i, j, x, y, offset_y, offset_x;
-		for (j=0; j<squared; j++)
-		{
-			y = ((mirroring ? squared-1-j : j) * sdlImage->h) / squared;
-			offset_y = y * sdlImage->w;
-			for (i=0; i<squared; i++)
-			{
-				x = (i * sdlImage->w) / squared;
-				offset_x = (offset_y + x) * depth;
-				memcpy(&data[(i+j*squared)*depth],&sdlData[offset_x],depth);
-			}
-		}
-	}
 #else
 	if (mirroring) {
 		for (int y=0; y<ny; y++) {
@@ -142,70 +225,88 @@ bool CImage::LoadPng (const char *filepath, bool mirroring,bool needsquared) {
 	return true;
 }
 
-bool CImage::LoadPng (const char *dir, const char *filename, bool mirroring, bool needsquared) {
+bool CImage::LoadPng (const char *filepath, bool mirroring,bool needpot) {
+	if (!DecodePng (filepath, mirroring, needpot)) {
+		Message ("could not load image", filepath);
+		return false;
+	}
+	return true;
+}
+
+bool CImage::LoadPng (const char *dir, const char *filename, bool mirroring, bool needpot) {
 	string path = dir;
 	path += SEP;
 	path += filename;
-	return LoadPng (path.c_str(), mirroring, needsquared);
+	return LoadPng (path.c_str(), mirroring, needpot);
 }
 
 // ------------------ read framebuffer --------------------------------
 
-bool CImage::ReadFrameBuffer_PPM () {
-#ifndef USE_GLES1
-	int viewport[4];
+bool CImage::ReadFrameBuffer () {
+	GLint viewport[4];
 	glGetIntegerv (GL_VIEWPORT, viewport);
 
 	nx = viewport[2];
 	ny = viewport[3];
-	depth = 3;
+	depth = 4;
+	pitch = nx * depth;
 
 	DisposeData ();
 	data  = new unsigned char[nx * ny * depth];
 
-	glReadBuffer (GL_FRONT);
-
-	for (int i=0; i<viewport[3]; i++) {
-		glReadPixels (viewport[0], viewport[1] + viewport[3] - 1 - i,
-			viewport[2], 1, GL_RGB, GL_UNSIGNED_BYTE, data + viewport[2] * i * 3);
-	}
+#ifndef USE_GLES1
+	glReadBuffer (GL_BACK);
 #endif
-
+	glPixelStorei (GL_PACK_ALIGNMENT, 4);
+	glReadPixels (viewport[0], viewport[1], nx, ny, GL_RGBA, GL_UNSIGNED_BYTE, data);
 	return true;
 }
 
-void CImage::ReadFrameBuffer_TGA () {
-#ifndef USE_GLES1
-	nx = Winsys.resolution.width;
-	ny = Winsys.resolution.height;
-	depth = 3;
+void CImage::ConvertPixels (int newdepth, bool bgr, bool topdown) {
+	if (data == NULL)
+		return;
 
+	unsigned char *dest = new unsigned char[nx * ny * newdepth];
+	for (int y=0; y<ny; y++) {
+		const unsigned char *src = data + (topdown ? ny-1-y : y) * pitch;
+		unsigned char *row = dest + y * nx * newdepth;
+		for (int x=0; x<nx; x++) {
+			row[0] = src[bgr ? 2 : 0];
+			row[1] = src[1];
+			row[2] = src[bgr ? 0 : 2];
+			if (newdepth == 4) row[3] = depth == 4 ? src[3] : 255;
+			src += depth;
+			row += newdepth;
+		}
+	}
 	DisposeData ();
-	data  = new unsigned char[nx * ny * depth];
+	data = dest;
+	depth = newdepth;
+	pitch = nx * newdepth;
+}
 
-	glReadBuffer (GL_FRONT);
-	glReadPixels (0, 0, nx, ny, GL_BGR, GL_UNSIGNED_BYTE, data);
-#endif
+bool CImage::ReadFrameBuffer_PPM () {
+	if (!ReadFrameBuffer ())
+		return false;
+	ConvertPixels (3, false, true);
+	return true;
 }
 
-void CImage::ReadFrameBuffer_BMP () {
-#ifndef USE_GLES1
-	nx = Winsys.resolution.width;
-	ny = Winsys.resolution.height;
-	depth = 4;
+void CImage::ReadFrameBuffer_TGA () {
+	if (ReadFrameBuffer ())
+		ConvertPixels (3, true, false);
+}
 
-	DisposeData ();
-	data  = new unsigned char[nx * ny * depth];
-	glReadBuffer (GL_FRONT);
-	glReadPixels (0, 0, nx, ny, GL_BGRA, GL_UNSIGNED_BYTE, data);
-#endif
+void CImage::ReadFrameBuffer_BMP () {
+	if (ReadFrameBuffer ())
+		ConvertPixels (4, true, false);
 }
 
 // ---------------------------
 
-void CImage::WritePPM (const char *filepath) {
+bool CImage::WritePPM (const char *filepath) {
 	if (data == NULL)
-		return;
+		return false;
 
 	std::ofstream file(filepath);
 
@@ -215,6 +316,7 @@ void CImage::WritePPM (const char *filepath) {
 	     << "\n# max component value\n255"<< std::endl;
 
 	file.write(reinterpret_cast<char*>(data), depth * nx * ny);
+	return file.good();
 }
 
 #ifdef _MSC_VER
@@ -238,9 +340,9 @@ struct TTgaHeader {
 } __attribute__((packed));
 #endif
 
-void CImage::WriteTGA (const char *filepath) {
+bool CImage::WriteTGA (const char *filepath) {
 	if (data == NULL)
-		return;
+		return false;
 
 	TTgaHeader header;
 
@@ -258,6 +360,7 @@ void CImage::WriteTGA (const char *filepath) {
 	std::ofstream out(filepath, std::ios_base::out|std::ios_base::binary);
 	out.write(reinterpret_cast<char*>(&header), sizeof(TTgaHeader));
 	out.write(reinterpret_cast<char*>(data), 3 * nx * ny);
+	return out.good();
 }
 
 #define BF_TYPE 0x4D42             // "MB"
@@ -296,9 +399,34 @@ struct TBmpInfo {
 } __attribute__((packed));
 #endif
 
-void CImage::WriteBMP (const char *filepath) {
+// data must be top down rgb or rgba, see ConvertPixels
+bool CImage::WritePNG (const char *filepath) {
 	if (data == NULL)
-		return;
+		return false;
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	Uint32 rmask = 0xff000000 >> (32 - 8 * depth);
+	Uint32 gmask = 0x00ff0000 >> (32 - 8 * depth);
+	Uint32 bmask = 0x0000ff00 >> (32 - 8 * depth);
+	Uint32 amask = depth == 4 ? 0x000000ff : 0;
+#else
+	Uint32 rmask = 0x000000ff;
+	Uint32 gmask = 0x0000ff00;
+	Uint32 bmask = 0x00ff0000;
+	Uint32 amask = depth == 4 ? 0xff000000 : 0;
+#endif
+	SDL_Surface *surface = SDL_CreateRGBSurfaceFrom (data, nx, ny, 8 * depth, pitch,
+		rmask, gmask, bmask, amask);
+	if (surface == NULL)
+		return false;
+	bool ok = IMG_SavePNG (surface, filepath) == 0;
+	SDL_FreeSurface (surface);
+	return ok;
+}
+
+bool CImage::WriteBMP (const char *filepath) {
+	if (data == NULL)
+		return false;
 
 	int infosize = 40;
 	int width = nx;
@@ -331,34 +459,125 @@ void CImage::WriteBMP (const char *filepath) {
 	info.biClrImportant = 0;
 
 	std::ofstream out(filepath, std::ios_base::out|std::ios_base::binary);
-	if (!out) {
-		Message ("could not open bmp file", filepath);
-		return;
-	}
+	if (!out)
+		return false;
 
 	out.write(reinterpret_cast<char*>(&header), sizeof(TBmpHeader));
 	out.write(reinterpret_cast<char*>(&info), sizeof(TBmpInfo));
 
 	out.write(reinterpret_cast<char*>(data), bitsize);
+	return out.good();
 }
 
 // --------------------------------------------------------------------
 //				class TTexture
 // --------------------------------------------------------------------
+
+// textures converted by etc1conv are stored next to the png
+static string CompressedPath(const string& filename) {
+	if (filename.size() < 4 || filename.compare(filename.size() - 4, 4, ".png") != 0)
+		return "";
+	return filename.substr(0, filename.size() - 4) + ".pkm";
+}
+
+static bool LoadCompressed(const string& filename, TETC1Image& etc) {
+	string path = CompressedPath(filename);
+	CVFile file;
+	if (path.empty() || !file.Open(path)) return false;
+	return etc.Load(file.Data(), file.Size());
+}
+
+// size of the uploaded level 0
+static size_t ImageBytes(const CImage& texImage) {
+#ifdef USE_GLES1
+	return (size_t)GLES2D_p2(texImage.nx) * GLES2D_p2(texImage.ny) * texImage.depth;
+#else
+	return (size_t)texImage.nx * texImage.ny * texImage.depth;
+#endif
+}
+
+static bool ETC1Supported() {
+	static int supported = -1;
+	if (supported < 0) {
+		const char *ext = (const char*)glGetString (GL_EXTENSIONS);
+		supported = ext != NULL && strstr (ext, "GL_OES_compressed_ETC1_RGB8_texture") != NULL;
+	}
+	return supported != 0;
+}
+
 TTexture::~TTexture() {
-	glDeleteTextures (1, &id);
+	TexCache.Remove (this);
+	if (!shared)
+		DeleteTextures (1, &id);
+}
+
+void TTexture::SetSource(const string& filename, bool mipmap, bool repeatable) {
+	source = filename;
+	source_mipmap = mipmap;
+	source_repeat = repeatable;
+	failed = false;
+}
+
+void TTexture::Reload() {
+	if (source_mipmap)
+		failed = !LoadMipmap(source, source_repeat);
+	else
+		failed = !Load(source);
+}
+
+void TTexture::Preload() {
+	if (id == 0 && !source.empty() && !failed)
+		Reload();
+}
+
+void TTexture::Unload() {
+	if (id == 0 || source.empty() || shared) return;
+	TexCache.Remove (this);
+	DeleteTextures (1, &id);
+	id = 0;
 }
 
 bool TTexture::Load(const string& filename) {
+	SetSource(filename, false, false);
+	TETC1Image etc;
+	if (LoadCompressed(filename, etc)) {
+		UploadETC1(etc, false, false);
+		return true;
+	}
+
 	CImage texImage;
 
-	if (texImage.LoadPng (filename.c_str(), true) == false)
+	if (texImage.LoadPng (filename.c_str(), true, true) == false)
 		return false;
 
-#ifdef USE_GLES1
+	Upload(texImage);
+	return true;
+}
+bool TTexture::Load(const string& dir, const string& filename) {
+	return Load(dir + SEP + filename);
+}
+bool TTexture::LoadMipmap(const string& filename, bool repeatable) {
+	SetSource(filename, true, repeatable);
+	TETC1Image etc;
+	if (LoadCompressed(filename, etc)) {
+		UploadETC1(etc, true, repeatable);
+		return true;
+	}
+
+	CImage texImage;
+	if (texImage.LoadPng (filename.c_str(), true, true) == false)
+		return false;
+
+	UploadMipmap(texImage, repeatable);
+	return true;
+}
+bool TTexture::LoadMipmap(const string& dir, const string& filename, bool repeatable) {
+	return LoadMipmap(dir + SEP + filename, repeatable);
+}
+
+void TTexture::Upload(CImage& texImage) {
 	width = texImage.nx;
 	height= texImage.ny;
-#endif
 
 	glGenTextures (1, &id);
 	Bind();
@@ -385,15 +604,12 @@ bool TTexture::Load(const string& filename) {
 		texImage.ny, 0, format, GL_UNSIGNED_BYTE, texImage.data);
 #endif
 	texImage.DisposeData();
-    return true;
-}
-bool TTexture::Load(const string& dir, const string& filename) {
-	return Load(dir + SEP + filename);
+	TexCache.Add (this, ImageBytes (texImage));
 }
-bool TTexture::LoadMipmap(const string& filename, bool repeatable) {
-    CImage texImage;
-	if (texImage.LoadPng (filename.c_str(), true,!repeatable) == false)
-		return false;
+
+void TTexture::UploadMipmap(CImage& texImage, bool repeatable) {
+	width = texImage.nx;
+	height= texImage.ny;
 
 	glGenTextures (1, &id);
 	Bind();
@@ -421,53 +637,100 @@ bool TTexture::LoadMipmap(const string& filename, bool repeatable) {
 
 #ifdef USE_GLES1
 	glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
-	if (repeatable)
-	{
-		glTexImage2D
-			(GL_TEXTURE_2D, 0, format, texImage.nx,
-			texImage.ny, 0, format, GL_UNSIGNED_BYTE, texImage.data);
-	}
-	else
-	{
-		int squared = GLES2D_p2(max(texImage.nx,texImage.ny));
-		glTexImage2D
-			(GL_TEXTURE_2D, 0, format, squared,
-			squared, 0, format, GL_UNSIGNED_BYTE, texImage.data);
-	}
+	glTexImage2D
+		(GL_TEXTURE_2D, 0, format, GLES2D_p2(texImage.nx),
+		GLES2D_p2(texImage.ny), 0, format, GL_UNSIGNED_BYTE, texImage.data);
 #else
 	gluBuild2DMipmaps
 		(GL_TEXTURE_2D, texImage.depth, texImage.nx,
 		texImage.ny, format, GL_UNSIGNED_BYTE, texImage.data);
 #endif
 	texImage.DisposeData();
-    return true;
+	TexCache.Add (this, ImageBytes (texImage) * 4 / 3);
 }
-bool TTexture::LoadMipmap(const string& dir, const string& filename, bool repeatable) {
-	return LoadMipmap(dir + SEP + filename, repeatable);
+void TTexture::UploadETC1(const TETC1Image& etc, bool mipmap, bool repeatable) {
+	if (!ETC1Supported()) {
+		// decode in software and upload as plain rgb
+		CImage texImage;
+		texImage.nx = etc.width;
+		texImage.ny = etc.height;
+		texImage.depth = 3;
+		texImage.pitch = etc.width * 3;
+		texImage.data = new unsigned char[etc.width * etc.height * 3];
+		ETC1DecodeImage (&etc.levels[0][0], etc.width, etc.height, texImage.data);
+		if (mipmap) UploadMipmap(texImage, repeatable);
+		else Upload(texImage);
+		return;
+	}
+
+	width = etc.width;
+	height = etc.height;
+
+	glGenTextures (1, &id);
+	Bind();
+
+	if (repeatable) {
+		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	} else {
+		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// compressed textures can't use GL_GENERATE_MIPMAP, the file holds the chain
+	size_t levels = mipmap ? etc.levels.size() : 1;
+	if (mipmap && levels > 1)
+		glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+	else if (mipmap)
+		glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	else
+		glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+	size_t texbytes = 0;
+	for (size_t i=0; i<levels; i++) {
+		glCompressedTexImage2D (GL_TEXTURE_2D, i, GL_ETC1_RGB8_OES,
+			etc.LevelWidth(i), etc.LevelHeight(i), 0,
+			etc.levels[i].size(), &etc.levels[i][0]);
+		texbytes += etc.levels[i].size();
+	}
+	TexCache.Add (this, texbytes);
 }
-static GLuint currentTexID = 0;
 
-void TTexture::Bind() {
-	if (currentTexID != id)
-	{
-		glBindTexture (GL_TEXTURE_2D, id);
-		currentTexID = id;
+void TTexture::SetAtlasArea(GLuint atlas, int x, int y, int w, int h, int pagew, int pageh) {
+	id = atlas;
+	shared = true;
+	width = w;
+	height = h;
+	u0 = (GLfloat)x / pagew;
+	v0 = (GLfloat)y / pageh;
+	u1 = (GLfloat)(x + w) / pagew;
+	v1 = (GLfloat)(y + h) / pageh;
+}
+
+void TTexture::MapTexCoords(const GLfloat *in, GLfloat *out, size_t n) const {
+	for (size_t i=0; i<n; i++) {
+		out[i*2]   = u0 + in[i*2]   * (u1 - u0);
+		out[i*2+1] = v0 + in[i*2+1] * (v1 - v0);
 	}
 }
 
+void TTexture::Bind() {
+	Preload();
+	BindTexture (id);
+	TexCache.Touch (this);
+}
+
 void TTexture::Draw() {
 	GLshort w, h;
-	glEnable (GL_TEXTURE_2D);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	Bind();
 
-#ifdef USE_GLES1
 	w=this->width;
 	h=this->height;
-#else
-	glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
-	glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
-#endif
+	GLfloat tex[8];
+	MapTexCoords(fullsize_texture, tex, 4);
 
 	glColor4f(1.0, 1.0, 1.0, 1.0);
 	const GLshort vtx[] = {
@@ -480,7 +743,7 @@ void TTexture::Draw() {
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	glVertexPointer(2, GL_SHORT, 0, vtx);
-	glTexCoordPointer(2, GL_SHORT, 0, fullsize_texture);
+	glTexCoordPointer(2, GL_FLOAT, 0, tex);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -491,17 +754,14 @@ void TTexture::Draw(int x, int y, float size, Orientation orientation) {
 	GLint w, h;
 	GLfloat width, height, top, bott, left, right;
 
-	glEnable (GL_TEXTURE_2D);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	Bind();
 
-#ifdef USE_GLES1
 	w=this->width;
 	h=this->height;
-#else
-	glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &w);
-	glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &h);
-#endif
+	GLfloat tex[8];
+	MapTexCoords(fullsize_texture, tex, 4);
 
 	width  = w * size;
 	height = h * size;
@@ -529,7 +789,7 @@ void TTexture::Draw(int x, int y, float size, Orientation orientation) {
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glTexCoordPointer(2, GL_SHORT, 0, fullsize_texture);
+	glTexCoordPointer(2, GL_FLOAT, 0, tex);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -539,9 +799,11 @@ void TTexture::Draw(int x, int y, float size, Orientation orientation) {
 void TTexture::Draw(int x, int y, float width, float height, Orientation orientation) {
 	GLfloat top, bott, left, right;
 
-	glEnable (GL_TEXTURE_2D);
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	Bind();
+	GLfloat tex[8];
+	MapTexCoords(fullsize_texture, tex, 4);
 
 	if (orientation == OR_TOP) {
 		top = Winsys.resolution.height - y;
@@ -565,7 +827,7 @@ void TTexture::Draw(int x, int y, float width, float height, Orientation orienta
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glTexCoordPointer(2, GL_SHORT, 0, fullsize_texture);
+	glTexCoordPointer(2, GL_FLOAT, 0, tex);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -582,22 +844,19 @@ void TTexture::DrawFrame(int x, int y, ETR_DOUBLE w, ETR_DOUBLE h, int frame, co
 	GLshort yy = Winsys.resolution.height - hh - y;
 
 	Bind();
+	GLfloat tex[8];
+	MapTexCoords(fullsize_texture, tex, 4);
 
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 
 	if (frame > 0) {
-#ifdef USE_GLES1
 		if (w < 1) ww=this->width;
 		if (h < 1) hh=this->height;
-#else
-		if (w < 1) glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &ww);
-		if (h < 1) glGetTexLevelParameteriv (GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &hh);
-#endif
 
 		glColor(col, 1.0);
 
-		glDisable (GL_TEXTURE_2D);
+		GLDisable (GL_TEXTURE_2D);
 		const GLint vtx [] = {
 			xx - frame, yy - frame,
 			xx + ww + frame, yy - frame,
@@ -608,7 +867,7 @@ void TTexture::DrawFrame(int x, int y, ETR_DOUBLE w, ETR_DOUBLE h, int frame, co
 		glVertexPointer(2, GL_INT, 0, vtx);
 		glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
-		glEnable (GL_TEXTURE_2D);
+		GLEnable (GL_TEXTURE_2D);
 	}
 
 	glColor4f (1.0, 1.0, 1.0, 1.0);
@@ -621,13 +880,348 @@ void TTexture::DrawFrame(int x, int y, ETR_DOUBLE w, ETR_DOUBLE h, int frame, co
 	};
 
 	glVertexPointer(2, GL_SHORT, 0, vtx);
-	glTexCoordPointer(2, GL_SHORT, 0, fullsize_texture);
+	glTexCoordPointer(2, GL_FLOAT, 0, tex);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	glDisableClientState(GL_VERTEX_ARRAY);
 }
 
+// --------------------------------------------------------------------
+//				class CTextureBatch
+// --------------------------------------------------------------------
+
+CTextureBatch::~CTextureBatch () {
+	group.Wait ();
+	for (size_t i=0; i<jobs.size(); i++)
+		delete jobs[i];
+}
+
+void CTextureBatch::Decode (void *arg) {
+	TJob *job = static_cast<TJob*>(arg);
+	string etcpath = CompressedPath (job->path);
+	CVFile file;
+	job->compressed = !etcpath.empty() && file.Open (etcpath)
+		&& job->etc.Load (file.Data(), file.Size());
+	if (job->compressed)
+		job->ok = true;
+	else
+		job->ok = job->image.DecodePng (job->path.c_str(), true, true);
+}
+
+void CTextureBatch::Add (TTexture* tex, const string& path, bool mipmap, bool repeatable) {
+	TJob *job = new TJob;
+	job->tex = tex;
+	job->path = path;
+	job->mipmap = mipmap;
+	job->repeatable = repeatable;
+	job->compressed = false;
+	job->ok = false;
+	tex->SetSource (path, mipmap, repeatable);
+	jobs.push_back (job);
+	group.Push (Decode, job);
+}
+
+void CTextureBatch::Add (TTexture* tex, const string& dir, const string& filename, bool mipmap, bool repeatable) {
+	Add (tex, dir + SEP + filename, mipmap, repeatable);
+}
+
+size_t CTextureBatch::Finish () {
+	group.Wait ();
+
+	size_t loaded = 0;
+	for (size_t i=0; i<jobs.size(); i++) {
+		TJob *job = jobs[i];
+		if (!job->ok) {
+			Message ("could not load image", job->path);
+		} else {
+			if (job->compressed)
+				job->tex->UploadETC1 (job->etc, job->mipmap, job->repeatable);
+			else if (job->mipmap)
+				job->tex->UploadMipmap (job->image, job->repeatable);
+			else
+				job->tex->Upload (job->image);
+			loaded++;
+		}
+		delete job;
+	}
+	jobs.clear();
+	return loaded;
+}
+
+// --------------------------------------------------------------------
+//				class CTextureCache
+// --------------------------------------------------------------------
+
+CTextureCache TexCache;
+
+CTextureCache::CTextureCache () {
+	first = NULL;
+	last = NULL;
+	bytes = 0;
+	budget = 0;
+	frame = 0;
+}
+
+void CTextureCache::Unlink (TTexture *tex) {
+	if (tex->prev) tex->prev->next = tex->next;
+	else first = tex->next;
+	if (tex->next) tex->next->prev = tex->prev;
+	else last = tex->prev;
+	tex->prev = NULL;
+	tex->next = NULL;
+}
+
+void CTextureCache::LinkFront (TTexture *tex) {
+	tex->prev = NULL;
+	tex->next = first;
+	if (first) first->prev = tex;
+	else last = tex;
+	first = tex;
+}
+
+void CTextureCache::SetBudget (size_t budgetbytes) {
+	budget = budgetbytes;
+	Trim ();
+}
+
+void CTextureCache::Add (TTexture *tex, size_t texbytes) {
+	Remove (tex);
+	tex->bytes = texbytes;
+	tex->lastuse = frame;
+	tex->cached = true;
+	LinkFront (tex);
+	bytes += texbytes;
+	Trim ();
+}
+
+void CTextureCache::Remove (TTexture *tex) {
+	if (!tex->cached) return;
+	Unlink (tex);
+	bytes -= tex->bytes;
+	tex->bytes = 0;
+	tex->cached = false;
+}
+
+void CTextureCache::Touch (TTexture *tex) {
+	if (!tex->cached) return;
+	tex->lastuse = frame;
+	if (tex != first) {
+		Unlink (tex);
+		LinkFront (tex);
+	}
+}
+
+void CTextureCache::Trim () {
+	TTexture *tex = last;
+	while (budget > 0 && bytes > budget && tex != NULL) {
+		// the rest of the list has been used in this frame, too
+		if (tex->lastuse == frame) break;
+		TTexture *prev = tex->prev;
+		tex->Unload ();
+		tex = prev;
+	}
+}
+
+// --------------------------------------------------------------------
+//				class CTextureAtlas
+// --------------------------------------------------------------------
+
+// border around each image, filled with its edge texels, so linear
+// filtering never picks up the neighbours
+#define ATLAS_PAD 2
+#define ATLAS_MAX_SIZE 1024
+
+CTextureAtlas::~CTextureAtlas () {
+	group.Wait ();
+	for (size_t i=0; i<entries.size(); i++)
+		delete entries[i];
+}
+
+void CTextureAtlas::Decode (void *arg) {
+	TEntry *entry = static_cast<TEntry*>(arg);
+	entry->ok = entry->image.DecodePng (entry->path.c_str(), true, false);
+}
+
+void CTextureAtlas::Add (TTexture* tex, const string& dir, const string& filename) {
+	TEntry *entry = new TEntry;
+	entry->tex = tex;
+	entry->path = dir + SEP + filename;
+	entry->ok = false;
+	entry->x = 0;
+	entry->y = 0;
+	entries.push_back (entry);
+	group.Push (Decode, entry);
+}
+
+bool CTextureAtlas::CompareHeight (const TEntry* a, const TEntry* b) {
+	if (a->image.ny != b->image.ny) return a->image.ny > b->image.ny;
+	return a->image.nx > b->image.nx;
+}
+
+// Skyline (bottom left) packing into a page of width pagew, the list is
+// sorted by height. The padding is only needed between images, the page
+// border is handled by GL_CLAMP_TO_EDGE. Returns how many entries fit below
+// maxh, usedh gets the height they need.
+struct TSkylineNode {
+	int x, y, w;
+	TSkylineNode (int x_, int y_, int w_) : x(x_), y(y_), w(w_) {}
+};
+
+size_t CTextureAtlas::Pack (const vector<TEntry*>& list, int pagew, int maxh, int *usedh) const {
+	int width = pagew + 2 * ATLAS_PAD;
+	int height = maxh + 2 * ATLAS_PAD;
+	vector<TSkylineNode> skyline;
+	skyline.push_back (TSkylineNode (0, 0, width));
+	int top = 0;
+
+	size_t n = 0;
+	for (; n<list.size(); n++) {
+		int w = list[n]->image.nx + 2 * ATLAS_PAD;
+		int h = list[n]->image.ny + 2 * ATLAS_PAD;
+
+		// lowest position, the rect rests on the nodes it covers
+		int besti = -1;
+		int besty = height;
+		for (size_t i=0; i<skyline.size(); i++) {
+			int x = skyline[i].x;
+			if (x + w > width) break;
+			int y = 0;
+			for (size_t j=i; j<skyline.size() && skyline[j].x < x + w; j++)
+				y = max(y, skyline[j].y);
+			if (y + h <= height && y < besty) {
+				besti = (int)i;
+				besty = y;
+			}
+		}
+		if (besti < 0) break;
+
+		int x = skyline[besti].x;
+		list[n]->x = x;
+		list[n]->y = besty;
+		top = max(top, besty + h);
+
+		// raise the covered part of the skyline
+		vector<TSkylineNode> next (skyline.begin(), skyline.begin() + besti);
+		next.push_back (TSkylineNode (x, besty + h, w));
+		for (size_t i=besti; i<skyline.size(); i++) {
+			int right = skyline[i].x + skyline[i].w;
+			if (right <= x + w) continue;
+			if (skyline[i].x < x + w)
+				next.push_back (TSkylineNode (x + w, skyline[i].y, right - x - w));
+			else
+				next.push_back (skyline[i]);
+		}
+		skyline.clear();
+		for (size_t i=0; i<next.size(); i++) {
+			if (!skyline.empty() && skyline.back().y == next[i].y)
+				skyline.back().w += next[i].w;
+			else
+				skyline.push_back (next[i]);
+		}
+	}
+	*usedh = max(top - 2 * ATLAS_PAD, 0);
+	return n;
+}
+
+// Builds one page from the front of the list and removes the packed entries.
+// The page is the smallest power of two that holds the most entries.
+void CTextureAtlas::BuildPage (vector<TEntry*>& list, int maxsize) {
+	int pagew = maxsize;
+	int pageh = maxsize;
+	size_t count = 0;
+	for (int w=64; w<=maxsize; w*=2) {
+		int usedh;
+		size_t n = Pack (list, w, maxsize, &usedh);
+		int h = GLES2D_p2 (usedh);
+		if (n > count || (n == count && n > 0 && w * h < pagew * pageh)) {
+			count = n;
+			pagew = w;
+			pageh = h;
+		}
+	}
+	if (count == 0) return;
+	int usedh;
+	Pack (list, pagew, pageh, &usedh);
+
+	vector<unsigned char> data (pagew * pageh * 4, 0);
+	for (size_t i=0; i<count; i++) {
+		const CImage& img = list[i]->image;
+		int left = list[i]->x;
+		int bott = list[i]->y;
+		for (int y=max(bott-ATLAS_PAD, 0); y<min(bott+img.ny+ATLAS_PAD, pageh); y++) {
+			int sy = clamp(0, y - bott, img.ny-1);
+			for (int x=max(left-ATLAS_PAD, 0); x<min(left+img.nx+ATLAS_PAD, pagew); x++) {
+				int sx = clamp(0, x - left, img.nx-1);
+				const unsigned char *src = img.data + sy * img.pitch + sx * img.depth;
+				unsigned char *dest = &data[(y * pagew + x) * 4];
+				dest[0] = src[0];
+				dest[1] = src[1];
+				dest[2] = src[2];
+				dest[3] = img.depth == 4 ? src[3] : 255;
+			}
+		}
+	}
+
+	GLuint id;
+	glGenTextures (1, &id);
+	BindTexture (id);
+	glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+#ifdef USE_GLES1
+	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+#else
+	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameterf (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+#endif
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA, pagew, pageh, 0,
+		GL_RGBA, GL_UNSIGNED_BYTE, &data[0]);
+	pages.push_back (id);
+
+	for (size_t i=0; i<count; i++) {
+		TEntry *entry = list[i];
+		entry->tex->SetAtlasArea (id, entry->x, entry->y,
+			entry->image.nx, entry->image.ny, pagew, pageh);
+		entry->image.DisposeData ();
+	}
+	list.erase (list.begin(), list.begin() + count);
+}
+
+void CTextureAtlas::Finish () {
+	group.Wait ();
+
+	GLint maxtex = ATLAS_MAX_SIZE;
+	glGetIntegerv (GL_MAX_TEXTURE_SIZE, &maxtex);
+	int maxsize = min((int)maxtex, ATLAS_MAX_SIZE);
+
+	vector<TEntry*> list;
+	for (size_t i=0; i<entries.size(); i++) {
+		TEntry *entry = entries[i];
+		if (!entry->ok)
+			Message ("could not load image", entry->path);
+		else if (entry->image.nx + 2 * ATLAS_PAD > maxsize
+		      || entry->image.ny + 2 * ATLAS_PAD > maxsize)
+			entry->tex->Load (entry->path);	// too big, gets its own texture
+		else
+			list.push_back (entry);
+	}
+	stable_sort (list.begin(), list.end(), CompareHeight);
+	while (!list.empty())
+		BuildPage (list, maxsize);
+
+	for (size_t i=0; i<entries.size(); i++)
+		delete entries[i];
+	entries.clear();
+}
+
+void CTextureAtlas::Free () {
+	if (!pages.empty())
+		DeleteTextures ((GLsizei)pages.size(), &pages[0]);
+	pages.clear();
+}
+
 // --------------------------------------------------------------------
 //				class CTexture
 // --------------------------------------------------------------------
@@ -645,6 +1239,7 @@ CTexture::~CTexture () {
 void CTexture::LoadTextureList () {
 	FreeTextureList();
 	CSPList list (200);
+	CTextureBatch batch;
 	if (list.Load (param.tex_dir, "textures.lst")) {
 		for (size_t i=0; i<list.Count(); i++) {
 			const string& line = list.Line(i);
@@ -653,16 +1248,19 @@ void CTexture::LoadTextureList () {
 			CommonTex.resize(max(CommonTex.size(), (size_t)id+1));
 			string texfile = SPStrN (line, "file");
 			bool rep = SPBoolN (line, "repeat", false);
+			bool atlas = SPBoolN (line, "atlas", false);
 			if (id >= 0) {
 				CommonTex[id] = new TTexture();
-				if (rep)
-					CommonTex[id]->LoadMipmap(param.tex_dir, texfile, rep);
+				if (atlas && !rep)
+					Atlas.Add(CommonTex[id], param.tex_dir, texfile);
 				else
-					CommonTex[id]->Load(param.tex_dir, texfile);
+					batch.Add(CommonTex[id], param.tex_dir, texfile, rep, rep);
 
 				Index[name] = CommonTex[id];
 			} else Message ("wrong texture id in textures.lst");
 		}
+		batch.Finish();
+		Atlas.Finish();
 	} else Message ("failed to load common textures");
 }
 
@@ -672,6 +1270,7 @@ void CTexture::FreeTextureList () {
 	}
 	CommonTex.clear();
 	Index.clear();
+	Atlas.Free();
 }
 
 TTexture* CTexture::GetTexture (size_t idx) const {
@@ -742,7 +1341,7 @@ void CTexture::SetOrientation (Orientation orientation) {
 
 // -------------------------- numeric strings -------------------------
 
-void CTexture::DrawNumChr (char c, int x, int y, int w, int h, const TColor& col) {
+void CTexture::DrawNumChr (const TTexture* tex, char c, int x, int y, int w, int h, const TColor& col) {
 	int idx;
 	if(isdigit(c)) {
 		char chrname[2] = {c, '\0'};
@@ -759,12 +1358,14 @@ void CTexture::DrawNumChr (char c, int x, int y, int w, int h, const TColor& col
 	float texleft = idx * texw;
 	float texright = (idx + 1) * texw;
 
-	const GLfloat tex[] = {
+	const GLfloat coords[] = {
 		texleft, 0,
 		texright, 0,
 		texright, 1,
 		texleft, 1
 	};
+	GLfloat texcoords[8];
+	tex->MapTexCoords(coords, texcoords, 4);
 	const GLfloat vtx[] = {
 		GLfloat(x),           GLfloat(Winsys.resolution.height - y - h),
 		GLfloat(x + w * 0.9), GLfloat(Winsys.resolution.height - y - h),
@@ -773,17 +1374,19 @@ void CTexture::DrawNumChr (char c, int x, int y, int w, int h, const TColor& col
 	};
 
 	glVertexPointer(2, GL_FLOAT, 0, vtx);
-	glTexCoordPointer(2, GL_FLOAT, 0, tex);
+	glTexCoordPointer(2, GL_FLOAT, 0, texcoords);
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 }
 
 void CTexture::DrawNumStr (const string& s, int x, int y, float size, const TColor& col) {
-	if (!BindTex ("ziff032")) {
+	map<string, TTexture*>::const_iterator it = Index.find ("ziff032");
+	if (it == Index.end()) {
 		Message ("DrawNumStr: missing texture");
 		return;
 	}
-	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable (GL_TEXTURE_2D);
+	it->second->Bind();
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLEnable (GL_TEXTURE_2D);
 	int qw = (int)(22 * size);
 	int qh = (int)(32 * size);
 
@@ -791,7 +1394,7 @@ void CTexture::DrawNumStr (const string& s, int x, int y, float size, const TCol
 	glEnableClientState(GL_VERTEX_ARRAY);
 	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
 	for (size_t i=0; i < s.size(); i++) {
-		DrawNumChr (s[i], x + (int)i*qw, y, qw, qh, col);
+		DrawNumChr (it->second, s[i], x + (int)i*qw, y, qw, qh, col);
 	}
 	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 	glDisableClientState(GL_VERTEX_ARRAY);
@@ -804,30 +1407,63 @@ void CTexture::DrawNumStr (const string& s, int x, int y, float size, const TCol
 // 0 ppm, 1 tga, 2 bmp
 #define SCREENSHOT_PROC 2
 
-void ScreenshotN () {
+struct TScreenshotJob {
 	CImage image;
-	string path = param.screenshot_dir;
-	path += SEP;
-	path += g_game.course->dir;
-	path += "_";
-	path += GetTimeString();
-	int type = SCREENSHOT_PROC;
+	string path;
+	int type;
+};
 
-	switch (type) {
+static bool screenshot_requested = false;
+
+// runs on a worker, the image holds the raw rgba framebuffer
+static void WriteScreenshot (void *arg) {
+	TScreenshotJob *job = static_cast<TScreenshotJob*>(arg);
+	bool ok = false;
+	switch (job->type) {
 		case 0:
-			path += ".ppm";
-			image.ReadFrameBuffer_PPM ();
-			image.WritePPM (path.c_str());
+			job->image.ConvertPixels (3, false, true);
+			ok = job->image.WritePPM (job->path.c_str());
 			break;
 		case 1:
-			path += ".tga";
-			image.ReadFrameBuffer_TGA ();
-			image.WriteTGA (path.c_str());
+			job->image.ConvertPixels (3, true, false);
+			ok = job->image.WriteTGA (job->path.c_str());
 			break;
 		case 2:
-			path += ".bmp";
-			image.ReadFrameBuffer_BMP ();
-			image.WriteBMP (path.c_str());
+			job->image.ConvertPixels (4, true, false);
+			ok = job->image.WriteBMP (job->path.c_str());
 			break;
 	}
+	if (!ok) Message ("could not write", job->path);
+	delete job;
+}
+
+void ScreenshotN () {
+	screenshot_requested = true;
+}
+
+void CaptureScreenshot () {
+	if (!screenshot_requested)
+		return;
+	screenshot_requested = false;
+
+	TScreenshotJob *job = new TScreenshotJob;
+	job->path = param.screenshot_dir;
+	job->path += SEP;
+	if (g_game.course != NULL) {
+		job->path += g_game.course->dir;
+		job->path += "_";
+	}
+	job->path += GetTimeString();
+	job->type = SCREENSHOT_PROC;
+	switch (job->type) {
+		case 0: job->path += ".ppm"; break;
+		case 1: job->path += ".tga"; break;
+		case 2: job->path += ".bmp"; break;
+	}
+
+	if (!job->image.ReadFrameBuffer ()) {
+		delete job;
+		return;
+	}
+	Workers.Push (WriteScreenshot, job);
 }
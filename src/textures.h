@@ -19,6 +19,8 @@ GNU General Public License for more details.
 #define TEXTURES_H
 
 #include "bh.h"
+#include "etc1.h"
+#include "workers.h"
 #include <vector>
 #include <map>
 
@@ -74,17 +76,26 @@ public:
 
 	void DisposeData ();
 
-	// load:
-	bool LoadPng (const char *filepath, bool mirroring,bool needsquared = false);
-	bool LoadPng (const char *dir, const char *filepath, bool mirroring,bool needsquared = false);
-
-	// write:
+	// load: with needpot (GLES only) images that aren't power-of-two are
+	// box filtered up to the next power of two in each direction. nx and ny
+	// keep the original size.
+	bool DecodePng (const char *filepath, bool mirroring,bool needpot = false);	// silent, thread safe
+	bool LoadPng (const char *filepath, bool mirroring,bool needpot = false);
+	bool LoadPng (const char *dir, const char *filepath, bool mirroring,bool needpot = false);
+
+	// write: ReadFrameBuffer reads the viewport as rgba, bottom row first,
+	// which is the only format GLES guarantees. ConvertPixels makes the
+	// layout of the file formats from it and doesn't need the GL context,
+	// so it can run on a worker together with the Write functions.
+	bool ReadFrameBuffer ();
+	void ConvertPixels (int newdepth, bool bgr, bool topdown);
 	bool ReadFrameBuffer_PPM ();
 	void ReadFrameBuffer_TGA ();
 	void ReadFrameBuffer_BMP ();
-	void WritePPM (const char *filepath);
-	void WriteTGA (const char *filepath);
-	void WriteBMP (const char *filepath);
+	bool WritePPM (const char *filepath);
+	bool WriteTGA (const char *filepath);
+	bool WriteBMP (const char *filepath);
+	bool WritePNG (const char *filepath);
 };
 
 // --------------------------------------------------------------------
@@ -94,35 +105,118 @@ public:
 class TTexture {
 	TTexture(const TTexture&);
 	TTexture& operator=(const TTexture&);
+	friend class CTextureCache;
 
 	GLuint id;
+	GLfloat u0, v0, u1, v1;	// area on the atlas page, 0..1 for a plain texture
+	bool shared;			// id belongs to an atlas page
+
+	// the file is reloaded by Bind() after the texture has been evicted
+	string source;
+	bool source_mipmap;
+	bool source_repeat;
+	bool failed;
+
+	// residency, see CTextureCache
+	size_t bytes;
+	unsigned int lastuse;
+	bool cached;
+	TTexture *prev, *next;
+
+	void Reload();
 public:
 
-	TTexture() : id(0) {}
+	TTexture() : id(0), u0(0), v0(0), u1(1), v1(1), shared(false),
+		source_mipmap(false), source_repeat(false), failed(false),
+		bytes(0), lastuse(0), cached(false), prev(NULL), next(NULL),
+		width(0), height(0) {}
 	~TTexture();
+
+	// nothing is loaded before the first Bind() or Preload()
+	void SetSource(const string& filename, bool mipmap, bool repeatable);
+	void Preload();
+	void Unload();	// frees the GL texture, Bind() loads it again
 	bool Load(const string& filename);
 	bool Load(const string& dir, const string& filename);
 	bool LoadMipmap(const string& filename, bool repeatable);
 	bool LoadMipmap(const string& dir, const string& filename, bool repeatable);
 
+	void Upload(CImage& texImage);
+	void UploadMipmap(CImage& texImage, bool repeatable);
+	void UploadETC1(const TETC1Image& etc, bool mipmap, bool repeatable);
+	void SetAtlasArea(GLuint atlas, int x, int y, int w, int h, int pagew, int pageh);
+
+	// maps n texcoord pairs in 0..1 of the image onto the atlas page
+	void MapTexCoords(const GLfloat *in, GLfloat *out, size_t n) const;
+
 	void Bind();
 	void Draw();
 	void Draw(int x, int y, float size, Orientation orientation);
 	void Draw(int x, int y, float width, float height, Orientation orientation);
 	void DrawFrame(int x, int y, ETR_DOUBLE w, ETR_DOUBLE h, int frame, const TColor& col);
-#ifdef USE_GLES1
 	int width;
 	int height;
-#endif
+};
+
+// Decodes the added images on the worker pool, Finish() uploads them on the
+// calling thread (which must own the GL context) in the order they were added
+class CTextureBatch {
+private:
+	struct TJob {
+		TTexture* tex;
+		string path;
+		bool mipmap;
+		bool repeatable;
+		bool compressed;
+		bool ok;
+		CImage image;
+		TETC1Image etc;
+	};
+	vector<TJob*> jobs;
+	CJobGroup group;
+
+	static void Decode (void *arg);
+public:
+	~CTextureBatch ();
+	void Add (TTexture* tex, const string& path, bool mipmap, bool repeatable);
+	void Add (TTexture* tex, const string& dir, const string& filename, bool mipmap, bool repeatable);
+	size_t Finish ();
+};
+
+// Small GUI and HUD textures (flagged [atlas] 1 in textures.lst) are packed
+// into a few pages, so a menu can be drawn with a handful of binds
+class CTextureAtlas {
+private:
+	struct TEntry {
+		TTexture* tex;
+		string path;
+		bool ok;
+		CImage image;
+		int x, y;	// position on the page
+	};
+	vector<TEntry*> entries;
+	vector<GLuint> pages;
+	CJobGroup group;
+
+	static void Decode (void *arg);
+	static bool CompareHeight (const TEntry* a, const TEntry* b);
+	size_t Pack (const vector<TEntry*>& list, int pagew, int maxh, int *usedh) const;
+	void BuildPage (vector<TEntry*>& list, int maxsize);
+public:
+	~CTextureAtlas ();
+	void Add (TTexture* tex, const string& dir, const string& filename);
+	void Finish ();
+	void Free ();
 };
 
 class CTexture {
 private:
 	vector<TTexture*> CommonTex;
 	map<string, TTexture*> Index;
+	CTextureAtlas Atlas;
 	Orientation forientation;
 
-	void DrawNumChr (char c, int x, int y, int w, int h, const TColor& col);
+	void DrawNumChr (const TTexture* tex, char c, int x, int y, int w, int h, const TColor& col);
 public:
 	CTexture ();
 	~CTexture ();
@@ -152,7 +246,43 @@ public:
 
 extern CTexture Tex;
 
-void ScreenshotN ();
+// --------------------------------------------------------------------
+//				class CTextureCache
+// --------------------------------------------------------------------
 
+// Keeps the uploaded textures in LRU order and evicts the least recently
+// used ones that can be reloaded from their file when the total size
+// exceeds the budget (param.texture_budget). Textures bound in the current
+// frame are never evicted, so a frame can go over the budget; the rest
+// is evicted when the next frame starts.
+class CTextureCache {
+private:
+	TTexture *first;	// most recently used
+	TTexture *last;
+	size_t bytes;
+	size_t budget;
+	unsigned int frame;
+
+	void Unlink (TTexture *tex);
+	void LinkFront (TTexture *tex);
+public:
+	CTextureCache ();
+	void SetBudget (size_t bytes);	// 0 = unlimited
+	void Add (TTexture *tex, size_t texbytes);
+	void Remove (TTexture *tex);
+	void Touch (TTexture *tex);
+	void Trim ();
+	void NewFrame () { frame++; Trim (); }	// what the last frame needed can go now
+
+	size_t Bytes () const { return bytes; }
+	size_t Budget () const { return budget; }
+};
+
+extern CTextureCache TexCache;
+
+// ScreenshotN only requests a screenshot, CaptureScreenshot reads the
+// back buffer before the next swap and a worker writes the file
+void ScreenshotN ();
+void CaptureScreenshot ();
 
 #endif
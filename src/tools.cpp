@@ -149,7 +149,7 @@ static const TLight toollight = {
 static int tool_mode = 0;
 
 void DrawQuad (float x, float y, float w, float h, float scrheight, const TColor& col, int frame) {
-	glDisable (GL_TEXTURE_2D);
+	GLDisable (GL_TEXTURE_2D);
 	glColor(col);
 	const GLfloat vtx[] = {
 		x - frame, scrheight - y - h - frame,
@@ -163,7 +163,7 @@ void DrawQuad (float x, float y, float w, float h, float scrheight, const TColor
 	glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 
 	glDisableClientState(GL_VERTEX_ARRAY);
-	glEnable (GL_TEXTURE_2D);
+	GLEnable (GL_TEXTURE_2D);
 }
 
 void DrawChanged () {
@@ -174,7 +174,7 @@ void DrawChanged () {
 
 void SetToolLight () {
 	toollight.Enable(GL_LIGHT0);
-	glEnable(GL_LIGHTING);
+	GLEnable(GL_LIGHTING);
 }
 
 void QuitTool () {
@@ -24,6 +24,7 @@ GNU General Public License for more details.
 #include "textures.h"
 #include "course.h"
 #include "physics.h"
+#include "render_queue.h"
 #include <list>
 
 #define TRACK_WIDTH  0.7
@@ -177,6 +178,18 @@ void DrawTrackmarks() {
 	}
 }
 
+static void DrawTrackmarkItem (const TRenderItem *items, size_t count) {
+	DrawTrackmarks ();
+}
+
+void SubmitTrackmarks() {
+	if (param.perf_level < 3)
+		return;
+	// right after the course (TRACK_MARKS sorts after COURSE), so Tux's
+	// shadow is drawn over the marks and not under them
+	RenderQueue.Submit (RL_TERRAIN, TRACK_MARKS, NULL, DrawTrackmarkItem);
+}
+
 void break_track_marks() {
 	list<track_quad_t>::iterator q = track_marks.current_mark;
 	if (q != track_marks.quads.end()) {
@@ -30,5 +30,6 @@ void break_track_marks();
 void SetTrackIDs(int id1, int id2, int id3);
 void UpdateTrackmarks(const CControl *ctrl);
 void DrawTrackmarks();
+void SubmitTrackmarks();
 
 #endif
@@ -30,6 +30,7 @@ still shaped with spheres.
 #include "textures.h"
 #include "course.h"
 #include "physics.h"
+#include "render_queue.h"
 //#include <GL/glu.h>
 #include <algorithm>
 
@@ -433,9 +434,9 @@ void CCharShape::DrawNodes (const TCharNode *node) {
 void CCharShape::Draw () {
 	static const float dummy_color[] = {0.0, 0.0, 0.0, 1.0};
 
-	glMaterialfv (GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE, dummy_color);
+	GLMaterial (GL_AMBIENT_AND_DIFFUSE, dummy_color);
 	ScopedRenderMode rm(TUX);
-	glEnable (GL_NORMALIZE);
+	GLEnable (GL_NORMALIZE);
 
 	TCharNode *node = GetNode(0);
 	if (node == NULL) return;
@@ -447,11 +448,21 @@ void CCharShape::Draw () {
 	DrawNodes (node);
 	glDisableClientState(GL_VERTEX_ARRAY);
 	glDisableClientState(GL_NORMAL_ARRAY);
-	glDisable (GL_NORMALIZE);
-	if (param.perf_level > 2 && g_game.argument == 0) DrawShadow ();
+	GLDisable (GL_NORMALIZE);
+	// in the game and in --render (5), not in the tools or the GL test
+	if (param.perf_level > 2 && (g_game.argument == 0 || g_game.argument == 5)) DrawShadow ();
 	highlighted = false;
 }
 
+static void DrawShapeItem (const TRenderItem *items, size_t count) {
+	for (size_t i=0; i<count; i++)
+		const_cast<CCharShape*>(static_cast<const CCharShape*>(items[i].data))->Draw ();
+}
+
+void CCharShape::Submit () {
+	RenderQueue.Submit (RL_OPAQUE, TUX, NULL, DrawShapeItem, this);
+}
+
 // --------------------------------------------------------------------
 
 bool CCharShape::Load (const string& dir, const string& filename, bool with_actions) {
@@ -808,7 +819,14 @@ void CCharShape::DrawShadow () {
 		Message ("couldn't find tux's root node");
 		return;
 	}
+	// the spheres are transformed here, so all of them are one draw
+#ifdef USE_GLES1
+	glesBeginBatch();
 	TraverseDagForShadow(node, TMatrix<4, 4>::getIdentity());
+	glesEndBatch();
+#else
+	TraverseDagForShadow(node, TMatrix<4, 4>::getIdentity());
+#endif
 }
 
 // --------------------------------------------------------------------
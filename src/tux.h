@@ -132,6 +132,7 @@ public:
 	// global functions
 	void Reset ();
 	void Draw ();
+	void Submit ();		// Draw from the render queue
 	void DrawShadow ();
 	bool Load (const string& dir, const string& filename, bool with_actions);
 
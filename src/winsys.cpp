@@ -28,8 +28,16 @@ GNU General Public License for more details.
 #include "textures.h"
 #include "spx.h"
 #include "course.h"
+#include "workers.h"
 #include <SDL2/SDL_syswm.h>
+#include <SDL2/SDL_image.h>
 #include <iostream>
+#include <fstream>
+#ifdef USE_HEADLESS
+#define EGL_NO_X11
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
 #define USE_JOYSTICK true
 
@@ -37,10 +45,22 @@ TVector2i cursor_pos(0, 0);
 
 CWinsys Winsys;
 
+#ifdef USE_HEADLESS
+// no window: the game renders into a pbuffer of a surfaceless EGL display
+// (Mesa's llvmpipe on a plain Linux box), see DumpFrame
+static EGLDisplay egl_display = EGL_NO_DISPLAY;
+static EGLSurface egl_surface = EGL_NO_SURFACE;
+static EGLContext egl_context = EGL_NO_CONTEXT;
+#endif
+
 CWinsys::CWinsys ()
 	: auto_resolution(800, 600)
 {
+#ifndef USE_HEADLESS
 	window = NULL;
+#endif
+	frames = 0;
+	dump_frame = 0;
 
 	orient = 0;
 
@@ -60,6 +80,37 @@ CWinsys::CWinsys ()
 	resolutions[9] = TScreenRes(1680, 1050);
 }
 
+void CWinsys::SwapBuffers () {
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
+	glClear(GL_COLOR_BUFFER_BIT);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	// the back buffer is undefined after the swap on GLES
+	CaptureScreenshot();
+	frames++;
+	GLStatsEndFrame ();
+	if (!dump_path.empty() && frames == dump_frame) {
+		CImage image;
+		image.ReadFrameBuffer ();
+		image.ConvertPixels (3, false, true);
+		if (!image.WritePNG (dump_path.c_str()))
+			Message ("could not write", dump_path);
+		// the GL work of the frame next to it, for comparing runs
+		ofstream stats ((dump_path + ".stats").c_str());
+		stats << GLStatsReport ();
+		Terminate ();
+	}
+#ifdef USE_HEADLESS
+	eglSwapBuffers (egl_display, egl_surface);
+#else
+	SDL_GL_SwapWindow(window);
+#endif
+}
+
+void CWinsys::DumpFrame (size_t frame, const string& path) {
+	dump_frame = frame;
+	dump_path = path;
+}
+
 void CWinsys::SetOrient(int o) {
 	if ((o & ORIENT_ROTATE) != (orient & ORIENT_ROTATE))
 		resolution = TScreenRes(resolution.height, resolution.width);
@@ -85,6 +136,78 @@ ETR_DOUBLE CWinsys::CalcScreenScale () const {
 	else return (resolution.height / 768);
 }
 
+#ifdef USE_HEADLESS
+void CWinsys::SetupVideoMode (const TScreenRes& resolution_) {
+	resolution = resolution_;
+	if (resolution.width == 0 || resolution.height == 0)
+		resolution = auto_resolution;
+
+	if (egl_display == EGL_NO_DISPLAY) {
+		PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC) eglGetProcAddress ("eglGetPlatformDisplayEXT");
+		if (get_platform_display != NULL)
+			egl_display = get_platform_display (EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+		if (egl_display == EGL_NO_DISPLAY)
+			egl_display = eglGetDisplay (EGL_DEFAULT_DISPLAY);
+		if (!eglInitialize (egl_display, NULL, NULL))
+			Message ("could not initialize EGL");
+		eglBindAPI (EGL_OPENGL_ES_API);
+	}
+
+	const EGLint config_attribs[] = {
+#ifdef USE_GLES2
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+#else
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_ES_BIT,
+#endif
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+#if defined (USE_STENCIL_BUFFER)
+		EGL_STENCIL_SIZE, 8,
+#endif
+		EGL_NONE
+	};
+	EGLConfig config;
+	EGLint numconfigs = 0;
+	if (!eglChooseConfig (egl_display, config_attribs, &config, 1, &numconfigs) || numconfigs == 0) {
+		Message ("no EGL config for offscreen rendering");
+		return;
+	}
+
+	if (egl_surface != EGL_NO_SURFACE) eglDestroySurface (egl_display, egl_surface);
+	const EGLint surface_attribs[] = {
+		EGL_WIDTH, resolution.width,
+		EGL_HEIGHT, resolution.height,
+		EGL_NONE
+	};
+	egl_surface = eglCreatePbufferSurface (egl_display, config, surface_attribs);
+	if (egl_surface == EGL_NO_SURFACE)
+		Message ("could not create the offscreen surface");
+
+	if (egl_context == EGL_NO_CONTEXT) {
+		const EGLint context_attribs[] = {
+#ifdef USE_GLES2
+			EGL_CONTEXT_CLIENT_VERSION, 2,
+#else
+			EGL_CONTEXT_CLIENT_VERSION, 1,
+#endif
+			EGL_NONE
+		};
+		egl_context = eglCreateContext (egl_display, config, EGL_NO_CONTEXT, context_attribs);
+		if (egl_context == EGL_NO_CONTEXT)
+			Message ("could not create the EGL context");
+	}
+	eglMakeCurrent (egl_display, egl_surface, egl_surface, egl_context);
+
+	scale = CalcScreenScale ();
+	if (param.use_quad_scale) scale = sqrt (scale);
+	FT.ClearLayoutCache ();
+}
+#else
 void CWinsys::SetupVideoMode (const TScreenRes& resolution_) {
 	Uint32 window_flags = SDL_WINDOW_OPENGL | SDL_WINDOW_FULLSCREEN_DESKTOP;
 
@@ -107,7 +230,9 @@ void CWinsys::SetupVideoMode (const TScreenRes& resolution_) {
 
 	scale = CalcScreenScale ();
 	if (param.use_quad_scale) scale = sqrt (scale);
+	FT.ClearLayoutCache ();
 }
+#endif
 
 void CWinsys::SetupVideoMode (size_t idx) {
 	SetupVideoMode (GetResolution(idx));
@@ -137,12 +262,21 @@ void CWinsys::InitJoystick () {
 }
 
 void CWinsys::Init () {
+#ifdef USE_HEADLESS
+	Uint32 sdl_flags = SDL_INIT_NOPARACHUTE | SDL_INIT_TIMER;
+#else
 	Uint32 sdl_flags = SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE | SDL_INIT_TIMER;
+#endif
 	if (SDL_Init (sdl_flags) < 0) Message ("Could not initialize SDL");
 
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_EGL, 1);
+#ifdef USE_GLES2
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 2);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
+#else
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 1); 
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1); 
+#endif
 
 	SDL_GL_SetAttribute (SDL_GL_DOUBLEBUFFER, 1);
 #if defined (USE_STENCIL_BUFFER)
@@ -159,13 +293,19 @@ void CWinsys::Init () {
 	SDL_GL_SetAttribute(SDL_GL_DEPTH_SIZE, 24);
 
 	SetupVideoMode (GetResolution (param.res_type));
+#ifndef USE_HEADLESS
 	context = SDL_GL_CreateContext(window);
+#endif
 	SetOrient(param.orient >= 0 ? param.orient : resolution.width < resolution.height);
 	Reshape (resolution.width, resolution.height);
 
 	//SDL_WM_SetCaption (WINDOW_TITLE, WINDOW_TITLE);
 	KeyRepeat (false);
 	if (USE_JOYSTICK) InitJoystick ();
+
+	// the png loader must be initialized before images are decoded in parallel
+	IMG_Init (IMG_INIT_PNG);
+	Workers.Start ();
 //	SDL_EnableUNICODE (1);
 }
 
@@ -188,12 +328,18 @@ void CWinsys::CloseJoystick () {
 }
 
 void CWinsys::Quit () {
+	Workers.Stop ();
 	CloseJoystick ();
 	Score.SaveHighScore ();
 	SaveMessages ();
 	Audio.Close ();		// frees music and sound as well
 	FT.Clear ();
 	if (g_game.argument < 1) Players.SavePlayers ();
+	IMG_Quit ();
+#ifdef USE_HEADLESS
+	eglMakeCurrent (egl_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	eglTerminate (egl_display);
+#endif
 	SDL_Quit ();
 }
 
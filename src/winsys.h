@@ -42,9 +42,16 @@ private:
 	// sdl window
 	TScreenRes resolutions[NUM_RESOLUTIONS];
 	TScreenRes auto_resolution;
+#ifndef USE_HEADLESS
 	SDL_Window *window;
 	SDL_GLContext context;
+#endif
 	ETR_DOUBLE CalcScreenScale () const;
+
+	// frame dump, see DumpFrame
+	size_t frames;
+	size_t dump_frame;
+	string dump_path;
 public:
 	TScreenRes resolution;
 	ETR_DOUBLE scale;			// scale factor for screen, see 'use_quad_scale'
@@ -63,12 +70,10 @@ public:
 	void SetFonttype ();
 	void PrintJoystickInfo () const;
 	void ShowCursor (bool /*visible*/) {SDL_ShowCursor (false);}
-	void SwapBuffers () {
-		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
-		glClear(GL_COLOR_BUFFER_BIT);
-		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
-		SDL_GL_SwapWindow(window);
-	}
+	void SwapBuffers ();
+	// writes the given frame (counted from the start) as png, its GL
+	// statistics to <path>.stats and quits
+	void DumpFrame (size_t frame, const string& path);
 	void SetOrient(int o);
 	void Quit ();
 	void Terminate ();
@@ -0,0 +1,250 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifdef HAVE_CONFIG_H
+#include <etr_config.h>
+#endif
+
+#include "workers.h"
+
+CWorkerPool Workers;
+
+CWorkerPool::CWorkerPool () {
+	mutex = NULL;
+	job_available = NULL;
+	quit = false;
+}
+
+CWorkerPool::~CWorkerPool () {
+	Stop ();
+}
+
+int CWorkerPool::ThreadFunc (void *data) {
+	CWorkerPool *pool = static_cast<CWorkerPool*>(data);
+
+	SDL_LockMutex (pool->mutex);
+	for (;;) {
+		while (pool->jobs.empty() && !pool->quit)
+			SDL_CondWait (pool->job_available, pool->mutex);
+		if (pool->jobs.empty()) break;	// quit and nothing left to do
+
+		TJob job = pool->jobs.front();
+		pool->jobs.pop_front();
+		SDL_UnlockMutex (pool->mutex);
+
+		job.func (job.arg);
+
+		SDL_LockMutex (pool->mutex);
+		pool->JobDone (job);
+	}
+	SDL_UnlockMutex (pool->mutex);
+	return 0;
+}
+
+void CWorkerPool::Start (size_t numthreads) {
+	if (!threads.empty()) return;
+	if (numthreads == 0) {
+		int cpus = SDL_GetCPUCount ();
+		// the main thread keeps a core for GL uploads
+		numthreads = cpus > 1 ? cpus - 1 : 0;
+	}
+	if (numthreads == 0) return;
+
+	mutex = SDL_CreateMutex ();
+	job_available = SDL_CreateCond ();
+	quit = false;
+
+	for (size_t i=0; i<numthreads; i++) {
+		SDL_Thread *thread = SDL_CreateThread (ThreadFunc, "etr_worker", this);
+		if (thread == NULL) {
+			Message ("could not create worker thread", SDL_GetError());
+			break;
+		}
+		threads.push_back (thread);
+	}
+}
+
+void CWorkerPool::Stop () {
+	if (mutex == NULL) return;
+
+	SDL_LockMutex (mutex);
+	quit = true;
+	SDL_CondBroadcast (job_available);
+	SDL_UnlockMutex (mutex);
+
+	for (size_t i=0; i<threads.size(); i++)
+		SDL_WaitThread (threads[i], NULL);
+	threads.clear();
+
+	SDL_DestroyCond (job_available);
+	SDL_DestroyMutex (mutex);
+	job_available = NULL;
+	mutex = NULL;
+}
+
+// with the mutex locked
+void CWorkerPool::JobDone (const TJob& job) {
+	if (job.group != NULL && --job.group->pending == 0)
+		SDL_CondBroadcast (job.group->done);
+}
+
+void CWorkerPool::Push (TJobFunc func, void *arg, CJobGroup *group) {
+	if (threads.empty()) {
+		func (arg);
+		return;
+	}
+	SDL_LockMutex (mutex);
+	if (group != NULL) {
+		if (group->done == NULL) group->done = SDL_CreateCond ();
+		group->pending++;
+	}
+	jobs.push_back (TJob(func, arg, group));
+	SDL_CondSignal (job_available);
+	SDL_UnlockMutex (mutex);
+}
+
+void CWorkerPool::Wait (CJobGroup *group) {
+	if (mutex == NULL) return;
+	SDL_LockMutex (mutex);
+	while (group->pending > 0) {
+		deque<TJob>::iterator it = jobs.begin();
+		while (it != jobs.end() && it->group != group) ++it;
+		if (it == jobs.end()) {
+			// the rest is running on the threads
+			SDL_CondWait (group->done, mutex);
+			continue;
+		}
+		TJob job = *it;
+		jobs.erase (it);
+		SDL_UnlockMutex (mutex);
+		job.func (job.arg);
+		SDL_LockMutex (mutex);
+		JobDone (job);
+	}
+	SDL_UnlockMutex (mutex);
+}
+
+// --------------------------------------------------------------------
+//				class CJobGroup
+// --------------------------------------------------------------------
+
+CJobGroup::~CJobGroup () {
+	Wait ();
+	if (done != NULL) SDL_DestroyCond (done);
+}
+
+void CJobGroup::Push (TJobFunc func, void *arg) {
+	Workers.Push (func, arg, this);
+}
+
+// pending is only read under the pool's mutex: a worker may still be
+// in JobDone, broadcasting done, when it drops to 0
+void CJobGroup::Wait () {
+	Workers.Wait (this);
+}
+
+// --------------------------------------------------------------------
+//				class CTaskGraph
+// --------------------------------------------------------------------
+
+CTaskGraph::CTaskGraph () {
+	unfinished = 0;
+	mutex = NULL;
+	changed = NULL;
+}
+
+size_t CTaskGraph::Add (TTaskFunc func, bool mainthread) {
+	tasks.push_back (TTask());
+	tasks.back().graph = this;
+	tasks.back().func = func;
+	tasks.back().mainthread = mainthread;
+	tasks.back().waiting = 0;
+	return tasks.size()-1;
+}
+
+void CTaskGraph::Depends (size_t task, size_t on) {
+	if (task >= tasks.size() || on >= tasks.size()) return;
+	tasks[on].dependents.push_back (task);
+	tasks[task].waiting++;
+}
+
+void CTaskGraph::RunJob (void *arg) {
+	TTask *task = static_cast<TTask*>(arg);
+	task->func ();
+	task->graph->Finished (task - &task->graph->tasks[0]);
+}
+
+// must be called without the mutex, without threads Push runs the job
+// at once and it finishes on this thread
+void CTaskGraph::Start (size_t idx) {
+	if (tasks[idx].mainthread) {
+		SDL_LockMutex (mutex);
+		ready_main.push_back (idx);
+		SDL_CondSignal (changed);
+		SDL_UnlockMutex (mutex);
+	} else {
+		Workers.Push (RunJob, &tasks[idx]);
+	}
+}
+
+void CTaskGraph::Finished (size_t idx) {
+	vector<size_t> ready;
+	SDL_LockMutex (mutex);
+	const vector<size_t>& dependents = tasks[idx].dependents;
+	for (size_t i=0; i<dependents.size(); i++)
+		if (--tasks[dependents[i]].waiting == 0)
+			ready.push_back (dependents[i]);
+	unfinished--;
+	SDL_CondSignal (changed);
+	SDL_UnlockMutex (mutex);
+
+	for (size_t i=0; i<ready.size(); i++)
+		Start (ready[i]);
+}
+
+void CTaskGraph::Run () {
+	if (tasks.empty()) return;
+	mutex = SDL_CreateMutex ();
+	changed = SDL_CreateCond ();
+	unfinished = tasks.size();
+
+	vector<size_t> ready;
+	for (size_t i=0; i<tasks.size(); i++)
+		if (tasks[i].waiting == 0) ready.push_back (i);
+	for (size_t i=0; i<ready.size(); i++)
+		Start (ready[i]);
+
+	SDL_LockMutex (mutex);
+	while (unfinished > 0) {
+		if (ready_main.empty()) {
+			SDL_CondWait (changed, mutex);
+			continue;
+		}
+		size_t idx = ready_main.front();
+		ready_main.pop_front();
+		SDL_UnlockMutex (mutex);
+		tasks[idx].func ();
+		Finished (idx);
+		SDL_LockMutex (mutex);
+	}
+	SDL_UnlockMutex (mutex);
+
+	SDL_DestroyCond (changed);
+	SDL_DestroyMutex (mutex);
+	changed = NULL;
+	mutex = NULL;
+	tasks.clear();
+}
@@ -0,0 +1,121 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef WORKERS_H
+#define WORKERS_H
+
+#include "bh.h"
+#include <SDL2/SDL.h>
+#include <deque>
+#include <vector>
+
+// --------------------------------------------------------------------
+//				class CWorkerPool
+// --------------------------------------------------------------------
+
+// A small pool of SDL threads for CPU-only work (decoding, encoding,
+// parsing). Jobs must never touch GL or the SDL mixer - results are
+// handed back to the main thread, which does the uploads.
+
+typedef void (*TJobFunc) (void *arg);
+
+class CJobGroup;
+
+class CWorkerPool {
+private:
+	struct TJob {
+		TJobFunc func;
+		void *arg;
+		CJobGroup *group;
+		TJob (TJobFunc f, void *a, CJobGroup *g) : func(f), arg(a), group(g) {}
+	};
+	deque<TJob> jobs;
+	vector<SDL_Thread*> threads;
+	SDL_mutex *mutex;
+	SDL_cond *job_available;
+	bool quit;
+
+	static int ThreadFunc (void *data);
+	void JobDone (const TJob& job);
+public:
+	CWorkerPool ();
+	~CWorkerPool ();
+
+	void Start (size_t numthreads = 0);	// 0: one thread per cpu
+	void Stop ();
+	size_t NumThreads () const { return threads.size(); }
+
+	// without threads the job runs at once on the calling thread
+	void Push (TJobFunc func, void *arg, CJobGroup *group = NULL);
+	void Wait (CJobGroup *group);
+};
+
+// Jobs that are waited for together, e.g. the textures of a batch. Wait
+// only waits for the jobs of the group, not for unrelated work in the
+// pool. The group's jobs that no thread has started yet are run by the
+// waiting thread, so a group can be waited for inside a job as well.
+class CJobGroup {
+	friend class CWorkerPool;
+private:
+	size_t pending;			// pushed and not finished
+	SDL_cond *done;
+public:
+	CJobGroup () : pending(0), done(NULL) {}
+	~CJobGroup ();			// waits for the jobs
+
+	void Push (TJobFunc func, void *arg);
+	void Wait ();
+};
+
+extern CWorkerPool Workers;
+
+// --------------------------------------------------------------------
+//				class CTaskGraph
+// --------------------------------------------------------------------
+
+// Runs a set of tasks in the order given by their dependencies. A task
+// is pushed to the worker pool as soon as the tasks it depends on are
+// done; tasks added with mainthread (everything that touches GL) run on
+// the thread that called Run().
+
+typedef void (*TTaskFunc) ();
+
+class CTaskGraph {
+private:
+	struct TTask {
+		CTaskGraph *graph;
+		TTaskFunc func;
+		bool mainthread;
+		size_t waiting;		// unfinished dependencies
+		vector<size_t> dependents;
+	};
+	vector<TTask> tasks;
+	deque<size_t> ready_main;
+	size_t unfinished;
+	SDL_mutex *mutex;
+	SDL_cond *changed;
+
+	static void RunJob (void *arg);
+	void Start (size_t idx);
+	void Finished (size_t idx);
+public:
+	CTaskGraph ();
+	size_t Add (TTaskFunc func, bool mainthread = false);
+	void Depends (size_t task, size_t on);	// task runs after on
+	void Run ();	// returns when all tasks are done
+};
+
+#endif
@@ -0,0 +1,166 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the glPushAttrib/glPopAttrib emulation in opengles.cpp against
+// the mock GL (mockgl.h). Every attribute group of desktop GL is pushed,
+// the state is changed at random and popped again; the flags must come
+// back, and the blend function too when GL_COLOR_BUFFER_BIT was given.
+// Then the stack is filled beyond its depth and emptied.
+//
+//   attribtest [rounds]
+//
+// Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include <cstdio>
+#include <cstdlib>
+
+// the attribute groups of desktop GL, GLES 1 only has some of the names
+static const struct {
+	int bit;
+	const char *name;
+} groups[] = {
+	{ 0x00000001, "GL_CURRENT_BIT" },
+	{ 0x00000002, "GL_POINT_BIT" },
+	{ 0x00000004, "GL_LINE_BIT" },
+	{ 0x00000008, "GL_POLYGON_BIT" },
+	{ 0x00000010, "GL_POLYGON_STIPPLE_BIT" },
+	{ 0x00000020, "GL_PIXEL_MODE_BIT" },
+	{ 0x00000040, "GL_LIGHTING_BIT" },
+	{ 0x00000080, "GL_FOG_BIT" },
+	{ 0x00000100, "GL_DEPTH_BUFFER_BIT" },
+	{ 0x00000200, "GL_ACCUM_BUFFER_BIT" },
+	{ 0x00000400, "GL_STENCIL_BUFFER_BIT" },
+	{ 0x00000800, "GL_VIEWPORT_BIT" },
+	{ 0x00001000, "GL_TRANSFORM_BIT" },
+	{ 0x00002000, "GL_ENABLE_BIT" },
+	{ 0x00004000, "GL_COLOR_BUFFER_BIT" },
+	{ 0x00008000, "GL_HINT_BIT" },
+	{ 0x00010000, "GL_EVAL_BIT" },
+	{ 0x00020000, "GL_LIST_BIT" },
+	{ 0x00040000, "GL_TEXTURE_BIT" },
+	{ 0x00080000, "GL_SCISSOR_BIT" },
+	{ 0x000fffff, "GL_ALL_ATTRIB_BITS" },
+	{ 0x00002000 | 0x00004000, "GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT" },
+	{ 0x00002000 | 0x00000020 | 0x00004000, "GL_ENABLE_BIT | GL_PIXEL_MODE_BIT | GL_COLOR_BUFFER_BIT" },
+};
+#define NUM_GROUPS (sizeof(groups) / sizeof(groups[0]))
+#define STACK_DEPTH 16		// ATTRIB_STACK_DEPTH in opengles.cpp
+
+// the flags that the emulation saves
+static const GLenum flags[] = {
+	GL_ALPHA_TEST, GL_BLEND, GL_CULL_FACE, GL_DEPTH_TEST, GL_LINE_SMOOTH,
+	GL_MULTISAMPLE, GL_POLYGON_OFFSET_FILL, GL_TEXTURE_2D, GL_LIGHTING,
+	GL_LIGHT0, GL_LIGHT1, GL_LIGHT2, GL_LIGHT3,
+	GL_LIGHT4, GL_LIGHT5, GL_LIGHT6, GL_LIGHT7,
+	GL_FOG, GL_NORMALIZE, GL_STENCIL_TEST, GL_COLOR_MATERIAL
+};
+#define NUM_FLAGS (sizeof(flags) / sizeof(flags[0]))
+
+static const GLenum blend_factors[] = {
+	GL_ONE, GL_ZERO, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_DST_COLOR
+};
+#define NUM_FACTORS (sizeof(blend_factors) / sizeof(blend_factors[0]))
+
+static int num_failed = 0;
+
+static void Check (const string& diff, const string& what) {
+	if (!diff.empty()) {
+		printf ("FAILED   %s: %s\n", what.c_str(), diff.c_str());
+		num_failed++;
+	}
+}
+
+static void RandomChanges () {
+	for (size_t i=0; i<NUM_FLAGS; i++) {
+		if (rand () % 2) GLEnable (flags[i]);
+		else GLDisable (flags[i]);
+	}
+	GLBlendFunc (blend_factors[rand () % NUM_FACTORS], blend_factors[rand () % NUM_FACTORS]);
+}
+
+static void EveryGroup (int rounds) {
+	for (size_t g=0; g<NUM_GROUPS; g++) {
+		for (int r=0; r<rounds; r++) {
+			RandomChanges ();
+			TMockState before = mockgl;
+			glPushAttrib (groups[g].bit);
+			RandomChanges ();
+			TMockState changed = mockgl;
+			glPopAttrib ();
+
+			TMockState expected = before;
+			if (!(groups[g].bit & GL_COLOR_BUFFER_BIT)) {
+				expected.blend_src = changed.blend_src;
+				expected.blend_dst = changed.blend_dst;
+			}
+			Check (mockgl.Compare (expected), groups[g].name);
+		}
+	}
+	printf ("%u attribute groups pushed and popped %d times\n", (unsigned)NUM_GROUPS, rounds);
+}
+
+// pushes beyond the depth are ignored, and so are their pops
+static void FullStack () {
+	const int depth = STACK_DEPTH + 4;
+	vector<TMockState> saved;
+	for (int i=0; i<depth; i++) {
+		RandomChanges ();
+		saved.push_back (mockgl);
+		glPushAttrib (GL_COLOR_BUFFER_BIT);
+	}
+	RandomChanges ();
+	for (int i=depth-1; i>=0; i--) {
+		TMockState before = mockgl;
+		glPopAttrib ();
+		char what[40];
+		sprintf (what, "pop to depth %d", i);
+		Check (mockgl.Compare (i < STACK_DEPTH ? saved[i] : before), what);
+	}
+
+	// and a pop on the empty stack does nothing
+	TMockState before = mockgl;
+	glPopAttrib ();
+	Check (mockgl.Compare (before), "pop on the empty stack");
+	printf ("stack filled to %d and emptied\n", depth);
+}
+
+int main (int argc, char **argv) {
+	int rounds = argc > 1 ? atoi (argv[1]) : 100;
+	MockReset ();
+	InvalidateGLState ();
+	srand (1);
+
+	EveryGroup (rounds);
+	FullStack ();
+
+	// the flags come from the shadow, not from the driver
+	unsigned int queries = MockCalls ("glIsEnabled") + MockCalls ("glGetIntegerv");
+	glPushAttrib (GL_COLOR_BUFFER_BIT);
+	glPopAttrib ();
+	if (MockCalls ("glIsEnabled") + MockCalls ("glGetIntegerv") != queries) {
+		printf ("FAILED   glPushAttrib asked the driver\n");
+		num_failed++;
+	}
+
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
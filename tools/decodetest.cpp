@@ -0,0 +1,138 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the texture decoding on the worker pool (CTextureBatch) against
+// the direct path (TTexture::Load) with the mock GL (mockgl.h). Every png
+// below the data directory is loaded both ways, every other one with
+// mipmaps; the uploaded pixels must be the same.
+//
+//   decodetest [datadir] [threads]
+//
+// Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include "textures.h"
+#include "workers.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+
+#define BATCH_SIZE 32
+
+static int num_failed = 0;
+
+static void FindImages (const string& dir, vector<string>& images) {
+	DIR *xdir = opendir (dir.c_str());
+	if (xdir == NULL) return;
+	vector<string> entries;
+	struct dirent *entry;
+	while ((entry = readdir (xdir)) != NULL) {
+		if (entry->d_name[0] != '.') entries.push_back (entry->d_name);
+	}
+	closedir (xdir);
+
+	for (size_t i=0; i<entries.size(); i++) {
+		string path = dir + "/" + entries[i];
+		struct stat info;
+		if (stat (path.c_str(), &info) != 0) continue;
+		if (S_ISDIR (info.st_mode))
+			FindImages (path, images);
+		else if (path.size() > 4 && path.compare (path.size() - 4, 4, ".png") == 0)
+			images.push_back (path);
+	}
+}
+
+// the GL texture behind tex, NULL if nothing was uploaded
+static const TMockTexture *Uploaded (TTexture& tex) {
+	tex.Bind ();
+	map<GLuint, TMockTexture>::const_iterator it = mock_textures.find (mockgl.texture);
+	if (mockgl.texture == 0 || it == mock_textures.end() || it->second.uploads == 0)
+		return NULL;
+	return &it->second;
+}
+
+static void Compare (const string& path, TTexture& batch, TTexture& direct) {
+	const TMockTexture *a = Uploaded (batch);
+	const TMockTexture *b = Uploaded (direct);
+	const char *diff = NULL;
+	if (a == NULL || b == NULL) {
+		if (a != b) diff = "loaded by one path only";
+	} else if (a->width != b->width || a->height != b->height || a->format != b->format) {
+		diff = "size or format";
+	} else if (a->data != b->data) {
+		diff = "pixels";
+	} else if (batch.width != direct.width || batch.height != direct.height) {
+		diff = "image size";
+	}
+	if (diff != NULL) {
+		printf ("FAILED   %s: %s\n", path.c_str(), diff);
+		num_failed++;
+	}
+}
+
+static void CompareBatch (const vector<string>& images, size_t first, size_t count) {
+	vector<TTexture*> batched, direct;
+	CTextureBatch batch;
+	for (size_t i=first; i<first+count; i++) {
+		batched.push_back (new TTexture);
+		batch.Add (batched.back(), images[i], i % 2 == 1, i % 4 == 1);
+	}
+	batch.Finish ();
+
+	for (size_t i=first; i<first+count; i++) {
+		direct.push_back (new TTexture);
+		if (i % 2 == 1) direct.back()->LoadMipmap (images[i], i % 4 == 1);
+		else direct.back()->Load (images[i]);
+	}
+
+	for (size_t i=0; i<count; i++) {
+		Compare (images[first + i], *batched[i], *direct[i]);
+		delete batched[i];
+		delete direct[i];
+	}
+}
+
+int main (int argc, char **argv) {
+	string datadir = argc > 1 ? argv[1] : "data";
+	int threads = argc > 2 ? atoi (argv[2]) : 4;
+
+	vector<string> images;
+	FindImages (datadir, images);
+	if (images.empty()) {
+		printf ("FAILED   no images in %s\n", datadir.c_str());
+		return 1;
+	}
+
+	MockReset ();
+	InvalidateGLState ();
+	Workers.Start (threads);
+	for (size_t i=0; i<images.size(); i+=BATCH_SIZE) {
+		size_t count = images.size() - i < BATCH_SIZE ? images.size() - i : BATCH_SIZE;
+		CompareBatch (images, i, count);
+	}
+	printf ("%u images decoded on %u threads and directly\n",
+		(unsigned)images.size(), (unsigned)Workers.NumThreads());
+	Workers.Stop ();
+
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
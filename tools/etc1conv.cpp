@@ -0,0 +1,227 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Offline converter: writes an ETC1 .pkm (with full mipmap chain) next to
+// every opaque, square, power-of-two .png below the given directories.
+// The game picks up the .pkm instead of the .png when it exists.
+//
+//   etc1conv [-v] [-q min_psnr] dir ...
+//
+//   -v  verify only: compare existing .pkm files with their .png sources
+//   -q  skip (or, with -v, report) images below this PSNR, default 30 dB
+
+#include "etc1.h"
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static bool verify_only = false;
+static double min_psnr = 30.0;
+static int num_converted = 0;
+static int num_skipped = 0;
+static int num_failed = 0;
+
+// the course maps are data, not textures
+static bool IsCourseMap (const string& name) {
+	return name == "terrain.png" || name == "elev.png" || name == "trees.png";
+}
+
+static bool IsPowerOfTwo (int v) {
+	return v > 0 && (v & (v - 1)) == 0;
+}
+
+// Loads the png as tightly packed rgb, flipped like CImage::LoadPng does
+// for textures. Returns false if the image can't be represented in ETC1.
+static bool LoadRGB (const string& path, vector<unsigned char>& rgb, int& size, string& reason) {
+	SDL_Surface *img = IMG_Load (path.c_str());
+	if (img == NULL) {
+		reason = "could not load";
+		return false;
+	}
+	int depth = img->format->BytesPerPixel;
+	bool ok = true;
+	if (depth != 3 && depth != 4) {
+		reason = "unsupported pixel format";
+		ok = false;
+	} else if (img->w != img->h || !IsPowerOfTwo (img->w)) {
+		reason = "not a power-of-two square";
+		ok = false;
+	}
+
+	if (ok) {
+		if (SDL_MUSTLOCK (img)) SDL_LockSurface (img);
+		size = img->w;
+		rgb.resize (size * size * 3);
+		const unsigned char *pixels = (const unsigned char*)img->pixels;
+		for (int y=0; y<size && ok; y++) {
+			const unsigned char *row = pixels + (size - 1 - y) * img->pitch;
+			for (int x=0; x<size; x++) {
+				if (depth == 4 && row[x * 4 + 3] != 255) {
+					reason = "has alpha";
+					ok = false;
+					break;
+				}
+				memcpy (&rgb[(y * size + x) * 3], row + x * depth, 3);
+			}
+		}
+		if (SDL_MUSTLOCK (img)) SDL_UnlockSurface (img);
+	}
+	SDL_FreeSurface (img);
+	return ok;
+}
+
+static double PSNR (const vector<unsigned char>& a, const vector<unsigned char>& b) {
+	double sum = 0;
+	for (size_t i=0; i<a.size(); i++) {
+		double d = (double)a[i] - b[i];
+		sum += d * d;
+	}
+	if (sum == 0) return 99.0;
+	double mse = sum / a.size();
+	return 10.0 * log10 (255.0 * 255.0 / mse);
+}
+
+static void HalveRGB (const vector<unsigned char>& src, int size, vector<unsigned char>& dest) {
+	int half = size / 2;
+	dest.resize (half * half * 3);
+	for (int y=0; y<half; y++)
+		for (int x=0; x<half; x++)
+			for (int c=0; c<3; c++) {
+				int sum = src[((2*y) * size + 2*x) * 3 + c]
+				        + src[((2*y) * size + 2*x+1) * 3 + c]
+				        + src[((2*y+1) * size + 2*x) * 3 + c]
+				        + src[((2*y+1) * size + 2*x+1) * 3 + c];
+				dest[(y * half + x) * 3 + c] = (sum + 2) / 4;
+			}
+}
+
+static void ProcessPng (const string& path) {
+	string pkmpath = path.substr (0, path.size() - 4) + ".pkm";
+	vector<unsigned char> rgb;
+	int size;
+	string reason;
+
+	if (verify_only) {
+		TETC1Image etc;
+		if (!etc.Load (pkmpath)) return;
+		if (!LoadRGB (path, rgb, size, reason) || etc.width != size || etc.height != size) {
+			printf ("MISMATCH %s\n", pkmpath.c_str());
+			num_failed++;
+			return;
+		}
+		vector<unsigned char> decoded (size * size * 3);
+		ETC1DecodeImage (&etc.levels[0][0], size, size, &decoded[0]);
+		double psnr = PSNR (rgb, decoded);
+		bool good = psnr >= min_psnr;
+		printf ("%s %6.2f dB  %s\n", good ? "ok  " : "LOW ", psnr, pkmpath.c_str());
+		if (good) num_converted++;
+		else num_failed++;
+		return;
+	}
+
+	if (!LoadRGB (path, rgb, size, reason)) {
+		printf ("skip  %s (%s)\n", path.c_str(), reason.c_str());
+		num_skipped++;
+		return;
+	}
+
+	TETC1Image etc;
+	etc.width = etc.height = size;
+	vector<unsigned char> level = rgb;
+	for (int s=size; ; s/=2) {
+		etc.levels.push_back (vector<unsigned char>(ETC1DataSize (s, s)));
+		ETC1EncodeImage (&level[0], s, s, 3, s * 3, &etc.levels.back()[0]);
+		if (s == 1) break;
+		vector<unsigned char> next;
+		HalveRGB (level, s, next);
+		level.swap (next);
+	}
+
+	vector<unsigned char> decoded (size * size * 3);
+	ETC1DecodeImage (&etc.levels[0][0], size, size, &decoded[0]);
+	double psnr = PSNR (rgb, decoded);
+	if (psnr < min_psnr) {
+		printf ("skip  %s (%.2f dB below threshold)\n", path.c_str(), psnr);
+		num_skipped++;
+		return;
+	}
+	if (!etc.Save (pkmpath)) {
+		printf ("FAIL  %s\n", pkmpath.c_str());
+		num_failed++;
+		return;
+	}
+	printf ("etc1  %s %6.2f dB\n", pkmpath.c_str(), psnr);
+	num_converted++;
+}
+
+static void ProcessDir (const string& dir) {
+	DIR *xdir = opendir (dir.c_str());
+	if (xdir == NULL) {
+		printf ("could not open %s\n", dir.c_str());
+		num_failed++;
+		return;
+	}
+	vector<string> entries;
+	struct dirent *entry;
+	while ((entry = readdir (xdir)) != NULL) {
+		if (entry->d_name[0] != '.') entries.push_back (entry->d_name);
+	}
+	closedir (xdir);
+
+	for (size_t i=0; i<entries.size(); i++) {
+		string path = dir + "/" + entries[i];
+		struct stat info;
+		if (stat (path.c_str(), &info) != 0) continue;
+		if (S_ISDIR (info.st_mode)) {
+			ProcessDir (path);
+		} else if (entries[i].size() > 4
+		           && entries[i].compare (entries[i].size() - 4, 4, ".png") == 0
+		           && !IsCourseMap (entries[i])) {
+			ProcessPng (path);
+		}
+	}
+}
+
+int main (int argc, char **argv) {
+	vector<string> dirs;
+	for (int i=1; i<argc; i++) {
+		if (strcmp (argv[i], "-v") == 0) verify_only = true;
+		else if (strcmp (argv[i], "-q") == 0 && i+1 < argc) min_psnr = atof (argv[++i]);
+		else dirs.push_back (argv[i]);
+	}
+	if (dirs.empty()) {
+		printf ("usage: %s [-v] [-q min_psnr] dir ...\n", argv[0]);
+		return 2;
+	}
+
+	IMG_Init (IMG_INIT_PNG);
+	for (size_t i=0; i<dirs.size(); i++)
+		ProcessDir (dirs[i]);
+	IMG_Quit ();
+
+	printf ("\n%d %s, %d skipped, %d failed\n", num_converted,
+		verify_only ? "verified" : "converted", num_skipped, num_failed);
+	return num_failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,128 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Benchmark of the layout cache of CFont (GetTextWidth, MakeLineList),
+// with the fonts of the game and the mock GL (mockgl.h). The UI strings
+// of every language are measured and wrapped in a few sizes, the way the
+// menus do it every frame: once with the cache, once with the cache
+// cleared before each call. Both must give the same results. The cleared
+// runs still share the word widths within one MakeLineList call, so the
+// time without the cache is rather too low than too high.
+//
+//   fontbench [datadir] [frames]
+//
+// Exits with 1 if the results differ.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include "font.h"
+#include "translation.h"
+#include "spx.h"
+#include "game_config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#define LINE_WIDTH 300
+
+static const float sizes[] = { 14, 18, 22 };
+#define NUM_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+static vector<string> texts;
+
+struct TResult {
+	float width;
+	vector<string> lines;
+};
+
+static double Seconds (clock_t start) {
+	return (double)(clock () - start) / CLOCKS_PER_SEC;
+}
+
+// the common texts of every language
+static void LoadTexts () {
+	Trans.LoadLanguages ();
+	for (size_t lang=0; lang<Trans.languages.size(); lang++) {
+		Trans.LoadTranslations (lang);
+		for (size_t i=0; i<NUM_COMMON_TEXTS; i++)
+			if (!Trans.Text (i).empty()) texts.push_back (Trans.Text (i));
+	}
+}
+
+// one frame of all the texts, cleared: without the cache
+static void Frame (bool cleared, vector<TResult>& results) {
+	results.resize (texts.size() * NUM_SIZES);
+	for (size_t s=0; s<NUM_SIZES; s++) {
+		FT.SetProps ("normal", sizes[s]);
+		for (size_t i=0; i<texts.size(); i++) {
+			TResult& r = results[s * texts.size() + i];
+			if (cleared) FT.ClearLayoutCache ();
+			r.width = FT.GetTextWidth (texts[i]);
+			if (cleared) FT.ClearLayoutCache ();
+			r.lines = FT.MakeLineList (texts[i].c_str(), LINE_WIDTH);
+		}
+	}
+}
+
+static double Run (bool cleared, int frames, vector<TResult>& results) {
+	FT.ClearLayoutCache ();
+	clock_t start = clock ();
+	for (int f=0; f<frames; f++)
+		Frame (cleared, results);
+	return Seconds (start);
+}
+
+int main (int argc, char **argv) {
+	string datadir = argc > 1 ? argv[1] : "data";
+	int frames = argc > 2 ? atoi (argv[2]) : 200;
+
+	MockReset ();
+	InvalidateGLState ();
+	param.font_dir = MakePathStr (datadir, "fonts");
+	param.trans_dir = MakePathStr (datadir, "translations");
+	if (FT.LoadFont ("normal", param.font_dir, "std.ttf", 18) < 0) {
+		printf ("FAILED   could not load the font of %s\n", param.font_dir.c_str());
+		return 1;
+	}
+	LoadTexts ();
+	printf ("%u texts in %u languages, %u sizes\n", (unsigned)texts.size(),
+		(unsigned)Trans.languages.size(), (unsigned)NUM_SIZES);
+
+	// the glyphs are rasterized on first use, not in the timed runs
+	vector<TResult> cached, uncached;
+	Frame (true, uncached);
+
+	double time_uncached = Run (true, frames, uncached);
+	double time_cached = Run (false, frames, cached);
+
+	size_t differences = 0;
+	for (size_t i=0; i<cached.size(); i++)
+		if (cached[i].width != uncached[i].width || cached[i].lines != uncached[i].lines)
+			differences++;
+	FT.Clear ();	// like Winsys.Quit, before the FreeType library goes
+
+	size_t calls = (size_t)frames * cached.size() * 2;
+	printf ("%d frames, %u calls\n", frames, (unsigned)calls);
+	printf ("without cache    %.3fs, %.2f us per call\n", time_uncached, time_uncached * 1e6 / calls);
+	printf ("with cache       %.3fs, %.2f us per call\n", time_cached, time_cached * 1e6 / calls);
+
+	if (differences > 0) {
+		printf ("FAILED   %u results differ\n", (unsigned)differences);
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,219 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the GL state shadow in ogl.cpp against the mock GL (mockgl.h).
+// A random sequence of state changes, render modes, materials and texture
+// binds is run twice: once with InvalidateGLState before every call, so
+// everything reaches GL, and once with the shadow working. After every
+// step the GL state of both runs must be the same. A few fixed cases
+// check that redundant calls are really dropped.
+//
+//   glstatetest [steps]
+//
+// Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include <cstdio>
+#include <cstdlib>
+
+static int num_failed = 0;
+
+static void Check (bool ok, const char *what) {
+	if (!ok) {
+		printf ("FAILED   %s\n", what);
+		num_failed++;
+	}
+}
+
+static const GLenum caps[] = {
+	GL_TEXTURE_2D, GL_DEPTH_TEST, GL_CULL_FACE, GL_LIGHTING, GL_NORMALIZE,
+	GL_ALPHA_TEST, GL_BLEND, GL_STENCIL_TEST, GL_COLOR_MATERIAL, GL_FOG,
+	GL_LINE_SMOOTH, GL_MULTISAMPLE, GL_LIGHT0, GL_LIGHT1,
+	GL_SCISSOR_TEST		// not in the shadow, passed through
+};
+#define NUM_CAPS (sizeof(caps) / sizeof(caps[0]))
+
+static const GLenum blend_factors[] = {
+	GL_ONE, GL_ZERO, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA
+};
+static const GLenum funcs[] = { GL_LESS, GL_LEQUAL, GL_GEQUAL, GL_ALWAYS };
+
+static const TColor colors[] = {
+	TColor (1, 1, 1, 1), TColor (0.5, 0.5, 0.5, 1), TColor (0, 0, 0, 1)
+};
+
+#define PICK(array) array[rand () % (sizeof(array) / sizeof(array[0]))]
+
+static int mode_depth = 0;
+
+// one random call of the kind the game makes
+static void RandomStep () {
+	switch (rand () % 12) {
+		case 0: GLEnable (caps[rand () % NUM_CAPS]); break;
+		case 1: GLDisable (caps[rand () % NUM_CAPS]); break;
+		case 2: GLBlendFunc (PICK (blend_factors), PICK (blend_factors)); break;
+		case 3: GLAlphaFunc (PICK (funcs), (rand () % 3) * 0.25f); break;
+		case 4: GLDepthFunc (PICK (funcs)); break;
+		case 5: GLDepthMask (rand () % 2 ? GL_TRUE : GL_FALSE); break;
+		case 6: GLShadeModel (rand () % 2 ? GL_SMOOTH : GL_FLAT); break;
+		case 7: set_material (PICK (colors), PICK (colors), (GLfloat)(rand () % 3)); break;
+		case 8: {
+			const TColor& col = PICK (colors);
+			glColor4f (col.r, col.g, col.b, col.a);
+			break;
+		}
+		case 9: BindTexture (rand () % 4); break;
+		case 10: {
+			GLuint id = rand () % 4;
+			DeleteTextures (1, &id);
+			break;
+		}
+		case 11:
+			if (mode_depth > 0 && rand () % 2) {
+				PopRenderMode ();
+				mode_depth--;
+			} else {
+				PushRenderMode ((TRenderMode)(rand () % (TRACK_MARKS + 1)));
+				mode_depth++;
+			}
+			break;
+	}
+}
+
+// the same render mode and a fresh context for both runs
+static void StartRun () {
+	while (mode_depth > 0) {
+		PopRenderMode ();
+		mode_depth--;
+	}
+	PushRenderMode (COURSE);
+	PushRenderMode (GUI);
+	MockReset ();
+	InvalidateGLState ();
+	srand (1);
+}
+
+static void EndRun () {
+	while (mode_depth > 0) {
+		PopRenderMode ();
+		mode_depth--;
+	}
+	PopRenderMode ();
+	PopRenderMode ();
+}
+
+static void RandomSequence (int steps) {
+	// what GL would have without the shadow
+	vector<TMockState> states;
+	StartRun ();
+	for (int i=0; i<steps; i++) {
+		InvalidateGLState ();
+		RandomStep ();
+		states.push_back (mockgl);
+	}
+	unsigned int calls_direct = MockCalls ();
+	EndRun ();
+
+	StartRun ();
+	int differences = 0;
+	for (int i=0; i<steps; i++) {
+		RandomStep ();
+		string diff = mockgl.Compare (states[i]);
+		if (!diff.empty() && differences++ < 10)
+			printf ("step %d: %s\n", i, diff.c_str());
+	}
+	unsigned int calls_shadow = MockCalls ();
+	EndRun ();
+	Check (differences == 0, "random sequence");
+	printf ("%d random steps: %u GL calls without the shadow, %u with it\n",
+		steps, calls_direct, calls_shadow);
+}
+
+static void RedundantCalls () {
+	MockReset ();
+	InvalidateGLState ();
+	GLEnable (GL_BLEND);
+	GLEnable (GL_BLEND);
+	GLDisable (GL_BLEND);
+	GLDisable (GL_BLEND);
+	Check (MockCalls ("glEnable") == 1 && MockCalls ("glDisable") == 1, "repeated enable");
+
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	Check (MockCalls ("glBlendFunc") == 1, "repeated blend func");
+
+	// with color material unknown the ambient/diffuse is always sent
+	GLDisable (GL_COLOR_MATERIAL);
+	set_material (colors[0], colors[1], 1);
+	unsigned int materials = MockCalls ("glMaterialfv") + MockCalls ("glMaterialf");
+	set_material (colors[0], colors[1], 1);
+	Check (MockCalls ("glMaterialfv") + MockCalls ("glMaterialf") == materials, "repeated material");
+
+	// glColor changes the material behind the shadow
+	GLEnable (GL_COLOR_MATERIAL);
+	glColor4f (0, 0, 0, 1);
+	set_material (colors[0], colors[1], 1);
+	Check (mockgl.amb_diff[0] == 1, "material after glColor");
+	GLDisable (GL_COLOR_MATERIAL);
+
+	BindTexture (0);
+	unsigned int binds = MockCalls ("glBindTexture");
+	BindTexture (3);
+	BindTexture (3);
+	Check (MockCalls ("glBindTexture") == binds + 1, "repeated bind");
+	GLuint id = 3;
+	DeleteTextures (1, &id);
+	BindTexture (3);
+	Check (MockCalls ("glBindTexture") == binds + 2 && mockgl.texture == 3, "bind after delete");
+
+	// a change behind the shadow, as by the desktop glPopAttrib
+	GLEnable (GL_FOG);
+	glDisable (GL_FOG);
+	InvalidateGLState ();
+	GLEnable (GL_FOG);
+	Check (mockgl.IsEnabled (GL_FOG), "enable after InvalidateGLState");
+
+	// a switch of the render mode only sends what differs
+	PushRenderMode (GUI);
+	PushRenderMode (COURSE);
+	InvalidateGLState ();
+	unsigned int calls = MockCalls ();
+	PushRenderMode (GUI);
+	PopRenderMode ();
+	unsigned int calls_direct = MockCalls () - calls;
+	calls = MockCalls ();
+	PushRenderMode (GUI);
+	PopRenderMode ();
+	unsigned int calls_shadow = MockCalls () - calls;
+	PopRenderMode ();
+	PopRenderMode ();
+	Check (calls_shadow < calls_direct, "render mode switch");
+	printf ("COURSE -> GUI -> COURSE: %u GL calls from an unknown state, %u after\n",
+		calls_direct, calls_shadow);
+}
+
+int main (int argc, char **argv) {
+	int steps = argc > 1 ? atoi (argv[1]) : 20000;
+	RedundantCalls ();
+	RandomSequence (steps);
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,250 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Offline tool: packs every file below the data directory into one
+// archive, which the game maps at startup (see src/pack.h for the format).
+//
+//   mkpack [-v] datadir [packfile]
+//
+//   -v  verify only: look up every file of the pack the way the game does
+//       (CAssetPack::Find) and compare it with the loose file
+//
+// The pack file defaults to datadir/data.pack.
+
+#include "pack.h"
+#include "game_config.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+// common.cpp saves the messages to param.config_dir
+TParam param;
+
+struct TFile {
+	string name;	// relative to the data directory
+	size_t offset;
+	size_t size;
+};
+
+static bool ReadFile (const string& path, vector<unsigned char>& data) {
+	ifstream file (path.c_str(), ios_base::in | ios_base::binary);
+	if (!file) return false;
+	file.seekg (0, ios_base::end);
+	streamoff len = file.tellg();
+	if (len < 0) return false;
+	data.resize ((size_t)len);
+	file.seekg (0, ios_base::beg);
+	return len == 0 || file.read (reinterpret_cast<char*>(&data[0]), len);
+}
+
+static void WriteLE (vector<unsigned char>& out, size_t val, int bytes) {
+	for (int i=0; i<bytes; i++)
+		out.push_back ((val >> (i * 8)) & 255);
+}
+
+static size_t ReadLE (const unsigned char *p, int bytes) {
+	size_t val = 0;
+	for (int i=0; i<bytes; i++)
+		val |= (size_t)p[i] << (i * 8);
+	return val;
+}
+
+static bool IsPack (const string& name) {
+	return name.size() > 5 && name.compare (name.size() - 5, 5, ".pack") == 0;
+}
+
+static void CollectFiles (const string& root, const string& rel, vector<TFile>& files) {
+	string dir = rel.empty() ? root : root + "/" + rel;
+	DIR *xdir = opendir (dir.c_str());
+	if (xdir == NULL) {
+		printf ("could not open %s\n", dir.c_str());
+		return;
+	}
+	vector<string> entries;
+	struct dirent *entry;
+	while ((entry = readdir (xdir)) != NULL) {
+		if (entry->d_name[0] != '.') entries.push_back (entry->d_name);
+	}
+	closedir (xdir);
+
+	for (size_t i=0; i<entries.size(); i++) {
+		string name = rel.empty() ? entries[i] : rel + "/" + entries[i];
+		struct stat info;
+		if (stat ((root + "/" + name).c_str(), &info) != 0) continue;
+		if (S_ISDIR (info.st_mode)) {
+			CollectFiles (root, name, files);
+		} else if (S_ISREG (info.st_mode) && !IsPack (entries[i])) {
+			TFile file;
+			file.name = name;
+			file.offset = 0;
+			file.size = 0;
+			files.push_back (file);
+		}
+	}
+}
+
+static bool CompareName (const TFile& a, const TFile& b) {
+	return a.name < b.name;
+}
+
+static int Build (const string& root, const string& packfile) {
+	vector<TFile> files;
+	CollectFiles (root, "", files);
+	sort (files.begin(), files.end(), CompareName);
+
+	size_t indexsize = 16;
+	for (size_t i=0; i<files.size(); i++)
+		indexsize += 10 + files[i].name.size();
+
+	vector<unsigned char> data;
+	size_t offset = indexsize;
+	for (size_t i=0; i<files.size(); i++) {
+		vector<unsigned char> contents;
+		if (!ReadFile (root + "/" + files[i].name, contents)) {
+			printf ("could not read %s\n", files[i].name.c_str());
+			return 1;
+		}
+		while (offset % PACK_ALIGN != 0) {
+			data.push_back (0);
+			offset++;
+		}
+		files[i].offset = offset;
+		files[i].size = contents.size();
+		data.insert (data.end(), contents.begin(), contents.end());
+		offset += contents.size();
+	}
+	if (offset > 0xffffffffUL) {
+		printf ("the data doesn't fit into a pack\n");
+		return 1;
+	}
+
+	vector<unsigned char> index (PACK_MAGIC, PACK_MAGIC + 8);
+	WriteLE (index, files.size(), 4);
+	WriteLE (index, 0, 4);
+	for (size_t i=0; i<files.size(); i++) {
+		WriteLE (index, files[i].offset, 4);
+		WriteLE (index, files[i].size, 4);
+		WriteLE (index, files[i].name.size(), 2);
+		index.insert (index.end(), files[i].name.begin(), files[i].name.end());
+	}
+
+	ofstream out (packfile.c_str(), ios_base::out | ios_base::binary);
+	out.write (reinterpret_cast<const char*>(&index[0]), index.size());
+	if (!data.empty())
+		out.write (reinterpret_cast<const char*>(&data[0]), data.size());
+	if (!out) {
+		printf ("could not write %s\n", packfile.c_str());
+		return 1;
+	}
+	printf ("%u files, %lu bytes in %s\n", (unsigned)files.size(),
+		(unsigned long)offset, packfile.c_str());
+	return 0;
+}
+
+static int Verify (const string& root, const string& packfile) {
+	vector<unsigned char> index;
+	if (!ReadFile (packfile, index) || index.size() < 16
+	        || memcmp (&index[0], PACK_MAGIC, 8) != 0) {
+		printf ("%s is not a pack\n", packfile.c_str());
+		return 1;
+	}
+	vector<string> packed;
+	size_t count = ReadLE (&index[8], 4);
+	size_t pos = 16;
+	for (size_t i=0; i<count; i++) {
+		if (pos + 10 > index.size()) {
+			printf ("truncated index\n");
+			return 1;
+		}
+		size_t namelen = ReadLE (&index[pos + 8], 2);
+		if (pos + 10 + namelen > index.size()) {
+			printf ("truncated index\n");
+			return 1;
+		}
+		packed.push_back (string (reinterpret_cast<const char*>(&index[pos + 10]), namelen));
+		pos += 10 + namelen;
+	}
+
+	// the game's pack, the global one stays closed so that CVFile reads
+	// the loose files
+	CAssetPack pack;
+	if (!pack.Open (packfile, root)) {
+		printf ("%s can't be opened by the game\n", packfile.c_str());
+		return 1;
+	}
+
+	int num_ok = 0;
+	int num_failed = 0;
+	for (size_t i=0; i<packed.size(); i++) {
+		const string& name = packed[i];
+		string path = root + SEP + name;
+		const unsigned char *data;
+		size_t size;
+		CVFile file;
+		if (!pack.Find (path, data, size)) {
+			printf ("NOTFOUND %s\n", name.c_str());
+			num_failed++;
+		} else if (!file.Open (path)) {
+			printf ("MISSING  %s\n", name.c_str());
+			num_failed++;
+		} else if (file.Size() != size
+		           || (size > 0 && memcmp (file.Data(), data, size) != 0)) {
+			printf ("MISMATCH %s\n", name.c_str());
+			num_failed++;
+		} else {
+			num_ok++;
+		}
+	}
+
+	// loose files that the pack doesn't have
+	vector<TFile> files;
+	CollectFiles (root, "", files);
+	sort (packed.begin(), packed.end());
+	for (size_t i=0; i<files.size(); i++) {
+		if (!binary_search (packed.begin(), packed.end(), files[i].name)) {
+			printf ("NOTPACKED %s\n", files[i].name.c_str());
+			num_failed++;
+		}
+	}
+
+	printf ("\n%d verified, %d failed\n", num_ok, num_failed);
+	return num_failed > 0 ? 1 : 0;
+}
+
+int main (int argc, char **argv) {
+	bool verify_only = false;
+	vector<string> args;
+	for (int i=1; i<argc; i++) {
+		if (strcmp (argv[i], "-v") == 0) verify_only = true;
+		else args.push_back (argv[i]);
+	}
+	if (args.empty() || args.size() > 2) {
+		printf ("usage: %s [-v] datadir [packfile]\n", argv[0]);
+		return 2;
+	}
+	string root = args[0];
+	string packfile = args.size() > 1 ? args[1] : root + "/data.pack";
+
+	if (verify_only) return Verify (root, packfile);
+	else return Build (root, packfile);
+}
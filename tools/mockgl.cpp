@@ -0,0 +1,474 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// the GL functions defined here mustn't be renamed by glstats.h
+#define GLSTATS_NO_REDIRECT
+
+#include "mockgl.h"
+#include "winsys.h"
+#include "game_config.h"
+#include <cstring>
+#include <sstream>
+
+TMockState mockgl;
+vector<TMockDraw> mock_draws;
+map<GLuint, TMockTexture> mock_textures;
+vector<unsigned char> mock_framebuffer;
+
+static map<string, unsigned int> calls;
+static unsigned int total_calls = 0;
+
+struct TMockArray {
+	bool enabled;
+	GLint size;
+	GLenum type;
+	GLsizei stride;
+	const GLvoid *pointer;
+};
+static TMockArray vertex_array;
+static TMockArray texcoord_array;
+static GLuint next_buffer = 1;
+static GLuint next_texture = 1;		// not reset, textures can outlive MockReset
+static GLint unpack_alignment = 4;
+static GLint viewport[4];
+
+// --------------------------------------------------------------------
+//				the rest of the game
+// --------------------------------------------------------------------
+
+TParam param;
+TGameData g_game;
+CWinsys Winsys;
+
+CWinsys::CWinsys () {
+	resolution = TScreenRes (800, 600);
+	orient = 0;
+	scale = 1;
+}
+
+// for the tools that link the states of the game, nothing is shown
+TVector2i cursor_pos (0, 0);
+string CWinsys::GetResName (size_t idx) const { return "800 x 600"; }
+void CWinsys::KeyRepeat (bool repeat) {}
+void CWinsys::SetFonttype () {}
+void CWinsys::SwapBuffers () {}
+void CWinsys::SetOrient (int o) { orient = o; }
+void CWinsys::Terminate () { exit (0); }
+void SaveConfigFile () {}
+
+// --------------------------------------------------------------------
+//				state
+// --------------------------------------------------------------------
+
+bool TMockState::IsEnabled (GLenum cap) const {
+	map<GLenum, bool>::const_iterator it = caps.find (cap);
+	return it != caps.end() && it->second;
+}
+
+static void CompareValue (ostringstream& os, const char *name, double a, double b) {
+	if (a != b) os << name << ' ' << a << " != " << b << "; ";
+}
+
+string TMockState::Compare (const TMockState& other) const {
+	ostringstream os;
+	for (map<GLenum, bool>::const_iterator it = caps.begin(); it != caps.end(); ++it)
+		if (it->second != other.IsEnabled (it->first))
+			os << "cap 0x" << hex << it->first << dec << "; ";
+	for (map<GLenum, bool>::const_iterator it = other.caps.begin(); it != other.caps.end(); ++it)
+		if (it->second != IsEnabled (it->first))
+			os << "cap 0x" << hex << it->first << dec << "; ";
+	CompareValue (os, "blend src", blend_src, other.blend_src);
+	CompareValue (os, "blend dst", blend_dst, other.blend_dst);
+	CompareValue (os, "alpha func", alpha_func, other.alpha_func);
+	CompareValue (os, "alpha ref", alpha_ref, other.alpha_ref);
+	CompareValue (os, "depth func", depth_func, other.depth_func);
+	CompareValue (os, "depth mask", depth_mask, other.depth_mask);
+	CompareValue (os, "shade model", shade_model, other.shade_model);
+	for (int i=0; i<4; i++) {
+		CompareValue (os, "ambient/diffuse", amb_diff[i], other.amb_diff[i]);
+		CompareValue (os, "specular", specular[i], other.specular[i]);
+	}
+	CompareValue (os, "shininess", shininess, other.shininess);
+	CompareValue (os, "texture", texture, other.texture);
+	return os.str();
+}
+
+void MockReset () {
+	mockgl.caps.clear();
+	mockgl.caps[GL_DITHER] = true;
+	mockgl.caps[GL_MULTISAMPLE] = true;
+	mockgl.blend_src = GL_ONE;
+	mockgl.blend_dst = GL_ZERO;
+	mockgl.alpha_func = GL_ALWAYS;
+	mockgl.alpha_ref = 0;
+	mockgl.depth_func = GL_LESS;
+	mockgl.depth_mask = GL_TRUE;
+	mockgl.shade_model = GL_SMOOTH;
+	const GLfloat amb_diff[4] = {0.8f, 0.8f, 0.8f, 1};
+	const GLfloat specular[4] = {0, 0, 0, 1};
+	memcpy (mockgl.amb_diff, amb_diff, sizeof(amb_diff));
+	memcpy (mockgl.specular, specular, sizeof(specular));
+	mockgl.shininess = 0;
+	mockgl.texture = 0;
+	memset (&vertex_array, 0, sizeof(vertex_array));
+	memset (&texcoord_array, 0, sizeof(texcoord_array));
+	unpack_alignment = 4;
+	viewport[0] = 0;
+	viewport[1] = 0;
+	viewport[2] = 800;
+	viewport[3] = 600;
+	mock_draws.clear();
+	calls.clear();
+	total_calls = 0;
+}
+
+unsigned int MockCalls () {
+	return total_calls;
+}
+
+unsigned int MockCalls (const string& name) {
+	map<string, unsigned int>::const_iterator it = calls.find (name);
+	return it == calls.end() ? 0 : it->second;
+}
+
+static void Call (const char *name) {
+	calls[name]++;
+	total_calls++;
+}
+
+// --------------------------------------------------------------------
+//				draws
+// --------------------------------------------------------------------
+
+static GLfloat ArrayValue (const TMockArray& a, GLint index, int component) {
+	size_t typesize = a.type == GL_FLOAT ? sizeof(GLfloat)
+		: a.type == GL_SHORT ? sizeof(GLshort) : sizeof(GLbyte);
+	size_t stride = a.stride != 0 ? a.stride : a.size * typesize;
+	const char *p = static_cast<const char*>(a.pointer) + index * stride + component * typesize;
+	switch (a.type) {
+		case GL_FLOAT: return *reinterpret_cast<const GLfloat*>(p);
+		case GL_SHORT: return *reinterpret_cast<const GLshort*>(p);
+		default: return *reinterpret_cast<const GLbyte*>(p);
+	}
+}
+
+static void AddVertex (TMockDraw& draw, GLint index) {
+	for (int c=0; c<3; c++)
+		draw.vertices.push_back (c < vertex_array.size ? ArrayValue (vertex_array, index, c) : 0);
+	if (texcoord_array.enabled)
+		for (int c=0; c<2; c++)
+			draw.texcoords.push_back (ArrayValue (texcoord_array, index, c));
+}
+
+static TMockDraw& NewDraw (GLenum mode) {
+	mock_draws.push_back (TMockDraw());
+	TMockDraw& draw = mock_draws.back();
+	draw.mode = mode;
+	draw.state = mockgl;
+	return draw;
+}
+
+void MockTriangles (const TMockDraw& draw, vector<GLfloat>& out) {
+	size_t count = draw.vertices.size() / 3;
+	bool textured = !draw.texcoords.empty();
+	vector<size_t> order;
+	switch (draw.mode) {
+		case GL_TRIANGLES:
+			for (size_t i=0; i+2<count; i+=3) {
+				order.push_back (i); order.push_back (i+1); order.push_back (i+2);
+			}
+			break;
+		case GL_TRIANGLE_STRIP:
+			for (size_t i=0; i+2<count; i++) {
+				if (i & 1) { order.push_back (i+1); order.push_back (i); }
+				else { order.push_back (i); order.push_back (i+1); }
+				order.push_back (i+2);
+			}
+			break;
+		case GL_TRIANGLE_FAN:
+			for (size_t i=1; i+1<count; i++) {
+				order.push_back (0); order.push_back (i); order.push_back (i+1);
+			}
+			break;
+	}
+	for (size_t i=0; i<order.size(); i++) {
+		const GLfloat *v = &draw.vertices[order[i] * 3];
+		out.insert (out.end(), v, v + 3);
+		if (textured) {
+			const GLfloat *t = &draw.texcoords[order[i] * 2];
+			out.insert (out.end(), t, t + 2);
+		}
+	}
+}
+
+// --------------------------------------------------------------------
+//				GL
+// --------------------------------------------------------------------
+
+void glEnable (GLenum cap) { Call ("glEnable"); mockgl.caps[cap] = true; }
+void glDisable (GLenum cap) { Call ("glDisable"); mockgl.caps[cap] = false; }
+
+GLboolean glIsEnabled (GLenum cap) {
+	Call ("glIsEnabled");
+	return mockgl.IsEnabled (cap) ? GL_TRUE : GL_FALSE;
+}
+
+void glBlendFunc (GLenum sfactor, GLenum dfactor) {
+	Call ("glBlendFunc");
+	mockgl.blend_src = sfactor;
+	mockgl.blend_dst = dfactor;
+}
+
+void glAlphaFunc (GLenum func, GLfloat ref) {
+	Call ("glAlphaFunc");
+	mockgl.alpha_func = func;
+	mockgl.alpha_ref = ref;
+}
+
+void glDepthFunc (GLenum func) { Call ("glDepthFunc"); mockgl.depth_func = func; }
+void glDepthMask (GLboolean flag) { Call ("glDepthMask"); mockgl.depth_mask = flag; }
+void glShadeModel (GLenum mode) { Call ("glShadeModel"); mockgl.shade_model = mode; }
+
+void glMaterialfv (GLenum face, GLenum pname, const GLfloat *params) {
+	Call ("glMaterialfv");
+	if (pname == GL_AMBIENT_AND_DIFFUSE) memcpy (mockgl.amb_diff, params, sizeof(mockgl.amb_diff));
+	else if (pname == GL_SPECULAR) memcpy (mockgl.specular, params, sizeof(mockgl.specular));
+	else if (pname == GL_SHININESS) mockgl.shininess = params[0];
+}
+
+void glMaterialf (GLenum face, GLenum pname, GLfloat param) {
+	Call ("glMaterialf");
+	if (pname == GL_SHININESS) mockgl.shininess = param;
+}
+
+void glColor4f (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+	Call ("glColor4f");
+	// GLES 1 only has GL_AMBIENT_AND_DIFFUSE for the color material
+	if (mockgl.IsEnabled (GL_COLOR_MATERIAL)) {
+		mockgl.amb_diff[0] = red;
+		mockgl.amb_diff[1] = green;
+		mockgl.amb_diff[2] = blue;
+		mockgl.amb_diff[3] = alpha;
+	}
+}
+
+void glColor4ub (GLubyte red, GLubyte green, GLubyte blue, GLubyte alpha) {
+	glColor4f (red / 255.0f, green / 255.0f, blue / 255.0f, alpha / 255.0f);
+}
+
+void glBindTexture (GLenum target, GLuint texture) {
+	Call ("glBindTexture");
+	mockgl.texture = texture;
+}
+
+void glDeleteTextures (GLsizei n, const GLuint *textures) {
+	Call ("glDeleteTextures");
+	for (GLsizei i=0; i<n; i++) {
+		if (textures[i] == mockgl.texture) mockgl.texture = 0;
+		mock_textures.erase (textures[i]);
+	}
+}
+
+void glGetIntegerv (GLenum pname, GLint *data) {
+	Call ("glGetIntegerv");
+	switch (pname) {
+		case GL_BLEND_SRC: *data = mockgl.blend_src; break;
+		case GL_BLEND_DST: *data = mockgl.blend_dst; break;
+		case GL_MAX_TEXTURE_SIZE: *data = 2048; break;
+		case GL_VIEWPORT: memcpy (data, viewport, sizeof(viewport)); break;
+		default: *data = 0; break;
+	}
+}
+
+void glEnableClientState (GLenum array) {
+	Call ("glEnableClientState");
+	if (array == GL_VERTEX_ARRAY) vertex_array.enabled = true;
+	if (array == GL_TEXTURE_COORD_ARRAY) texcoord_array.enabled = true;
+}
+
+void glDisableClientState (GLenum array) {
+	Call ("glDisableClientState");
+	if (array == GL_VERTEX_ARRAY) vertex_array.enabled = false;
+	if (array == GL_TEXTURE_COORD_ARRAY) texcoord_array.enabled = false;
+}
+
+static void SetArray (TMockArray& a, GLint size, GLenum type, GLsizei stride, const void *pointer) {
+	a.size = size;
+	a.type = type;
+	a.stride = stride;
+	a.pointer = pointer;
+}
+
+void glVertexPointer (GLint size, GLenum type, GLsizei stride, const void *pointer) {
+	Call ("glVertexPointer");
+	SetArray (vertex_array, size, type, stride, pointer);
+}
+
+void glTexCoordPointer (GLint size, GLenum type, GLsizei stride, const void *pointer) {
+	Call ("glTexCoordPointer");
+	SetArray (texcoord_array, size, type, stride, pointer);
+}
+
+// the colors are not checked, the font batches only have to link
+void glColorPointer (GLint size, GLenum type, GLsizei stride, const void *pointer) {
+	Call ("glColorPointer");
+}
+
+void glDrawArrays (GLenum mode, GLint first, GLsizei count) {
+	Call ("glDrawArrays");
+	TMockDraw& draw = NewDraw (mode);
+	for (GLint i=0; i<count; i++) AddVertex (draw, first + i);
+}
+
+void glDrawElements (GLenum mode, GLsizei count, GLenum type, const void *indices) {
+	Call ("glDrawElements");
+	TMockDraw& draw = NewDraw (mode);
+	for (GLsizei i=0; i<count; i++) {
+		GLint index = type == GL_UNSIGNED_SHORT
+			? static_cast<const GLushort*>(indices)[i]
+			: static_cast<const GLubyte*>(indices)[i];
+		AddVertex (draw, index);
+	}
+}
+
+// the rest is only counted
+void glClear (GLbitfield mask) { Call ("glClear"); }
+void glClearColor (GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) { Call ("glClearColor"); }
+void glClearStencil (GLint s) { Call ("glClearStencil"); }
+void glStencilFunc (GLenum func, GLint ref, GLuint mask) { Call ("glStencilFunc"); }
+void glStencilOp (GLenum fail, GLenum zfail, GLenum zpass) { Call ("glStencilOp"); }
+void glLightModelf (GLenum pname, GLfloat param) { Call ("glLightModelf"); }
+void glNormal3f (GLfloat nx, GLfloat ny, GLfloat nz) { Call ("glNormal3f"); }
+void glNormalPointer (GLenum type, GLsizei stride, const void *pointer) { Call ("glNormalPointer"); }
+void glLightfv (GLenum light, GLenum pname, const GLfloat *params) { Call ("glLightfv"); }
+void glFogf (GLenum pname, GLfloat param) { Call ("glFogf"); }
+void glFogfv (GLenum pname, const GLfloat *params) { Call ("glFogfv"); }
+void glTexEnvf (GLenum target, GLenum pname, GLfloat param) { Call ("glTexEnvf"); }
+void glHint (GLenum target, GLenum mode) { Call ("glHint"); }
+void glViewport (GLint x, GLint y, GLsizei width, GLsizei height) {
+	Call ("glViewport");
+	viewport[0] = x;
+	viewport[1] = y;
+	viewport[2] = width;
+	viewport[3] = height;
+}
+void glMatrixMode (GLenum mode) { Call ("glMatrixMode"); }
+void glLoadIdentity () { Call ("glLoadIdentity"); }
+void glLoadMatrixf (const GLfloat *m) { Call ("glLoadMatrixf"); }
+void glMultMatrixf (const GLfloat *m) { Call ("glMultMatrixf"); }
+void glPushMatrix () { Call ("glPushMatrix"); }
+void glPopMatrix () { Call ("glPopMatrix"); }
+void glTranslatef (GLfloat x, GLfloat y, GLfloat z) { Call ("glTranslatef"); }
+void glRotatef (GLfloat angle, GLfloat x, GLfloat y, GLfloat z) { Call ("glRotatef"); }
+void glScalef (GLfloat x, GLfloat y, GLfloat z) { Call ("glScalef"); }
+void glOrthof (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) { Call ("glOrthof"); }
+void glFrustumf (GLfloat l, GLfloat r, GLfloat b, GLfloat t, GLfloat n, GLfloat f) { Call ("glFrustumf"); }
+GLenum glGetError () { return GL_NO_ERROR; }
+const GLubyte *glGetString (GLenum name) { return reinterpret_cast<const GLubyte*>("mock"); }
+
+// --------------------------------------------------------------------
+//				textures and pixels
+// --------------------------------------------------------------------
+
+void glGenTextures (GLsizei n, GLuint *textures) {
+	Call ("glGenTextures");
+	for (GLsizei i=0; i<n; i++) {
+		textures[i] = next_texture++;
+		TMockTexture& tex = mock_textures[textures[i]];
+		tex.width = 0;
+		tex.height = 0;
+		tex.format = 0;
+		tex.uploads = 0;
+	}
+}
+
+void glPixelStorei (GLenum pname, GLint param) {
+	Call ("glPixelStorei");
+	if (pname == GL_UNPACK_ALIGNMENT) unpack_alignment = param;
+}
+
+void glTexParameteri (GLenum target, GLenum pname, GLint param) { Call ("glTexParameteri"); }
+void glTexParameterf (GLenum target, GLenum pname, GLfloat param) { Call ("glTexParameterf"); }
+
+void glTexImage2D (GLenum target, GLint level, GLint internalformat, GLsizei width,
+		GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {
+	Call ("glTexImage2D");
+	map<GLuint, TMockTexture>::iterator it = mock_textures.find (mockgl.texture);
+	if (level != 0 || it == mock_textures.end()) return;
+	TMockTexture& tex = it->second;
+	int bpp = 4;
+	if (format == GL_RGB) bpp = 3;
+	else if (format == GL_ALPHA || format == GL_LUMINANCE) bpp = 1;
+	size_t rowbytes = width * bpp;
+	size_t pitch = (rowbytes + unpack_alignment - 1) / unpack_alignment * unpack_alignment;
+	tex.width = width;
+	tex.height = height;
+	tex.format = format;
+	tex.data.clear();
+	for (GLsizei y=0; pixels != NULL && y<height; y++) {
+		const unsigned char *row = static_cast<const unsigned char*>(pixels) + y * pitch;
+		tex.data.insert (tex.data.end(), row, row + rowbytes);
+	}
+	tex.uploads++;
+}
+
+// the glyphs of the fonts, not stored
+void glTexSubImage2D (GLenum target, GLint level, GLint xoffset, GLint yoffset,
+		GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {
+	Call ("glTexSubImage2D");
+}
+
+void glCompressedTexImage2D (GLenum target, GLint level, GLenum internalformat,
+		GLsizei width, GLsizei height, GLint border, GLsizei imageSize, const void *data) {
+	Call ("glCompressedTexImage2D");
+	map<GLuint, TMockTexture>::iterator it = mock_textures.find (mockgl.texture);
+	if (level != 0 || it == mock_textures.end()) return;
+	TMockTexture& tex = it->second;
+	const unsigned char *bytes = static_cast<const unsigned char*>(data);
+	tex.width = width;
+	tex.height = height;
+	tex.format = internalformat;
+	tex.data.assign (bytes, bytes + imageSize);
+	tex.uploads++;
+}
+
+// only GL_RGBA, the rows are never padded
+void glReadPixels (GLint x, GLint y, GLsizei width, GLsizei height,
+		GLenum format, GLenum type, void *pixels) {
+	Call ("glReadPixels");
+	unsigned char *out = static_cast<unsigned char*>(pixels);
+	for (GLsizei row=0; row<height; row++) {
+		for (GLsizei col=0; col<width; col++) {
+			size_t src = ((size_t)(y + row) * viewport[2] + x + col) * 4;
+			for (int c=0; c<4; c++)
+				*out++ = src + c < mock_framebuffer.size() ? mock_framebuffer[src + c] : 0;
+		}
+	}
+}
+
+// --------------------------------------------------------------------
+//				buffers
+// --------------------------------------------------------------------
+
+void glGenBuffers (GLsizei n, GLuint *buffers) {
+	Call ("glGenBuffers");
+	for (GLsizei i=0; i<n; i++) buffers[i] = next_buffer++;
+}
+
+void glDeleteBuffers (GLsizei n, const GLuint *buffers) { Call ("glDeleteBuffers"); }
+void glBindBuffer (GLenum target, GLuint buffer) { Call ("glBindBuffer"); }
+void glBufferData (GLenum target, GLsizeiptr size, const void *data, GLenum usage) { Call ("glBufferData"); }
+GLboolean glIsBuffer (GLuint buffer) { return buffer != 0 && buffer < next_buffer; }
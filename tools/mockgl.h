@@ -0,0 +1,78 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+#ifndef MOCKGL_H
+#define MOCKGL_H
+
+// A stand-in for the GLES 1 library in the tests of the GL code
+// (ogl.cpp, opengles.cpp, textures.cpp). It is linked instead of the
+// driver, keeps the state that the game shadows, counts the calls and
+// records every draw with its vertices and the state it was drawn with,
+// and every texture with its pixels. mockgl.cpp also
+// stubs the parts of the game that ogl.cpp needs (Winsys, param).
+
+#include "bh.h"
+#include <map>
+#include <vector>
+
+struct TMockState {
+	map<GLenum, bool> caps;		// missing means disabled
+	GLenum blend_src, blend_dst;
+	GLenum alpha_func;
+	GLclampf alpha_ref;
+	GLenum depth_func;
+	GLboolean depth_mask;
+	GLenum shade_model;
+	GLfloat amb_diff[4];		// ambient and diffuse are always set together
+	GLfloat specular[4];
+	GLfloat shininess;
+	GLuint texture;
+
+	bool IsEnabled (GLenum cap) const;
+	// the differences to another state, empty if there are none
+	string Compare (const TMockState& other) const;
+};
+
+struct TMockDraw {
+	GLenum mode;
+	vector<GLfloat> vertices;	// x, y, z per vertex, the indices resolved
+	vector<GLfloat> texcoords;	// s, t per vertex, empty without the array
+	TMockState state;
+};
+
+struct TMockTexture {
+	GLsizei width, height;
+	GLenum format;				// GL_RGB, GL_RGBA or GL_ETC1_RGB8_OES
+	vector<unsigned char> data;	// level 0, the rows without padding
+	unsigned int uploads;
+};
+
+extern TMockState mockgl;
+extern vector<TMockDraw> mock_draws;
+extern map<GLuint, TMockTexture> mock_textures;	// generated and not deleted
+
+// what glReadPixels reads: rgba, bottom row first, as big as the viewport
+extern vector<unsigned char> mock_framebuffer;
+
+void MockReset ();			// a new context, no calls and draws
+unsigned int MockCalls ();	// all calls since MockReset
+unsigned int MockCalls (const string& name);
+
+// the triangles of a triangle, strip or fan draw as a triangle list in
+// the winding GL gives them, with s, t after x, y, z when textured
+void MockTriangles (const TMockDraw& draw, vector<GLfloat>& out);
+
+#endif
@@ -0,0 +1,205 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the number conversion in spx.cpp: Str_IntN, Str_FloatN and
+// Str_Vector2/3/4 must give exactly what the istringstream they replaced
+// gave. Every value in the .lst files below the data directory is
+// converted both ways, then random decimals.
+//
+//   numtest [datadir] [count]
+//
+// Exits with 1 if any result differs.
+
+#include "spx.h"
+#include "game_config.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+// common.cpp saves the messages to param.config_dir
+TParam param;
+
+#define MAX_REPORTED 20
+
+static int num_checked = 0;
+static int num_failed = 0;
+
+template<typename T>
+static bool SameBits (const T *a, const T *b, size_t count) {
+	return memcmp (a, b, count * sizeof(T)) == 0;
+}
+
+// the conversions as they were, with the default on failure
+template<typename T>
+static void StreamNumbers (const string& s, T *vals, size_t count, T def) {
+	istringstream is(s);
+	for (size_t i=0; i<count; i++)
+		is >> vals[i];
+	if (is.fail())
+		for (size_t i=0; i<count; i++) vals[i] = def;
+}
+
+static void Failed (const char *what, const string& s) {
+	if (num_failed < MAX_REPORTED)
+		printf ("DIFFERS  %s \"%s\"\n", what, s.c_str());
+	num_failed++;
+}
+
+template<typename T>
+static void CheckVectors (const string& s, T def, const char *what) {
+	T ref[4], got[4];
+	StreamNumbers (s, ref, 2, def);
+	TVector2<T> v2 = Str_Vector2 (s, TVector2<T>(def, def));
+	got[0] = v2.x; got[1] = v2.y;
+	if (!SameBits (ref, got, 2)) Failed (what, s);
+
+	StreamNumbers (s, ref, 3, def);
+	TVector3<T> v3 = Str_Vector3 (s, TVector3<T>(def, def, def));
+	got[0] = v3.x; got[1] = v3.y; got[2] = v3.z;
+	if (!SameBits (ref, got, 3)) Failed (what, s);
+
+	StreamNumbers (s, ref, 4, def);
+	TVector4<T> v4 = Str_Vector4 (s, TVector4<T>(def, def, def, def));
+	got[0] = v4.x; got[1] = v4.y; got[2] = v4.z; got[3] = v4.w;
+	if (!SameBits (ref, got, 4)) Failed (what, s);
+}
+
+static void Check (const string& s) {
+	num_checked++;
+
+	int iref;
+	StreamNumbers (s, &iref, 1, -12345);
+	int ival = Str_IntN (s, -12345);
+	if (ival != iref) Failed ("int", s);
+
+	float fref;
+	StreamNumbers (s, &fref, 1, -12345.f);
+	float fval = Str_FloatN (s, -12345.f);
+	if (!SameBits (&fref, &fval, 1)) Failed ("float", s);
+
+	CheckVectors<ETR_DOUBLE> (s, -12345, "vector");
+	CheckVectors<int> (s, -12345, "int vector");
+}
+
+// every "[tag] value" of every line
+static void CheckList (const string& path) {
+	CSPList list(100000);
+	if (!list.Load (path)) {
+		Failed ("list", path);
+		return;
+	}
+	for (size_t i=0; i<list.Count(); i++) {
+		const string& line = list.Line(i);
+		size_t pos = line.find ('[');
+		while (pos != string::npos) {
+			size_t close = line.find (']', pos);
+			if (close == string::npos) break;
+			size_t next = line.find ('[', close);
+			string value = line.substr (close + 1,
+				next == string::npos ? string::npos : next - close - 1);
+			STrimN (value);
+			Check (value);
+			pos = next;
+		}
+	}
+}
+
+static bool IsList (const string& name) {
+	return name.size() > 4 && name.compare (name.size() - 4, 4, ".lst") == 0;
+}
+
+static int CheckDir (const string& dir) {
+	DIR *xdir = opendir (dir.c_str());
+	if (xdir == NULL) return 0;
+	vector<string> entries;
+	struct dirent *entry;
+	while ((entry = readdir (xdir)) != NULL) {
+		if (entry->d_name[0] != '.') entries.push_back (entry->d_name);
+	}
+	closedir (xdir);
+
+	int lists = 0;
+	for (size_t i=0; i<entries.size(); i++) {
+		string path = dir + "/" + entries[i];
+		struct stat info;
+		if (stat (path.c_str(), &info) != 0) continue;
+		if (S_ISDIR (info.st_mode)) {
+			lists += CheckDir (path);
+		} else if (IsList (entries[i])) {
+			CheckList (path);
+			lists++;
+		}
+	}
+	return lists;
+}
+
+static string RandomDigits (int count) {
+	string s;
+	for (int i=0; i<count; i++)
+		s += (char)('0' + rand () % 10);
+	return s;
+}
+
+// plain decimals of all lengths, and now and then something that the
+// fast path must leave to the stream
+static string RandomNumber () {
+	string s;
+	if (rand () % 8 == 0) s += "  ";
+	switch (rand () % 4) {
+		case 0: s += '-'; break;
+		case 1: if (rand () % 4 == 0) s += '+'; break;
+	}
+	s += RandomDigits (rand () % 9);
+	if (rand () % 4 != 0) {
+		s += '.';
+		s += RandomDigits (rand () % 12);
+	}
+	switch (rand () % 16) {
+		case 0: s += "e-3"; break;
+		case 1: s += "E7"; break;
+		case 2: s += "x"; break;
+		case 3: s += " "; break;
+	}
+	return s;
+}
+
+int main (int argc, char **argv) {
+	string datadir = argc > 1 ? argv[1] : "data";
+	int count = argc > 2 ? atoi (argv[2]) : 200000;
+
+	int lists = CheckDir (datadir);
+	int listvalues = num_checked;
+	printf ("%d values in %d lists\n", listvalues, lists);
+
+	srand (1);
+	for (int i=0; i<count; i++) {
+		string s = RandomNumber ();
+		for (int n=rand () % 4; n>0; n--)
+			s += ' ' + RandomNumber ();
+		Check (s);
+	}
+	printf ("%d random values\n", num_checked - listvalues);
+
+	if (num_failed > 0) {
+		printf ("FAILED, %d differences\n", num_failed);
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,69 @@
+#!/bin/sh
+# Renders a frame of every course in data/courses/courses.lst with the
+# headless build and compares it with a reference image (needs the
+# ImageMagick compare).
+#
+#   make HEADLESS=1
+#   tools/rendertest.sh [-u] [refdir] [frame]
+#
+#   -u  write the reference images instead of comparing
+#
+# The images depend on the GL driver, so the references must come from the
+# same driver as the test (e.g. Mesa llvmpipe). MAX_RMSE sets the allowed
+# normalized difference, default 0.01. Exits with 1 if any course differs.
+
+update=0
+if [ "$1" = "-u" ]; then
+	update=1
+	shift
+fi
+refdir=${1:-render_ref}
+frame=${2:-300}
+max_rmse=${MAX_RMSE:-0.01}
+
+cd "$(dirname "$0")/.." || exit 2
+if [ ! -x ./tuxracer ]; then
+	echo "no ./tuxracer, build it with make HEADLESS=1"
+	exit 2
+fi
+outdir=${TMPDIR:-/tmp}/rendertest.$$
+mkdir -p "$outdir" "$refdir" || exit 2
+
+courses=$(sed -n 's/^\*.*\[dir\] *\([^] [	]*\).*/\1/p' data/courses/courses.lst)
+failed=0
+for course in $courses; do
+	out="$outdir/$course.png"
+	ref="$refdir/$course.png"
+	if ! SDL_AUDIODRIVER=dummy ./tuxracer --render "$course" "$frame" "$out" >/dev/null 2>&1 \
+	        || [ ! -f "$out" ]; then
+		echo "NORENDER $course"
+		failed=$((failed + 1))
+		continue
+	fi
+	if [ $update = 1 ]; then
+		cp "$out" "$ref"
+		echo "written  $ref"
+		continue
+	fi
+	if [ ! -f "$ref" ]; then
+		echo "NOREF    $course"
+		failed=$((failed + 1))
+		continue
+	fi
+	# compare prints "absolute (normalized)" to stderr
+	rmse=$(compare -metric RMSE "$out" "$ref" "$outdir/$course-diff.png" 2>&1 \
+		| sed -n 's/.*(\([0-9.e+-]*\)).*/\1/p')
+	if [ -z "$rmse" ] || awk "BEGIN { exit !($rmse > $max_rmse) }"; then
+		echo "DIFFERS  $course ${rmse:-size}"
+		failed=$((failed + 1))
+	else
+		echo "ok       $course $rmse"
+	fi
+done
+
+if [ $failed -gt 0 ]; then
+	echo "$failed failed, the frames are in $outdir"
+	exit 1
+fi
+rm -rf "$outdir"
+exit 0
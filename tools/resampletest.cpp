@@ -0,0 +1,202 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the box filter that CImage::DecodePng uses to bring images up
+// to power-of-two size. Random images of non-square NPOT sizes are
+// written as png, decoded with needpot and compared with a reference box
+// filter in double precision: each destination pixel is the area weighted
+// mean of the source pixels it covers, with the colors weighted by alpha.
+// Sprites with fully transparent, magenta texels around an opaque white
+// area must not get any magenta at the edges, and power-of-two images
+// must come back unchanged.
+//
+//   resampletest [-v]
+//
+//   -v  print every case
+//
+// Exits with 1 if a case fails.
+
+#include "mockgl.h"
+#include "textures.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define TMP_FILE "resampletest.png"
+#define TOLERANCE 1		// the filter works in float
+
+static bool verbose = false;
+static int num_failed = 0;
+
+struct TCase {
+	int w, h;
+	int depth;
+	int kind;		// 0 random, 1 sprite: magenta transparent around white
+};
+
+static const TCase cases[] = {
+	{ 3, 5, 4, 0 },
+	{ 5, 3, 3, 0 },
+	{ 1, 3, 4, 0 },
+	{ 7, 1, 3, 0 },
+	{ 17, 9, 4, 0 },
+	{ 100, 37, 4, 0 },
+	{ 129, 65, 3, 0 },
+	{ 64, 48, 4, 0 },
+	{ 33, 128, 4, 0 },
+	{ 255, 3, 4, 0 },
+	{ 13, 11, 4, 1 },
+	{ 100, 60, 4, 1 },
+	{ 64, 64, 4, 0 },
+	{ 32, 8, 3, 0 },
+};
+
+static int PowerOfTwo (int n) {
+	int p = 1;
+	while (p < n) p <<= 1;
+	return p;
+}
+
+static void MakeImage (const TCase& c, vector<unsigned char>& pixels) {
+	pixels.resize (c.w * c.h * c.depth);
+	for (int y=0; y<c.h; y++) {
+		for (int x=0; x<c.w; x++) {
+			unsigned char *pix = &pixels[(y * c.w + x) * c.depth];
+			if (c.kind == 1) {
+				bool inside = x > c.w / 4 && x < c.w * 3 / 4 && y > c.h / 4 && y < c.h * 3 / 4;
+				pix[0] = 255;
+				pix[1] = inside ? 255 : 0;
+				pix[2] = 255;
+				pix[3] = inside ? 255 : 0;
+			} else {
+				for (int i=0; i<c.depth; i++) pix[i] = rand () % 256;
+				// some fully transparent and fully opaque texels
+				if (c.depth == 4 && rand () % 4 == 0) pix[3] = rand () % 2 ? 0 : 255;
+			}
+		}
+	}
+}
+
+// the covered part of source pixel j by destination pixel i
+static double Overlap (int i, int j, int n, int dn) {
+	double s = (double)n / dn;
+	double lo = i * s > j ? i * s : j;
+	double hi = (i + 1) * s < j + 1 ? (i + 1) * s : j + 1;
+	return hi > lo ? hi - lo : 0;
+}
+
+// top down, like the png
+static void Reference (const TCase& c, const vector<unsigned char>& src,
+		int dw, int dh, vector<unsigned char>& out) {
+	out.resize (dw * dh * c.depth);
+	double area = ((double)c.w / dw) * ((double)c.h / dh);
+	for (int j=0; j<dh; j++) {
+		for (int i=0; i<dw; i++) {
+			double acc[4] = {0, 0, 0, 0};
+			for (int y=0; y<c.h; y++) {
+				double wy = Overlap (j, y, c.h, dh);
+				if (wy == 0) continue;
+				for (int x=0; x<c.w; x++) {
+					double w = wy * Overlap (i, x, c.w, dw) / area;
+					if (w == 0) continue;
+					const unsigned char *pix = &src[(y * c.w + x) * c.depth];
+					double a = c.depth == 4 ? pix[3] / 255.0 : 1.0;
+					for (int k=0; k<3; k++) acc[k] += w * a * pix[k];
+					if (c.depth == 4) acc[3] += w * pix[3];
+				}
+			}
+			unsigned char *pix = &out[(j * dw + i) * c.depth];
+			double unmul = 1;
+			if (c.depth == 4) unmul = acc[3] > 0 ? 255 / acc[3] : 0;
+			for (int k=0; k<3; k++) pix[k] = (unsigned char)floor (min (acc[k] * unmul, (double)255) + 0.5);
+			if (c.depth == 4) pix[3] = (unsigned char)floor (acc[3] + 0.5);
+		}
+	}
+}
+
+static void RunCase (const TCase& c, bool mirroring) {
+	char name[64];
+	sprintf (name, "%dx%d %s%s%s", c.w, c.h, c.depth == 4 ? "rgba" : "rgb",
+		c.kind == 1 ? " sprite" : "", mirroring ? " mirrored" : "");
+
+	vector<unsigned char> src;
+	MakeImage (c, src);
+	CImage png;
+	png.nx = c.w;
+	png.ny = c.h;
+	png.depth = c.depth;
+	png.pitch = c.w * c.depth;
+	png.data = new unsigned char[src.size()];
+	memcpy (png.data, &src[0], src.size());
+	if (!png.WritePNG (TMP_FILE)) {
+		printf ("FAILED   %s: could not write %s\n", name, TMP_FILE);
+		num_failed++;
+		return;
+	}
+
+	CImage image;
+	bool ok = image.DecodePng (TMP_FILE, mirroring, true);
+	remove (TMP_FILE);
+	int dw = PowerOfTwo (c.w);
+	int dh = PowerOfTwo (c.h);
+	if (!ok || image.nx != c.w || image.ny != c.h || image.depth != c.depth) {
+		printf ("FAILED   %s: decode\n", name);
+		num_failed++;
+		return;
+	}
+
+	vector<unsigned char> expected;
+	if (dw == c.w && dh == c.h) expected = src;		// must be untouched
+	else Reference (c, src, dw, dh, expected);
+
+	int maxdiff = 0;
+	int magenta = 0;
+	for (int j=0; j<dh; j++) {
+		// the decoded rows are bottom up when mirrored
+		const unsigned char *row = image.data + (mirroring ? dh-1-j : j) * image.pitch;
+		for (int i=0; i<dw; i++) {
+			const unsigned char *a = row + i * c.depth;
+			const unsigned char *e = &expected[(j * dw + i) * c.depth];
+			for (int k=0; k<c.depth; k++) {
+				int diff = abs ((int)a[k] - (int)e[k]);
+				if (diff > maxdiff) maxdiff = diff;
+			}
+			if (c.kind == 1 && a[3] > 0 && a[1] != 255) magenta++;
+		}
+	}
+	bool failed = maxdiff > TOLERANCE || magenta > 0;
+	if (failed || verbose)
+		printf ("%s %s -> %dx%d: max difference %d%s\n", failed ? "FAILED  " : "ok      ",
+			name, dw, dh, maxdiff, magenta > 0 ? ", magenta edges" : "");
+	if (failed) num_failed++;
+}
+
+int main (int argc, char **argv) {
+	verbose = argc > 1 && strcmp (argv[1], "-v") == 0;
+	srand (1);
+	size_t count = sizeof(cases) / sizeof(cases[0]);
+	for (size_t i=0; i<count; i++) {
+		RunCase (cases[i], false);
+		RunCase (cases[i], true);
+	}
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("%u images ok\n", (unsigned)count * 2);
+	return 0;
+}
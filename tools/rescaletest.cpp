@@ -0,0 +1,99 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Driver for CResolutionScaler (res_scaler.h) with made up frame times.
+// The modelled frame is fill bound: it takes cost * scale^2 seconds and
+// vsync doesn't let it get shorter than the budget of 60 fps. Each case
+// runs a few thousand frames and checks where the scale ends up.
+//
+//   rescaletest [-v]
+//
+//   -v  print the scale and frame time every 100 frames
+//
+// Exits with 1 if a case fails.
+
+#include "res_scaler.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#define TARGET (1.f / 60)
+#define MIN_SCALE 0.5f
+#define FRAMES 6000
+
+static bool verbose = false;
+
+struct TCase {
+	const char *name;
+	float cost;			// seconds at full scale
+	float later_cost;	// from the middle on, 0 for no change
+	float hitch;		// every 300th frame takes this long, 0 for none
+	float min_result;	// the scale after FRAMES
+	float max_result;
+	int max_changes;	// in the last 2000 frames
+};
+
+static const TCase cases[] = {
+	{ "light scene", 0.012f, 0, 0, 1.f, 1.f, 2 },
+	{ "heavy scene", 0.030f, 0, 0, 0.65f, 0.78f, 12 },
+	{ "slightly over", 0.019f, 0, 0, 0.85f, 0.96f, 12 },
+	{ "too heavy", 0.200f, 0, 0, MIN_SCALE, MIN_SCALE, 0 },
+	{ "light with hitches", 0.012f, 0, 0.5f, 0.95f, 1.f, 12 },
+	{ "heavy with hitches", 0.030f, 0, 0.5f, 0.65f, 0.78f, 12 },
+	{ "getting heavier", 0.012f, 0.030f, 0, 0.65f, 0.78f, 12 },
+	{ "getting lighter", 0.030f, 0.012f, 0, 1.f, 1.f, 12 },
+};
+
+static float FrameTime (float cost, float scale) {
+	float t = cost * scale * scale;
+	return t < TARGET ? TARGET : t;
+}
+
+static bool Run (const TCase& c) {
+	CResolutionScaler scaler;
+	scaler.Init (TARGET, MIN_SCALE, 1.f, 1.f);
+	float scale = scaler.Scale ();
+	int changes = 0;
+	for (int i=0; i<FRAMES; i++) {
+		float cost = c.later_cost > 0 && i >= FRAMES / 2 ? c.later_cost : c.cost;
+		float t = FrameTime (cost, scale);
+		if (c.hitch > 0 && i % 300 == 299) t = c.hitch;
+		float next = scaler.Update (t);
+		if (next != scale && i >= FRAMES - 2000) changes++;
+		scale = next;
+		if (verbose && i % 100 == 0)
+			printf ("  %5d scale %.3f frame %.4f\n", i, scale, t);
+	}
+	bool ok = scale >= c.min_result - 1e-4f && scale <= c.max_result + 1e-4f
+		&& changes <= c.max_changes;
+	printf ("%-20s scale %.3f (%.2f..%.2f), %d changes at the end  %s\n",
+		c.name, scale, c.min_result, c.max_result, changes, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main (int argc, char **argv) {
+	verbose = argc > 1 && strcmp (argv[1], "-v") == 0;
+	int failed = 0;
+	for (size_t i=0; i<sizeof(cases) / sizeof(cases[0]); i++)
+		if (!Run (cases[i])) failed++;
+	if (failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,190 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the screenshots with a fake framebuffer in the mock GL
+// (mockgl.h). Every pixel of the framebuffer holds its own position, so
+// a wrong row order or channel order shows up in the files.
+//
+// - CaptureScreenshot, written by a worker, must give the same bmp file
+//   as the synchronous ReadFrameBuffer_BMP and WriteBMP, bottom row first
+//   with the channels in bgra order.
+// - The png of the frame dump (ConvertPixels and WritePNG, rgb and rgba)
+//   must read back with the top row first and the channels in order.
+//
+//   shottest
+//
+// The files are written to the directory shottest.dir and removed.
+// Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include "textures.h"
+#include "workers.h"
+#include "game_config.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+#define DIR_NAME "shottest.dir"
+#define WIDTH 37	// odd sizes, so a padded row would show
+#define HEIGHT 23
+
+static int num_failed = 0;
+
+static void Check (bool ok, const char *what) {
+	if (!ok) {
+		printf ("FAILED   %s\n", what);
+		num_failed++;
+	}
+}
+
+// the framebuffer is bottom row first, like GL
+static void Pixel (int x, int y, unsigned char *rgba) {
+	rgba[0] = x;
+	rgba[1] = y;
+	rgba[2] = (x * 7 + y * 3) & 255;
+	rgba[3] = 128 + y;
+}
+
+static void FillFramebuffer () {
+	glViewport (0, 0, WIDTH, HEIGHT);
+	mock_framebuffer.resize (WIDTH * HEIGHT * 4);
+	for (int y=0; y<HEIGHT; y++)
+		for (int x=0; x<WIDTH; x++)
+			Pixel (x, y, &mock_framebuffer[(y * WIDTH + x) * 4]);
+}
+
+static bool ReadFile (const string& path, vector<unsigned char>& bytes) {
+	ifstream file (path.c_str(), ios::binary);
+	if (!file) return false;
+	bytes.assign (istreambuf_iterator<char> (file), istreambuf_iterator<char> ());
+	return true;
+}
+
+static unsigned int LittleEndian (const vector<unsigned char>& b, size_t pos, int size) {
+	unsigned int value = 0;
+	for (int i=size-1; i>=0; i--) value = (value << 8) | b[pos + i];
+	return value;
+}
+
+static void CheckBMP (const vector<unsigned char>& bmp) {
+	Check (bmp.size() >= 54 && bmp[0] == 'B' && bmp[1] == 'M', "bmp header");
+	if (num_failed > 0) return;
+	unsigned int offset = LittleEndian (bmp, 10, 4);
+	Check (LittleEndian (bmp, 18, 4) == WIDTH && LittleEndian (bmp, 22, 4) == HEIGHT, "bmp size");
+	Check (LittleEndian (bmp, 28, 2) == 32, "bmp depth");
+	Check (bmp.size() >= offset + WIDTH * HEIGHT * 4, "bmp data");
+	if (num_failed > 0) return;
+
+	int wrong = 0;
+	for (int y=0; y<HEIGHT; y++) {
+		for (int x=0; x<WIDTH; x++) {
+			unsigned char rgba[4];
+			Pixel (x, y, rgba);
+			const unsigned char *p = &bmp[offset + (y * WIDTH + x) * 4];
+			if (p[0] != rgba[2] || p[1] != rgba[1] || p[2] != rgba[0] || p[3] != rgba[3])
+				wrong++;
+		}
+	}
+	Check (wrong == 0, "bmp rows and channels");
+}
+
+// the file that CaptureScreenshot wrote into the empty directory
+static string FindScreenshot () {
+	DIR *dir = opendir (DIR_NAME);
+	if (dir == NULL) return "";
+	string found;
+	struct dirent *entry;
+	while ((entry = readdir (dir)) != NULL)
+		if (entry->d_name[0] != '.') found = string (DIR_NAME) + "/" + entry->d_name;
+	closedir (dir);
+	return found;
+}
+
+static void Screenshot () {
+	param.screenshot_dir = DIR_NAME;
+	Workers.Start (2);
+	unsigned int reads = MockCalls ("glReadPixels");
+	CaptureScreenshot ();
+	Check (MockCalls ("glReadPixels") == reads, "screenshot without request");
+	ScreenshotN ();
+	CaptureScreenshot ();
+	Check (MockCalls ("glReadPixels") == reads + 1, "one read of the framebuffer");
+	Workers.Stop ();	// runs the write
+
+	string path = FindScreenshot ();
+	vector<unsigned char> async, sync;
+	Check (!path.empty() && ReadFile (path, async), "screenshot written");
+	if (!path.empty()) remove (path.c_str());
+	if (async.empty()) return;
+	CheckBMP (async);
+
+	// the synchronous path
+	CImage image;
+	image.ReadFrameBuffer_BMP ();
+	string syncpath = string (DIR_NAME) + "/sync.bmp";
+	Check (image.WriteBMP (syncpath.c_str()) && ReadFile (syncpath, sync), "synchronous bmp written");
+	remove (syncpath.c_str());
+	Check (async == sync, "same file as the synchronous path");
+}
+
+static void FrameDump (int depth) {
+	CImage image;
+	image.ReadFrameBuffer ();
+	image.ConvertPixels (depth, false, true);
+	string path = string (DIR_NAME) + "/dump.png";
+	Check (image.WritePNG (path.c_str()), "png written");
+
+	CImage png;
+	bool ok = png.DecodePng (path.c_str(), false, false);
+	remove (path.c_str());
+	Check (ok && png.nx == WIDTH && png.ny == HEIGHT && png.depth == depth, "png size");
+	if (!ok || png.nx != WIDTH || png.ny != HEIGHT || png.depth != depth) return;
+
+	int wrong = 0;
+	for (int row=0; row<HEIGHT; row++) {
+		const unsigned char *p = png.data + row * png.pitch;
+		for (int x=0; x<WIDTH; x++, p+=depth) {
+			unsigned char rgba[4];
+			Pixel (x, HEIGHT-1-row, rgba);
+			for (int c=0; c<depth; c++)
+				if (p[c] != rgba[c]) wrong++;
+		}
+	}
+	Check (wrong == 0, depth == 4 ? "rgba png rows and channels" : "rgb png rows and channels");
+}
+
+int main () {
+	MockReset ();
+	InvalidateGLState ();
+	mkdir (DIR_NAME, 0755);
+	FillFramebuffer ();
+
+	Screenshot ();
+	FrameDump (3);
+	FrameDump (4);
+	rmdir (DIR_NAME);
+
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
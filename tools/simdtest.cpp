@@ -0,0 +1,142 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test and benchmark of the vectorized matrix code (matrices.h): the 4x4
+// product and TransformPoint/TransformVector of the game are compared with
+// the scalar formulas on random input and timed against them.
+//
+//   simdtest [iterations]
+//
+// Exits with 1 if a result is off by more than float rounding.
+
+#include "mathlib.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <ctime>
+
+#define MAX_ERROR 1e-5
+
+static float Random () {
+	return rand () / (float)RAND_MAX * 2 - 1;
+}
+
+static void RandomMatrix (TMatrix<4, 4>& m) {
+	for (int i=0; i<4; i++)
+		for (int j=0; j<4; j++)
+			m[i][j] = Random ();
+}
+
+static void ScalarProduct (const TMatrix<4, 4>& l, const TMatrix<4, 4>& r, TMatrix<4, 4>& ret) {
+	for (int i=0; i<4; i++)
+		for (int j=0; j<4; j++)
+			ret[j][i] = l[0][i] * r[j][0] + l[1][i] * r[j][1] +
+			            l[2][i] * r[j][2] + l[3][i] * r[j][3];
+}
+
+static TVector3d ScalarTransform (const TMatrix<4, 4>& mat, const TVector3d& v, bool point) {
+	TVector3d r;
+	r.x = v.x * mat[0][0] + v.y * mat[1][0] + v.z * mat[2][0];
+	r.y = v.x * mat[0][1] + v.y * mat[1][1] + v.z * mat[2][1];
+	r.z = v.x * mat[0][2] + v.y * mat[1][2] + v.z * mat[2][2];
+	if (point) {
+		r.x += mat[3][0];
+		r.y += mat[3][1];
+		r.z += mat[3][2];
+	}
+	return r;
+}
+
+static double VecError (const TVector3d& a, const TVector3d& b) {
+	return fabs (a.x - b.x) + fabs (a.y - b.y) + fabs (a.z - b.z);
+}
+
+static double Seconds (clock_t start) {
+	return (double)(clock () - start) / CLOCKS_PER_SEC;
+}
+
+int main (int argc, char **argv) {
+	int iterations = argc > 1 ? atoi (argv[1]) : 1000000;
+#if defined(ETR_SIMD_NEON)
+	printf ("simd: neon\n");
+#elif defined(ETR_SIMD_SSE)
+	printf ("simd: sse\n");
+#else
+	printf ("simd: none, scalar code\n");
+#endif
+
+	// correctness
+	srand (1);
+	double maxerr = 0;
+	for (int n=0; n<100000; n++) {
+		TMatrix<4, 4> a, b, ref;
+		RandomMatrix (a);
+		RandomMatrix (b);
+		TMatrix<4, 4> c = a * b;
+		ScalarProduct (a, b, ref);
+		for (int i=0; i<4; i++)
+			for (int j=0; j<4; j++)
+				maxerr = max (maxerr, (double)fabs (c[i][j] - ref[i][j]));
+
+		TVector3d v (Random () * 100, Random () * 100, Random () * 100);
+		maxerr = max (maxerr, VecError (TransformPoint (a, v), ScalarTransform (a, v, true)) / 100);
+		maxerr = max (maxerr, VecError (TransformVector (a, v), ScalarTransform (a, v, false)) / 100);
+	}
+	printf ("max error %g\n", maxerr);
+
+	// benchmark, the results are summed so nothing is optimized away
+	TMatrix<4, 4> a, b, c;
+	RandomMatrix (a);
+	RandomMatrix (b);
+	TVector3d v (1, 2, 3), sum (0, 0, 0);
+
+	clock_t start = clock ();
+	for (int n=0; n<iterations; n++) {
+		c = a * b;
+		b[3][3] = c[0][0] * 0.5f;
+	}
+	double product = Seconds (start);
+	start = clock ();
+	for (int n=0; n<iterations; n++) {
+		ScalarProduct (a, b, c);
+		b[3][3] = c[0][0] * 0.5f;
+	}
+	double product_ref = Seconds (start);
+
+	start = clock ();
+	for (int n=0; n<iterations; n++) {
+		v.x = n * 0.001f;
+		sum += TransformPoint (a, v);
+	}
+	double transform = Seconds (start);
+	start = clock ();
+	for (int n=0; n<iterations; n++) {
+		v.x = n * 0.001f;
+		sum += ScalarTransform (a, v, true);
+	}
+	double transform_ref = Seconds (start);
+
+	printf ("%d iterations (checksum %g)\n", iterations, sum.x + b[3][3]);
+	printf ("matrix product   %.3fs, scalar %.3fs\n", product, product_ref);
+	printf ("transform point  %.3fs, scalar %.3fs\n", transform, transform_ref);
+
+	if (maxerr > MAX_ERROR) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
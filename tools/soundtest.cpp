@@ -0,0 +1,431 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the sound command queue in audio.cpp against a mock SDL_mixer,
+// which is linked instead of the library and logs every play and halt.
+// First the loads are counted: nothing may be decoded or opened at
+// startup, a sound is decoded on its first play or by the Preload of its
+// group, and PlayTheme opens only the pieces of its theme.
+// A few fixed cases check the rules of the queue (nothing before Update,
+// repeated commands dropped, QueueHaltAll drops what is pending, at most
+// SOUND_QUEUE_SIZE commands). Then random frames of commands are run
+// through the queue and as plain direct Play/Halt/HaltAll calls; after
+// every frame the same looping sounds must be playing on the mixer.
+//
+//   soundtest [datadir] [frames]
+//
+// The sounds of datadir/sounds/sounds.lst and the music of
+// datadir/music/music.lst are registered, the mock only needs the files
+// to exist. Exits with 1 if a check fails.
+
+#include "audio.h"
+#include "spx.h"
+#include "game_config.h"
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+
+// common.cpp saves the messages to param.config_dir
+TParam param;
+
+// --------------------------------------------------------------------
+//				mock SDL_mixer
+// --------------------------------------------------------------------
+
+// more channels than sounds, so a play never finds all of them busy
+#define MOCK_CHANNELS 16
+
+static vector<string> mixlog;
+static vector<Mix_Chunk*> mock_chunks;
+static int next_channel = 0;
+// the looping chunk on each channel, a sound played a finite number of
+// times is taken as finished at once
+static Mix_Chunk *looping[MOCK_CHANNELS];
+static int wav_loads = 0;
+static int mus_loads = 0;
+static int open_musics = 0;			// loaded and not yet freed
+static Mix_Music *playing_music = NULL;
+
+static void Log (const char *what, int a, int b) {
+	char line[64];
+	sprintf (line, "%s %d %d", what, a, b);
+	mixlog.push_back (line);
+}
+
+static int ChunkIdx (Mix_Chunk *chunk) {
+	for (size_t i=0; i<mock_chunks.size(); i++)
+		if (mock_chunks[i] == chunk) return (int)i;
+	return -1;
+}
+
+extern "C" {
+
+int Mix_OpenAudio (int, Uint16, int, int) { return 0; }
+void Mix_CloseAudio () {}
+int Mix_AllocateChannels (int num) { return num; }
+int Mix_QuerySpec (int *freq, Uint16 *format, int *channels) {
+	*freq = 44100;
+	*format = AUDIO_S16SYS;
+	*channels = 2;
+	return 1;
+}
+#ifndef Mix_GetError
+const char *Mix_GetError () { return "mock"; }
+#endif
+
+Mix_Chunk *Mix_LoadWAV_RW (SDL_RWops *src, int freesrc) {
+	if (src == NULL) return NULL;
+	if (freesrc) SDL_RWclose (src);
+	wav_loads++;
+	Mix_Chunk *chunk = new Mix_Chunk;
+	chunk->allocated = 0;
+	chunk->abuf = NULL;
+	chunk->alen = 0;
+	chunk->volume = MIX_MAX_VOLUME;
+	mock_chunks.push_back (chunk);
+	return chunk;
+}
+void Mix_FreeChunk (Mix_Chunk *chunk) { delete chunk; }
+int Mix_VolumeChunk (Mix_Chunk *chunk, int volume) {
+	int old = chunk->volume;
+	if (volume >= 0) chunk->volume = volume;
+	return old;
+}
+
+int Mix_PlayChannelTimed (int channel, Mix_Chunk *chunk, int loops, int) {
+	if (channel < 0) {
+		for (int i=0; i<MOCK_CHANNELS && channel < 0; i++)
+			if (looping[(next_channel + i) % MOCK_CHANNELS] == NULL)
+				channel = (next_channel + i) % MOCK_CHANNELS;
+		if (channel < 0) return -1;
+		next_channel = channel + 1;
+	}
+	Log ("play", ChunkIdx (chunk), loops);
+	looping[channel] = loops < 0 ? chunk : NULL;
+	return channel;
+}
+#ifndef Mix_PlayChannel
+int Mix_PlayChannel (int channel, Mix_Chunk *chunk, int loops) {
+	return Mix_PlayChannelTimed (channel, chunk, loops, -1);
+}
+#endif
+int Mix_HaltChannel (int channel) {
+	Log ("halt", channel, 0);
+	for (int i=0; i<MOCK_CHANNELS; i++)
+		if (channel < 0 || channel == i) looping[i] = NULL;
+	return 0;
+}
+
+// Mix_Music is opaque, any allocation will do
+Mix_Music *Mix_LoadMUS_RW (SDL_RWops *src, int freesrc) {
+	if (src == NULL) return NULL;
+	if (freesrc) SDL_RWclose (src);
+	mus_loads++;
+	open_musics++;
+	return reinterpret_cast<Mix_Music*>(new char);
+}
+void Mix_FreeMusic (Mix_Music *music) {
+	if (music == playing_music) playing_music = NULL;
+	open_musics--;
+	delete reinterpret_cast<char*>(music);
+}
+int Mix_PlayMusic (Mix_Music *music, int) { playing_music = music; return 0; }
+int Mix_HaltMusic () { playing_music = NULL; return 0; }
+int Mix_VolumeMusic (int) { return 0; }
+int Mix_PlayingMusic () { return playing_music != NULL; }
+
+}
+
+// --------------------------------------------------------------------
+
+static int num_failed = 0;
+static size_t num_sounds = 0;
+
+static void Check (bool ok, const char *what) {
+	if (!ok) {
+		printf ("FAILED   %s\n", what);
+		num_failed++;
+	}
+}
+
+// silence, an empty log and the same channels for every case
+static void Reset () {
+	Sound.HaltAll ();
+	mixlog.clear();
+	next_channel = 0;
+}
+
+// the sounds that loop on the mixer, sorted, the channels can differ
+static vector<int> Looping () {
+	vector<int> chunks;
+	for (int i=0; i<MOCK_CHANNELS; i++)
+		if (looping[i] != NULL) chunks.push_back (ChunkIdx (looping[i]));
+	sort (chunks.begin(), chunks.end());
+	return chunks;
+}
+
+// the decodes of the sounds, before the queue tests, so that the chunks
+// are numbered like the sounds: sound 0 is decoded first by its play
+// preloaded: the sounds of the racing group besides sound 0
+static void SoundLoads (size_t preloaded) {
+	Sound.LoadSoundList ();
+	Check (wav_loads == 0, "no sound decoded at startup");
+	printf ("startup: %d sounds decoded\n", wav_loads);
+
+	Sound.Play ((size_t)0, 0);
+	Sound.Play ((size_t)0, 0);
+	Check (wav_loads == 1, "a sound decoded on its first play, once");
+	Sound.Preload ("no_such_group");
+	Check (wav_loads == 1, "nothing decoded for an unknown group");
+
+	Sound.Preload ("racing");
+	int expected = 1 + (int)preloaded;	// sound 0 is not decoded again
+	Check (wav_loads == expected, "the racing sounds decoded by Preload");
+	printf ("after Preload (\"racing\"): %d sounds decoded\n", wav_loads);
+	Sound.Preload ("racing");
+	Check (wav_loads == expected, "no second decode by Preload");
+
+	// the rest on their first play
+	for (size_t id=0; id<num_sounds; id++) Sound.Play (id, 0);
+	Check (mock_chunks.size() == num_sounds && wav_loads == (int)num_sounds, "sounds loaded");
+}
+
+static void MusicLoads (const string& datadir) {
+	param.music_dir = MakePathStr (datadir, "music");
+	Music.LoadMusicList ();
+	Check (mus_loads == 0 && open_musics == 0, "no music opened at startup");
+	printf ("startup: %d music pieces opened\n", mus_loads);
+
+	CSPList list (100);
+	if (!list.Load (param.music_dir, "racing_themes.lst") || list.Count() == 0) {
+		Check (false, "racing_themes.lst");
+		return;
+	}
+	for (size_t i=0; i<list.Count(); i++) {
+		const string& line = list.Line(i);
+		string name = SPStrN (line, "name");
+		vector<string> pieces;
+		pieces.push_back (SPStrN (line, "race", "race_1"));
+		pieces.push_back (SPStrN (line, "wonrace", "wonrace_1"));
+		pieces.push_back (SPStrN (line, "lostrace", "lostrace_1"));
+		sort (pieces.begin(), pieces.end());
+		int distinct = (int)(unique (pieces.begin(), pieces.end()) - pieces.begin());
+
+		int loads = mus_loads;
+		Check (Music.PlayTheme (Music.GetThemeIdx (name), MUS_RACING) && playing_music != NULL,
+			"PlayTheme plays");
+		Check (open_musics == distinct, "only the pieces of the theme open");
+		printf ("after PlayTheme (%s): %d music pieces opened, %d open\n",
+			name.c_str(), mus_loads - loads, open_musics);
+		loads = mus_loads;
+		Music.PlayTheme (Music.GetThemeIdx (name), MUS_WONRACE);
+		Music.PlayTheme (Music.GetThemeIdx (name), MUS_LOSTRACE);
+		Check (mus_loads == loads && open_musics == distinct, "no load at the end of the race");
+	}
+
+	// a piece of no theme, like the music of the menus
+	list.Clear ();
+	string other;
+	if (list.Load (param.music_dir, "music.lst"))
+		for (size_t i=0; i<list.Count() && other.empty(); i++)
+			if (SPStrN (list.Line(i), "name").find ("race") == string::npos
+			        && FileExists (param.music_dir, SPStrN (list.Line(i), "file")))
+				other = SPStrN (list.Line(i), "name");
+	Check (Music.Play (other, -1) && open_musics == 1, "only the played piece open");
+	Music.Halt ();
+	Check (playing_music == NULL, "music halted");
+}
+
+static void FixedCases () {
+	Reset ();
+	Sound.Queue ((size_t)0, 0);
+	Check (mixlog.empty(), "nothing played before Update");
+	Sound.Update ();
+	Check (mixlog.size() == 1 && mixlog[0] == "play 0 0", "play at Update");
+	Sound.Update ();
+	Check (mixlog.size() == 1, "queue empty after Update");
+
+	Reset ();
+	for (int i=0; i<5; i++) Sound.Queue ((size_t)1, 0);
+	Sound.Queue ((size_t)1, 1);
+	Sound.Update ();
+	Check (mixlog.size() == 2, "duplicates dropped");
+
+	// only a repeat of the last command of a sound is dropped
+	Reset ();
+	Sound.Queue ((size_t)1, -1);
+	Sound.QueueHalt (1);
+	Sound.Queue ((size_t)1, -1);
+	Sound.Update ();
+	Check (Looping () == vector<int> (1, 1), "play, halt, play");
+	Reset ();
+	Sound.Play ((size_t)1, -1);
+	Sound.QueueHalt (1);
+	Sound.Queue ((size_t)1, -1);
+	Sound.QueueHalt (1);
+	Sound.Update ();
+	Check (Looping ().empty(), "halt, play, halt");
+
+	Reset ();
+	Sound.Queue ((size_t)0, 0);
+	Sound.QueueHaltAll ();
+	Sound.Queue ((size_t)2, 0);
+	Sound.Update ();
+	Check (mixlog.size() == 2 && mixlog[0] == "halt -1 0" && mixlog[1] == "play 2 0",
+		"QueueHaltAll drops the pending commands");
+
+	Reset ();
+	for (int loop=0; loop<4; loop++)
+		for (size_t id=0; id<num_sounds; id++)
+			Sound.Queue (id, loop);
+	Sound.Update ();
+	size_t expected = num_sounds * 4 < SOUND_QUEUE_SIZE ? num_sounds * 4 : SOUND_QUEUE_SIZE;
+	Check (mixlog.size() == expected, "queue size");
+
+	Reset ();
+	Sound.Queue (num_sounds, 0);
+	Sound.Queue ((size_t)-1, 0);
+	Sound.Queue ("no_such_sound", 0);
+	Sound.QueueHalt (num_sounds);
+	Sound.Update ();
+	Check (mixlog.empty(), "invalid sounds ignored");
+
+	// a looping sound is halted on its channel, only once
+	Reset ();
+	Sound.Queue ((size_t)3, 0);
+	Sound.Queue ((size_t)4, -1);
+	Sound.Update ();
+	Sound.Queue ((size_t)4, -1);
+	Sound.QueueHalt (4);
+	Sound.QueueHalt (4);
+	Sound.Update ();
+	Sound.QueueHalt (4);
+	Sound.Update ();
+	Check (mixlog.size() == 3 && mixlog[1] == "play 4 -1" && mixlog[2] == "halt 1 0",
+		"halt of a looping sound");
+
+	// the queue keeps nothing while the audio is closed
+	Reset ();
+	Audio.IsOpen = false;
+	Sound.Queue ((size_t)0, 0);
+	Audio.IsOpen = true;
+	Sound.Update ();
+	Check (mixlog.empty(), "queue with closed audio");
+}
+
+enum { PLAY, HALT, HALTALL };
+
+struct TCmd {
+	int cmd;
+	size_t id;
+	int loop;
+};
+
+static TCmd RandomCmd () {
+	TCmd c;
+	int r = rand () % 20;
+	c.cmd = r == 0 ? HALTALL : (r < 7 ? HALT : PLAY);
+	c.id = c.cmd == HALTALL ? 0 : rand () % num_sounds;
+	c.loop = c.cmd == PLAY ? rand () % 3 - 1 : 0;
+	return c;
+}
+
+static void RunQueued (const vector<TCmd>& frame) {
+	for (size_t i=0; i<frame.size(); i++) {
+		const TCmd& c = frame[i];
+		switch (c.cmd) {
+			case PLAY: Sound.Queue (c.id, c.loop); break;
+			case HALT: Sound.QueueHalt (c.id); break;
+			case HALTALL: Sound.QueueHaltAll (); break;
+		}
+	}
+	Sound.Update ();
+}
+
+static void RunDirect (const vector<TCmd>& frame) {
+	for (size_t i=0; i<frame.size(); i++) {
+		const TCmd& c = frame[i];
+		switch (c.cmd) {
+			case PLAY: Sound.Play (c.id, c.loop); break;
+			case HALT: Sound.Halt (c.id); break;
+			case HALTALL: Sound.HaltAll (); break;
+		}
+	}
+}
+
+// at most SOUND_QUEUE_SIZE commands per frame, the queue drops the rest
+static void RandomFrames (int frames) {
+	vector<vector<TCmd> > commands (frames);
+	srand (1);
+	for (int f=0; f<frames; f++) {
+		int count = rand () % 4 == 0 ? rand () % (SOUND_QUEUE_SIZE + 1) : rand () % 6;
+		for (int i=0; i<count; i++)
+			commands[f].push_back (RandomCmd ());
+	}
+
+	Reset ();
+	vector<vector<int> > direct;
+	for (int f=0; f<frames; f++) {
+		RunDirect (commands[f]);
+		direct.push_back (Looping ());
+	}
+	size_t direct_calls = mixlog.size();
+
+	Reset ();
+	int differences = 0;
+	for (int f=0; f<frames; f++) {
+		RunQueued (commands[f]);
+		if (Looping () != direct[f] && differences++ < 10)
+			printf ("frame %d: %u sounds looping, %u expected\n",
+				f, (unsigned)Looping ().size(), (unsigned)direct[f].size());
+	}
+	Check (differences == 0, "random frames");
+	printf ("%d random frames: %u mixer calls direct, %u queued\n",
+		frames, (unsigned)direct_calls, (unsigned)mixlog.size());
+}
+
+int main (int argc, char **argv) {
+	string datadir = argc > 1 ? argv[1] : "data";
+	int frames = argc > 2 ? atoi (argv[2]) : 20000;
+
+	param.sounds_dir = MakePathStr (datadir, "sounds");
+	param.sound_volume = 100;
+	Audio.IsOpen = true;
+
+	// the index of CSound is not public, count the list
+	CSPList list (200);
+	size_t preloaded = 0;
+	if (list.Load (param.sounds_dir, "sounds.lst")) num_sounds = list.Count();
+	if (num_sounds < 5) {
+		printf ("FAILED   too few sounds in %s\n", param.sounds_dir.c_str());
+		return 1;
+	}
+	for (size_t i=1; i<num_sounds; i++)
+		if (SPStrN (list.Line(i), "preload") == "racing") preloaded++;
+	printf ("%u sounds, %u more in the racing group\n", (unsigned)num_sounds, (unsigned)preloaded);
+
+	SoundLoads (preloaded);
+	MusicLoads (datadir);
+
+	FixedCases ();
+	RandomFrames (frames);
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
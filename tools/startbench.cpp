@@ -0,0 +1,213 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Headless benchmark of the startup loading, with the mock GL
+// (mockgl.h). The lists of the splash screen are loaded by LoadGameData,
+// the task graph on the worker pool, and by the same loaders one after
+// another in the order the splash screen used before. Every run is a new
+// process, so each one starts from empty lists. The loaded data is
+// written as text and must be the same for both.
+//
+//   startbench [datadir] [runs] [threads]
+//
+// Exits with 1 if the data differs.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include "splash_screen.h"
+#include "workers.h"
+#include "textures.h"
+#include "audio.h"
+#include "course.h"
+#include "env.h"
+#include "credits.h"
+#include "score.h"
+#include "game_ctrl.h"
+#include "game_config.h"
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+
+static double Now () {
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / (double)1000000;	// not a float constant
+}
+
+// the order of CSplashScreen::Loop without the task graph
+static void LoadSerial () {
+	Course.MakeStandardPolyhedrons ();
+	Sound.LoadSoundList ();
+	Credits.LoadCreditList ();
+	Char.LoadCharacterList ();
+	Course.LoadObjectTypes ();
+	Course.LoadTerrainTypes ();
+	Env.LoadEnvironmentList ();
+	Course.LoadCourseList ();
+	Score.LoadHighScore ();
+	Events.LoadEventList ();
+	Players.LoadAvatars ();
+	Players.LoadPlayers ();
+}
+
+static string CourseDir (const TCourse *course) {
+	return course != NULL ? course->dir : "-";
+}
+
+// what the loaders leave behind, as far as it is public
+static string Dump () {
+	ostringstream os;
+	os << "polyhedrons " << Course.PolyArr.size() << '\n';
+	for (size_t i=0; i<Course.ObjTypes.size(); i++) {
+		const TObjectType& o = Course.ObjTypes[i];
+		os << "object " << o.name << ' ' << o.textureFile << ' ' << o.collectable << ' '
+		   << o.collidable << o.drawable << o.reset_point << o.use_normal << ' ' << o.poly << '\n';
+	}
+	for (size_t i=0; i<Course.TerrList.size(); i++) {
+		const TTerrType& t = Course.TerrList[i];
+		os << "terrain " << t.textureFile << ' ' << t.sound << ' ' << t.friction << ' '
+		   << t.depth << ' ' << t.vol_type << ' ' << t.starttex << ' ' << t.tracktex << ' '
+		   << t.stoptex << ' ' << t.particles << t.trackmarks << t.shiny << '\n';
+	}
+	for (size_t i=0; i<Course.CourseList.size(); i++) {
+		const TCourse& c = Course.CourseList[i];
+		os << "course " << c.dir << ' ' << c.name << ' ' << c.author << ' ' << c.env << ' '
+		   << c.music_theme << ' ' << c.size.x << ' ' << c.size.y << ' ' << c.angle << ' '
+		   << c.start.x << ' ' << c.start.y << ' ' << c.use_keyframe << '\n';
+		const TScoreList *list = Score.GetScorelist (i);
+		for (int s=0; list != NULL && s<list->numScores; s++)
+			os << "score " << list->scores[s].player << ' ' << list->scores[s].points << ' '
+			   << list->scores[s].herrings << ' ' << list->scores[s].time << '\n';
+	}
+	for (size_t i=0; i<Char.CharList.size(); i++)
+		os << "character " << Char.CharList[i].name << ' ' << Char.CharList[i].dir << ' '
+		   << Char.CharList[i].type << '\n';
+	for (size_t i=0; i<Events.RaceList.size(); i++) {
+		const TRace& r = Events.RaceList[i];
+		os << "race " << CourseDir (r.course) << ' ' << r.light << ' ' << r.snow << ' '
+		   << r.wind << ' ' << r.music_theme << '\n';
+	}
+	for (size_t i=0; i<Events.CupList.size(); i++) {
+		os << "cup " << Events.CupList[i].cup << ' ' << Events.CupList[i].name;
+		for (size_t r=0; r<Events.CupList[i].races.size(); r++)
+			os << ' ' << CourseDir (Events.CupList[i].races[r]->course);
+		os << '\n';
+	}
+	for (size_t i=0; i<Events.EventList.size(); i++)
+		os << "event " << Events.EventList[i].name << ' ' << Events.EventList[i].cups.size() << '\n';
+	for (size_t i=0; i<Players.numAvatars(); i++)
+		os << "avatar " << Players.GetDirectAvatarName (i) << '\n';
+	for (size_t i=0; i<Players.numPlayers(); i++) {
+		const TPlayer *p = Players.GetPlayer (i);
+		os << "player " << p->name << ' ' << p->funlocked << ' ' << p->character << ' '
+		   << (p->avatar != NULL ? p->avatar->filename : "-") << '\n';
+	}
+	os << "sounds";
+	for (size_t i=0; i<Course.TerrList.size(); i++)
+		os << ' ' << Course.TerrList[i].sound;
+	os << '\n';
+	return os.str();
+}
+
+// one run in a child process, the time and the dump come back in the pipe
+static bool Run (bool graph, int threads, double& seconds, string& dump) {
+	int fd[2];
+	if (pipe (fd) != 0) return false;
+	pid_t pid = fork ();
+	if (pid < 0) return false;
+	if (pid == 0) {
+		close (fd[0]);
+		freopen ("/dev/null", "w", stdout);	// the messages of the loaders
+		Workers.Start (threads);
+		double start = Now ();
+		if (graph) LoadGameData ();
+		else LoadSerial ();
+		double time = Now () - start;
+		Workers.Stop ();
+		string data = Dump ();
+		FILE *out = fdopen (fd[1], "w");
+		fprintf (out, "%.9f\n%s", time, data.c_str());
+		fclose (out);
+		_exit (0);
+	}
+	close (fd[1]);
+	FILE *in = fdopen (fd[0], "r");
+	dump.clear();
+	char buff[4096];
+	bool ok = fgets (buff, sizeof(buff), in) != NULL;
+	if (ok) seconds = atof (buff);
+	size_t n;
+	while ((n = fread (buff, 1, sizeof(buff), in)) > 0)
+		dump.append (buff, n);
+	fclose (in);
+	int status;
+	waitpid (pid, &status, 0);
+	return ok && WIFEXITED (status) && WEXITSTATUS (status) == 0;
+}
+
+int main (int argc, char **argv) {
+	string datadir = argc > 1 ? argv[1] : "data";
+	int runs = argc > 2 ? atoi (argv[2]) : 10;
+	int threads = argc > 3 ? atoi (argv[3]) : 0;
+
+	MockReset ();
+	InvalidateGLState ();
+	param.data_dir = datadir;
+	param.config_dir = datadir;		// players and scores, only read
+	param.obj_dir = datadir + SEP "objects";
+	param.env_dir2 = datadir + SEP "env";
+	param.char_dir = datadir + SEP "char";
+	param.terr_dir = datadir + SEP "terrains";
+	param.tex_dir = datadir + SEP "textures";
+	param.common_course_dir = datadir + SEP "courses";
+	param.sounds_dir = datadir + SEP "sounds";
+	param.player_dir = datadir + SEP "players";
+	param.trans_dir = datadir + SEP "translations";
+
+	string reference;
+	double best[2] = { 1e9, 1e9 };
+	double total[2] = { 0, 0 };
+	int differences = 0;
+	for (int r=0; r<runs; r++) {
+		for (int graph=0; graph<2; graph++) {
+			double seconds;
+			string dump;
+			if (!Run (graph == 1, threads, seconds, dump)) {
+				printf ("FAILED   run %d did not finish\n", r);
+				return 1;
+			}
+			if (reference.empty()) reference = dump;
+			else if (dump != reference) differences++;
+			best[graph] = min (best[graph], seconds);
+			total[graph] += seconds;
+		}
+	}
+
+	printf ("%u lines of loaded data, %d runs\n",
+		(unsigned)count (reference.begin(), reference.end(), '\n'), runs);
+	printf ("serial           best %.1f ms, mean %.1f ms\n", best[0] * 1000, total[0] * 1000 / runs);
+	printf ("task graph       best %.1f ms, mean %.1f ms\n", best[1] * 1000, total[1] * 1000 / runs);
+	if (differences > 0) {
+		printf ("FAILED   %d runs loaded different data\n", differences);
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,220 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the glBegin/glEnd streaming in opengles.cpp against the mock GL
+// (mockgl.h). Random blocks (triangles, strips, fans, lines, with and
+// without texture coordinates) are drawn in batches, with state changes
+// through the shadow in between. What reaches GL must be the same
+// triangles and lines, in the same order and with the same state, as if
+// every block had been drawn on its own at glEnd. A block with more
+// vertices than GLushort indices can address must still come out whole.
+//
+//   streamtest [batches]
+//
+// Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include <cstdio>
+#include <cstdlib>
+
+// a triangle, or a whole line block
+struct TItem {
+	GLenum mode;
+	vector<GLfloat> data;
+	TMockState state;
+};
+
+static vector<TItem> expected;
+static int num_failed = 0;
+static int num_blocks = 0;
+
+static void Check (bool ok, const char *what) {
+	if (!ok) {
+		printf ("FAILED   %s\n", what);
+		num_failed++;
+	}
+}
+
+static bool IsTriangles (GLenum mode) {
+	return mode == GL_TRIANGLES || mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN;
+}
+
+// the items of a draw, triangles one by one
+static void AddItems (const TMockDraw& draw, vector<TItem>& items) {
+	if (!IsTriangles (draw.mode)) {
+		TItem item;
+		item.mode = draw.mode;
+		item.data = draw.vertices;
+		item.data.insert (item.data.end(), draw.texcoords.begin(), draw.texcoords.end());
+		item.state = draw.state;
+		items.push_back (item);
+		return;
+	}
+	vector<GLfloat> tris;
+	MockTriangles (draw, tris);
+	size_t size = draw.texcoords.empty() ? 9 : 15;
+	for (size_t i=0; i+size<=tris.size(); i+=size) {
+		TItem item;
+		item.mode = GL_TRIANGLES;
+		item.data.assign (tris.begin() + i, tris.begin() + i + size);
+		item.state = draw.state;
+		items.push_back (item);
+	}
+}
+
+static GLfloat RandomCoord () {
+	return (rand () % 2001 - 1000) / 100.f;
+}
+
+static const GLenum modes[] = {
+	GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN, GL_LINES, GL_LINE_STRIP
+};
+
+// texture: 0 none, 1 glTexCoord before glVertex, 2 after
+static void DrawBlock (GLenum mode, int count, int texture) {
+	TMockDraw block;
+	block.mode = mode;
+	glBegin (mode);
+	for (int i=0; i<count; i++) {
+		GLfloat v[3] = { RandomCoord (), RandomCoord (), RandomCoord () };
+		GLfloat t[2] = { RandomCoord (), RandomCoord () };
+		if (texture == 1) glTexCoord2f (t[0], t[1]);
+		if (rand () % 4 == 0 && !IsTriangles (mode)) {
+			v[2] = 0;
+			glVertex2f (v[0], v[1]);
+		} else glVertex3f (v[0], v[1], v[2]);
+		if (texture == 2) glTexCoord2f (t[0], t[1]);
+		block.vertices.insert (block.vertices.end(), v, v + 3);
+		if (texture != 0) block.texcoords.insert (block.texcoords.end(), t, t + 2);
+	}
+	block.state = mockgl;
+	glEnd ();
+	AddItems (block, expected);
+	num_blocks++;
+}
+
+static void RandomBlock () {
+	GLenum mode = modes[rand () % (sizeof(modes) / sizeof(modes[0]))];
+	int count = IsTriangles (mode) ? rand () % 13 : 2 + rand () % 8;
+	DrawBlock (mode, count, rand () % 3);
+}
+
+static void RandomStateChange () {
+	switch (rand () % 4) {
+		case 0: GLEnable (GL_BLEND); break;
+		case 1: GLDisable (GL_BLEND); break;
+		case 2: BindTexture (rand () % 3); break;
+		case 3: GLDepthMask (rand () % 2 ? GL_TRUE : GL_FALSE); break;
+	}
+}
+
+static void CompareItems () {
+	vector<TItem> actual;
+	for (size_t i=0; i<mock_draws.size(); i++)
+		AddItems (mock_draws[i], actual);
+	Check (actual.size() == expected.size(), "number of triangles and lines");
+	size_t count = actual.size() < expected.size() ? actual.size() : expected.size();
+	int differences = 0;
+	for (size_t i=0; i<count; i++) {
+		const TItem& a = actual[i];
+		const TItem& e = expected[i];
+		string diff = a.state.Compare (e.state);
+		bool same = a.mode == e.mode && a.data == e.data && diff.empty();
+		if (!same && differences++ < 10)
+			printf ("item %u differs %s\n", (unsigned)i, diff.c_str());
+	}
+	Check (differences == 0, "drawn geometry");
+}
+
+static void RandomBatches (int batches) {
+	MockReset ();
+	InvalidateGLState ();
+	expected.clear();
+	num_blocks = 0;
+	srand (1);
+	for (int b=0; b<batches; b++) {
+		glesBeginBatch ();
+		int blocks = rand () % 20;
+		for (int i=0; i<blocks; i++) {
+			if (rand () % 4 == 0) RandomStateChange ();
+			RandomBlock ();
+		}
+		glesEndBatch ();
+		if (rand () % 4 == 0) RandomBlock ();		// outside of a batch
+	}
+	CompareItems ();
+	printf ("%d blocks drawn with %u draws\n", num_blocks, MockCalls ("glDrawArrays")
+		+ MockCalls ("glDrawElements"));
+}
+
+// more vertices than GLushort indices can address
+static void FullStream () {
+	MockReset ();
+	InvalidateGLState ();
+	expected.clear();
+	glesBeginBatch ();
+	for (int i=0; i<40; i++)
+		DrawBlock (GL_TRIANGLE_STRIP, 2000, 0);
+	glesEndBatch ();
+	CompareItems ();
+	Check (MockCalls ("glDrawElements") == 2, "full stream");
+}
+
+// a block beyond the index range is drawn on its own, in order
+static void OversizedBlock () {
+	MockReset ();
+	InvalidateGLState ();
+	expected.clear();
+	glesBeginBatch ();
+	DrawBlock (GL_TRIANGLES, 6, 0);
+	DrawBlock (GL_TRIANGLE_STRIP, 70000, 1);
+	DrawBlock (GL_TRIANGLES, 6, 0);
+	glesEndBatch ();
+	CompareItems ();
+	Check (MockCalls ("glDrawArrays") == 1 && MockCalls ("glDrawElements") == 2,
+		"oversized block");
+}
+
+// the pending blocks are drawn at the end of the outer batch
+static void NestedBatch () {
+	MockReset ();
+	InvalidateGLState ();
+	expected.clear();
+	glesBeginBatch ();
+	glesBeginBatch ();
+	DrawBlock (GL_TRIANGLES, 6, 1);
+	glesEndBatch ();
+	Check (mock_draws.empty(), "inner batch end");
+	DrawBlock (GL_TRIANGLES, 6, 1);
+	glesEndBatch ();
+	Check (MockCalls ("glDrawElements") == 1, "outer batch end");
+	CompareItems ();
+}
+
+int main (int argc, char **argv) {
+	int batches = argc > 1 ? atoi (argv[1]) : 2000;
+	RandomBatches (batches);
+	FullStream ();
+	OversizedBlock ();
+	NestedBatch ();
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}
@@ -0,0 +1,216 @@
+/* --------------------------------------------------------------------
+EXTREME TUXRACER
+
+Copyright (C) 2010 Extreme Tuxracer Team
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+---------------------------------------------------------------------*/
+
+// Test of the texture residency (CTextureCache) with the mock GL
+// (mockgl.h). A scripted tour of screens binds sets of textures for a
+// few frames each, like the menus and the courses do. A plain LRU model
+// next to it says which textures must still be resident; every Bind must
+// reload exactly the evicted ones, and the bytes, the GL textures and the
+// budget must agree with the model after every frame. Only the textures
+// of the current frame may take the cache over the budget.
+//
+//   texcachetest [screens]
+//
+// The textures are png files written to the current directory and
+// removed at the end. Exits with 1 if a check fails.
+
+#include "mockgl.h"
+#include "ogl.h"
+#include "textures.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define NUM_TEXTURES 16
+#define BUDGET (192 * 1024)
+
+static int num_failed = 0;
+
+static void Check (bool ok, const char *what, int screen) {
+	if (!ok) {
+		printf ("FAILED   %s, screen %d\n", what, screen);
+		num_failed++;
+	}
+}
+
+struct TModelTex {
+	string path;
+	bool mipmap;
+	size_t bytes;
+	bool resident;
+	unsigned int lastuse;
+	unsigned int order;		// of the last use, for the LRU order
+};
+
+static TModelTex model[NUM_TEXTURES];
+static TTexture *textures[NUM_TEXTURES];
+static unsigned int frame = 0;
+static unsigned int uses = 0;
+static size_t budget = BUDGET;
+
+static bool WriteImage (const string& path, int size) {
+	CImage image;
+	image.nx = size;
+	image.ny = size;
+	image.depth = 4;
+	image.pitch = size * 4;
+	image.data = new unsigned char[size * size * 4];
+	for (int i=0; i<size*size*4; i++) image.data[i] = rand () % 256;
+	return image.WritePNG (path.c_str());
+}
+
+static size_t ModelBytes () {
+	size_t bytes = 0;
+	for (int i=0; i<NUM_TEXTURES; i++)
+		if (model[i].resident) bytes += model[i].bytes;
+	return bytes;
+}
+
+// evicts the least recently used textures that were not used in this
+// frame, as long as the total is over the budget
+static void ModelTrim () {
+	for (;;) {
+		if (budget == 0 || ModelBytes () <= budget) return;
+		int lru = -1;
+		for (int i=0; i<NUM_TEXTURES; i++)
+			if (model[i].resident && (lru < 0 || model[i].order < model[lru].order))
+				lru = i;
+		if (lru < 0 || model[lru].lastuse == frame) return;
+		model[lru].resident = false;
+	}
+}
+
+static void ModelBind (int idx) {
+	model[idx].lastuse = frame;
+	model[idx].order = ++uses;
+	if (!model[idx].resident) {
+		model[idx].resident = true;
+		ModelTrim ();
+	}
+}
+
+static int ResidentCount () {
+	int count = 0;
+	for (int i=0; i<NUM_TEXTURES; i++)
+		if (model[i].resident) count++;
+	return count;
+}
+
+static void Bind (int idx, int screen) {
+	unsigned int uploads = MockCalls ("glTexImage2D");
+	bool expected = !model[idx].resident;
+	textures[idx]->Bind ();
+	ModelBind (idx);
+	bool reloaded = MockCalls ("glTexImage2D") != uploads;
+	Check (reloaded == expected, reloaded ? "reload of a resident texture" : "no reload of an evicted texture", screen);
+}
+
+static void EndFrame (int screen) {
+	Check (TexCache.Bytes () == ModelBytes (), "resident bytes", screen);
+	Check ((int)mock_textures.size() == ResidentCount (), "GL textures", screen);
+
+	// over the budget only with what this frame needs
+	size_t needed = 0;
+	for (int i=0; i<NUM_TEXTURES; i++)
+		if (model[i].resident && model[i].lastuse == frame) needed += model[i].bytes;
+	Check (TexCache.Bytes () <= budget || TexCache.Bytes () == needed, "budget", screen);
+
+	// and back under the budget for the next one
+	TexCache.NewFrame ();
+	frame++;
+	ModelTrim ();
+	Check (TexCache.Bytes () == ModelBytes (), "resident bytes at the frame start", screen);
+	Check (TexCache.Bytes () <= budget, "budget at the frame start", screen);
+}
+
+// a screen binds its textures every frame for a while
+static void Screen (const vector<int>& used, int frames, int screen) {
+	for (int f=0; f<frames; f++) {
+		for (size_t i=0; i<used.size(); i++)
+			Bind (used[i], screen);
+		EndFrame (screen);
+	}
+}
+
+static void Tour (int screens) {
+	for (int s=0; s<screens; s++) {
+		vector<int> used;
+		int count = 1 + rand () % 6;
+		for (int i=0; i<count; i++)
+			used.push_back (rand () % NUM_TEXTURES);
+		// now and then a course that needs more than the budget
+		if (rand () % 10 == 0)
+			for (int i=0; i<NUM_TEXTURES; i+=2) used.push_back (i);
+		Screen (used, 1 + rand () % 4, s);
+
+		// and a change of the budget in the options
+		if (rand () % 20 == 0) {
+			budget = rand () % 2 ? BUDGET / 2 : BUDGET;
+			TexCache.SetBudget (budget);
+			ModelTrim ();
+			EndFrame (s);
+		}
+	}
+}
+
+int main (int argc, char **argv) {
+	int screens = argc > 1 ? atoi (argv[1]) : 2000;
+	srand (1);
+	MockReset ();
+	InvalidateGLState ();
+
+	const int sizes[] = { 16, 32, 64, 128 };
+	for (int i=0; i<NUM_TEXTURES; i++) {
+		char name[40];
+		sprintf (name, "texcachetest_%d.png", i);
+		int size = sizes[i % 4];
+		model[i].path = name;
+		model[i].mipmap = i % 3 == 0;
+		model[i].bytes = size * size * 4;
+		if (model[i].mipmap) model[i].bytes = model[i].bytes * 4 / 3;
+		model[i].resident = false;
+		model[i].lastuse = 0;
+		model[i].order = 0;
+		if (!WriteImage (name, size)) {
+			printf ("FAILED   could not write %s\n", name);
+			return 1;
+		}
+		textures[i] = new TTexture;
+		textures[i]->SetSource (name, model[i].mipmap, false);
+	}
+	TexCache.SetBudget (budget);
+
+	// nothing is loaded before the first Bind
+	Check (mock_textures.empty() && TexCache.Bytes () == 0, "loaded before Bind", -1);
+
+	Tour (screens);
+	unsigned int uploads = MockCalls ("glTexImage2D");
+
+	for (int i=0; i<NUM_TEXTURES; i++) {
+		delete textures[i];
+		remove (model[i].path.c_str());
+	}
+	Check (TexCache.Bytes () == 0 && mock_textures.empty(), "textures freed", -1);
+
+	printf ("%d screens, %u frames, %u uploads of %d textures\n",
+		screens, frame, uploads, NUM_TEXTURES);
+	if (num_failed > 0) {
+		printf ("FAILED\n");
+		return 1;
+	}
+	printf ("ok\n");
+	return 0;
+}